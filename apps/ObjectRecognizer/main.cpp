@@ -55,6 +55,8 @@ main (int argc, char ** argv)
     v4r::apps::ObjectRecognizer<PT> recognizer (param);
     recognizer.initialize(to_pass_further);
 
+    v4r::TraceStatistics trace_stats;
+
     std::vector< std::string> sub_folder_names = v4r::io::getFoldersInDirectory( test_dir );
     if(sub_folder_names.empty()) sub_folder_names.push_back("");
 
@@ -79,6 +81,7 @@ main (int argc, char ** argv)
 
             std::vector<v4r::ObjectHypothesesGroup > generated_object_hypotheses = recognizer.recognize(cloud);
             std::vector<std::pair<std::string, float> > elapsed_time = recognizer.getElapsedTimes();
+            trace_stats.add( *recognizer.getTraceContext() );
 
             if ( !out_dir.empty() )  // write results to disk (for each verified hypothesis add a row in the text file with object name, dummy confidence value and object pose in row-major order)
             {
@@ -135,8 +138,15 @@ main (int argc, char ** argv)
                 for( const std::pair<std::string,float> &t : elapsed_time)
                     f_verified << t.second << " " << t.first << std::endl;
                 f_verified.close();
+
+                std::string out_path_trace = out_path.string();
+                boost::replace_last(out_path_trace, ".anno", ".trace.json");
+                recognizer.getTraceContext()->saveChromeTrace( out_path_trace );
             }
         }
     }
+
+    std::cout << "Computation time statistics over all test views:" << std::endl;
+    trace_stats.print( std::cout );
 }
 
@@ -26,6 +26,7 @@
 #include <v4r/apps/ObjectRecognizerParameter.h>
 #include <v4r/apps/visualization.h>
 #include <v4r/common/normals.h>
+#include <v4r/common/trace.h>
 #include <v4r/core/macros.h>
 #include <v4r/io/filesystem.h>
 #include <v4r/recognition/local_recognition_pipeline.h>
@@ -86,7 +87,7 @@ private:
 
     typename pcl::PointCloud<PointT>::Ptr registered_scene_cloud_;  ///< registered point cloud of all processed input clouds in common camera reference frame
 
-    std::vector<std::pair<std::string, float> > elapsed_time_; ///< measurements of computation times for various components
+    TraceContext::Ptr trace_; ///< measurements of computation times and counters for various components of the last call
 
 
 public:
@@ -94,7 +95,8 @@ public:
     ObjectRecognizer(const ObjectRecognizerParameter &p = ObjectRecognizerParameter() ) :
         visualize_ (false),
         skip_verification_(false),
-        param_(p)
+        param_(p),
+        trace_ (new TraceContext)
     {}
 
     /**
@@ -156,7 +158,17 @@ public:
     std::vector<std::pair<std::string, float> >
     getElapsedTimes() const
     {
-        return elapsed_time_;
+        return trace_->getElapsedTimes();
+    }
+
+    /**
+     * @brief getTraceContext
+     * @return all timed spans and counters of the last call of recognize() (e.g. to save them as Chrome trace)
+     */
+    TraceContext::ConstPtr
+    getTraceContext() const
+    {
+        return trace_;
     }
 
     /**
@@ -101,6 +101,10 @@ public:
     size_t sift_knn_; ///< only used if greater 0. Otherwise value from xml file will be used
     size_t shot_knn_; ///< only used if greater 0. Otherwise value from xml file will be used
 
+    std::vector<int> model_resolutions_mm_; ///< additional resolutions (in millimeter) at which the voxelized object models are precomputed when loading the model database. Resolutions queried by the configured recognizer itself are added automatically (5 mm for pose refinement if verification is skipped, 3 mm for visualization; verification uses the full model resolution)
+    bool cache_voxelized_models_; ///< if true, precomputed voxelized object models are stored in (and reloaded from) the model directories (3D_model_voxelized_<res>mm.pcd)
+    size_t view_cache_size_mb_; ///< memory budget (in megabyte) for keeping the point clouds of the training views in memory once loaded from disk (0 = always load from disk)
+
     ObjectRecognizerParameter()
         :
           hv_config_xml_ ("cfg/hv_config.xml" ),
@@ -135,7 +139,10 @@ public:
           max_views_ (3),
           icp_iterations_(0),
           sift_knn_ (0),
-          shot_knn_ (0)
+          shot_knn_ (0),
+          model_resolutions_mm_ ( ),
+          cache_voxelized_models_ (false),
+          view_cache_size_mb_ (256)
     {}
 
     void
@@ -236,6 +243,9 @@ public:
                 ("or_icp_iterations", po::value<size_t>(&icp_iterations_)->default_value(icp_iterations_), "ICP iterations. Only used if hypotheses are not verified. Otherwise ICP is done inside HV")
                 ("or_sift_knn", po::value<size_t>(&sift_knn_)->default_value(sift_knn_), "knn for SIFT. only used if greater 0. Otherwise value from xml file will be used")
                 ("or_shot_knn", po::value<size_t>(&shot_knn_)->default_value(shot_knn_), "knn for SHOT. only used if greater 0. Otherwise value from xml file will be used")
+                ("or_model_resolutions_mm", po::value<std::vector<int> >(&model_resolutions_mm_)->multitoken(), "additional resolutions (in millimeter) at which the voxelized object models are precomputed when loading the model database")
+                ("or_cache_voxelized_models", po::value<bool>(&cache_voxelized_models_)->default_value(cache_voxelized_models_), "if true, precomputed voxelized object models are stored in (and reloaded from) the model directories")
+                ("or_view_cache_size_mb", po::value<size_t>(&view_cache_size_mb_)->default_value(view_cache_size_mb_), "memory budget (in megabyte) for keeping the point clouds of the training views in memory once loaded from disk (0 = always load from disk)")
                 ;
         po::variables_map vm;
         po::parsed_options parsed = po::command_line_parser(command_line_arguments).options(desc).allow_unregistered().run();
@@ -279,6 +289,9 @@ private:
                 & BOOST_SERIALIZATION_NVP(use_multiview_with_kp_correspondence_transfer_)
                 & BOOST_SERIALIZATION_NVP(use_change_detection_)
                 & BOOST_SERIALIZATION_NVP(max_views_)
+                & BOOST_SERIALIZATION_NVP(model_resolutions_mm_)
+                & BOOST_SERIALIZATION_NVP(cache_voxelized_models_)
+                & BOOST_SERIALIZATION_NVP(view_cache_size_mb_)
                 ;
     }
 };
@@ -1,5 +1,6 @@
 #include <v4r/apps/ObjectRecognizer.h>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 
@@ -107,7 +108,18 @@ void ObjectRecognizer<PointT>::initialize(const std::vector<std::string> &comman
 
 
     // ==== Fill object model database ==== ( assumes each object is in a seperate folder named after the object and contains and "views" folder with the training views of the object)
-    model_database_.reset ( new Source<PointT> (models_dir_) );
+    typename PointCloudCache<PointT>::Ptr view_cache (new PointCloudCache<PointT> ( param_.view_cache_size_mb_ * 1024 * 1024 ) );
+    model_database_.reset ( new Source<PointT> (models_dir_, false, view_cache) );
+
+    // voxelized models queried by this configuration (hypotheses verification uses the full model resolution)
+    std::vector<int> model_resolutions_mm = param_.model_resolutions_mm_;
+    if( skip_verification_ && param_.icp_iterations_ )
+        model_resolutions_mm.push_back( 5 );    // pose refinement
+    if( visualize_ )
+        model_resolutions_mm.push_back( 3 );    // see ObjectRecognitionVisualizer
+    std::sort( model_resolutions_mm.begin(), model_resolutions_mm.end() );
+    model_resolutions_mm.erase( std::unique( model_resolutions_mm.begin(), model_resolutions_mm.end() ), model_resolutions_mm.end() );
+    model_database_->precomputeVoxelizedModels( model_resolutions_mm, param_.cache_voxelized_models_ );
 
     normal_estimator_ = v4r::initNormalEstimator<PointT> ( param_.normal_computation_method_, to_pass_further );
 
@@ -355,34 +367,30 @@ ObjectRecognizer<PointT>::recognize(const typename pcl::PointCloud<PointT>::Cons
 
     std::vector<ObjectHypothesesGroup> generated_object_hypotheses;
 
-    elapsed_time_.clear();
+    trace_.reset( new TraceContext );
+    mrec_->setTraceContext( trace_ );
+    if( hv_ )
+        hv_->setTraceContext( trace_ );
 
     pcl::PointCloud<pcl::Normal>::Ptr normals;
     if( mrec_->needNormals() || hv_ )
     {
-        pcl::StopWatch t; const std::string time_desc ("Computing normals");
+        TraceSpan t(trace_, "Computing normals");
         normal_estimator_->setInputCloud( processed_cloud );
         normals = normal_estimator_->compute();
         mrec_->setSceneNormals( normals );
-        float time = t.getTime();
-        VLOG(1) << time_desc << " took " << time << " ms.";
-        elapsed_time_.push_back( std::pair<std::string,float>(time_desc, time) );
     }
 
     Eigen::Vector4f support_plane;
     if(param_.remove_planes_)
     {
-        pcl::StopWatch t; const std::string time_desc ("Removing planes");
+        TraceSpan t(trace_, "Removing planes");
 
         cloud_segmenter_->setNormals( normals );
         cloud_segmenter_->segment( processed_cloud );
         processed_cloud = cloud_segmenter_->getProcessedCloud();
         support_plane = cloud_segmenter_->getSelectedPlane();
         mrec_->setTablePlane( support_plane );
-
-        float time = t.getTime();
-        VLOG(1) << time_desc << " took " << time << " ms.";
-        elapsed_time_.push_back( std::pair<std::string,float>(time_desc, time) );
     }
 
     // ==== FILTER POINTS BASED ON DISTANCE =====
@@ -393,17 +401,11 @@ ObjectRecognizer<PointT>::recognize(const typename pcl::PointCloud<PointT>::Cons
     }
 
     {
-        pcl::StopWatch t; const std::string time_desc ("Generation of object hypotheses");
+        TraceSpan t(trace_, "Generation of object hypotheses");
 
         mrec_->setInputCloud ( processed_cloud );
         mrec_->recognize();
         generated_object_hypotheses = mrec_->getObjectHypothesis();
-
-        float time = t.getTime();
-        VLOG(1) << time_desc << " took " << time << " ms.";
-        elapsed_time_.push_back( std::pair<std::string,float>(time_desc, time) );
-        std::vector<std::pair<std::string,float> > elapsed_times_rec = mrec_->getElapsedTimes();
-        elapsed_time_.insert( elapsed_time_.end(), elapsed_times_rec.begin(), elapsed_times_rec.end() );
     }
 
 //    if(param_.icp_iterations_)
@@ -472,15 +474,12 @@ ObjectRecognizer<PointT>::recognize(const typename pcl::PointCloud<PointT>::Cons
             v.cloud_normals_ = normals;
 
             {
-                pcl::StopWatch t; const std::string time_desc ("Computing noise model");
+                TraceSpan t(trace_, "Computing noise model");
                 NguyenNoiseModel<PointT> nm (nm_param);
                 nm.setInputCloud( processed_cloud );
                 nm.setInputNormals( normals );
                 nm.compute();
                 v.pt_properties_ = nm.getPointProperties();
-                float time = t.getTime();
-                VLOG(1) << time_desc << " took " << time << " ms.";
-                elapsed_time_.push_back( std::pair<std::string,float>(time_desc, time) );
             }
 
 
@@ -489,7 +488,7 @@ ObjectRecognizer<PointT>::recognize(const typename pcl::PointCloud<PointT>::Cons
 
             if ( param_.use_change_detection_ && !views_.empty())
             {
-                pcl::StopWatch t; const std::string time_desc ("Change detection");
+                TraceSpan t(trace_, "Change detection");
                 detectChanges(v);
 
                 typename pcl::PointCloud<PointT>::Ptr removed_points_cumulative(new pcl::PointCloud<PointT>(*v.removed_points_));
@@ -540,10 +539,6 @@ ObjectRecognizer<PointT>::recognize(const typename pcl::PointCloud<PointT>::Cons
                         LOG(INFO) << "Points removed in view " << v_id << " by change detection: " << vv.processed_cloud_->points.size() - preserved_indices.size() << ".";
                     }
                 }
-
-                float time = t.getTime();
-                VLOG(1) << time_desc << " took " << time << " ms.";
-                elapsed_time_.push_back( std::pair<std::string,float>(time_desc, time) );
             }
 
 
@@ -568,7 +563,7 @@ ObjectRecognizer<PointT>::recognize(const typename pcl::PointCloud<PointT>::Cons
             }
 
             {
-                pcl::StopWatch t; const std::string time_desc ("Noise model based cloud integration");
+                TraceSpan t(trace_, "Noise model based cloud integration");
                 registered_scene_cloud_.reset(new pcl::PointCloud<PointT>);
                 NMBasedCloudIntegration<PointT> nmIntegration (nm_int_param);
                 nmIntegration.setInputClouds( processed_views );
@@ -577,10 +572,6 @@ ObjectRecognizer<PointT>::recognize(const typename pcl::PointCloud<PointT>::Cons
                 nmIntegration.setInputNormals( views_normals );
                 nmIntegration.compute(registered_scene_cloud_); // is in global reference frame
                 nmIntegration.getOutputNormals( normals );
-
-                float time = t.getTime();
-                VLOG(1) << time_desc << " took " << time << " ms.";
-                elapsed_time_.push_back( std::pair<std::string,float>(time_desc, time) );
             }
 
 //            static pcl::visualization::PCLVisualizer vis ("final registration");
@@ -628,14 +619,10 @@ ObjectRecognizer<PointT>::recognize(const typename pcl::PointCloud<PointT>::Cons
             hv_->setNormals( normals );
         }
 
-        pcl::StopWatch t; const std::string time_desc ("Verification of object hypotheses");
-        hv_->verify();
-        float time = t.getTime();
-        VLOG(1) << time_desc << " took " << time << " ms.";
-        elapsed_time_.push_back( std::pair<std::string,float>(time_desc, time) );
-
-        std::vector<std::pair<std::string, float> > hv_elapsed_times = hv_->getElapsedTimes();
-        elapsed_time_.insert(elapsed_time_.end(), hv_elapsed_times.begin(), hv_elapsed_times.end());
+        {
+            TraceSpan t(trace_, "Verification of object hypotheses");
+            hv_->verify();
+        }
     }
 
 
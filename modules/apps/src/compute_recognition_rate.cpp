@@ -676,12 +676,12 @@ RecognitionEvaluator::compute_recognition_rate (size_t &total_tp, size_t &total_
             std::string line;
             while (std::getline(time_f, line))
             {
-                size_t elapsed_time;
-                std::istringstream iss(line);
-                iss >> elapsed_time;
-                std::stringstream elapsed_time_ss; elapsed_time_ss << elapsed_time;
+                const size_t separator = line.find(' ');
+                if( separator == std::string::npos )
+                    continue;
 
-                const std::string time_description = line.substr( elapsed_time_ss.str().length() + 1 );
+                const size_t elapsed_time = static_cast<size_t>( std::atof( line.substr(0, separator).c_str() ) );
+                const std::string time_description = line.substr( separator + 1 );
                 time_measurements[time_description] = elapsed_time;
             }
             time_f.close();
@@ -0,0 +1,86 @@
+/******************************************************************************
+ * Copyright (c) 2017, Vision4Robotics group, TU Vienna
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+#ifndef KP_TSF_SURFEL_CLOUD_SOA_HH
+#define KP_TSF_SURFEL_CLOUD_SOA_HH
+
+#include <vector>
+#include <Eigen/Dense>
+#include <Eigen/StdVector>
+#include <boost/shared_ptr.hpp>
+#include <v4r/common/impl/DataMatrix2D.hpp>
+#include <v4r/camera_tracking_and_mapping/Surfel.hh>
+#include <v4r/core/macros.h>
+
+namespace v4r
+{
+
+
+
+/**
+ * @brief The SurfelCloudSoA class stores an organized surfel cloud as structure of arrays, i.e. one (aligned) plane per
+ * component and 8-bit colour channels. Kernels streaming over single components (integration, normals, radius) touch
+ * only the planes they need and can be vectorized.
+ */
+class V4R_EXPORTS SurfelCloudSoA
+{
+public:
+  typedef std::vector<float, Eigen::aligned_allocator<float> > Plane;
+  typedef std::vector<unsigned char> Plane8U;
+
+  int rows, cols;
+  Plane x, y, z;         /// point
+  Plane nx, ny, nz;      /// normal
+  Plane weight;
+  Plane radius;
+  Plane8U r, g, b;
+
+  SurfelCloudSoA() : rows(0), cols(0) {}
+  SurfelCloudSoA(const v4r::DataMatrix2D<Surfel> &sf_cloud) : rows(0), cols(0) { fromSurfels(sf_cloud); }
+
+  void resize(const int _rows, const int _cols);
+  void clear();
+
+  inline int size() const { return rows*cols; }
+  inline bool empty() const { return rows*cols==0; }
+  inline int GetIdx(const int row, const int col) const { return row*cols+col; }
+  inline bool isNaN(const int idx) const { return std::isnan(x[idx]) || std::isnan(y[idx]) || std::isnan(z[idx]); }
+
+  Surfel getSurfel(const int idx) const;
+  void setSurfel(const int idx, const Surfel &s);
+
+  void fromSurfels(const v4r::DataMatrix2D<Surfel> &sf_cloud);
+  void toSurfels(v4r::DataMatrix2D<Surfel> &sf_cloud) const;
+
+  typedef boost::shared_ptr< ::v4r::SurfelCloudSoA> Ptr;
+  typedef boost::shared_ptr< ::v4r::SurfelCloudSoA const> ConstPtr;
+};
+
+
+
+/*************************** INLINE METHODES **************************/
+
+} //--END--
+
+#endif
+
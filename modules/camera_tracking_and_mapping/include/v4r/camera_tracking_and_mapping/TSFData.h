@@ -36,10 +36,13 @@
 #include <Eigen/Dense>
 #include <opencv2/core/core.hpp>
 #include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/shared_ptr.hpp>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 #include <v4r/common/impl/DataMatrix2D.hpp> 
 #include <v4r/camera_tracking_and_mapping/Surfel.hh>
+#include <v4r/camera_tracking_and_mapping/SurfelCloudSoA.hh>
 #include <v4r/camera_tracking_and_mapping/TSFFrame.hh>
 #include <queue>
 #include <v4r/core/macros.h>
@@ -56,6 +59,9 @@ class V4R_EXPORTS TSFData
 {
 public:
   boost::mutex mtx_shm;
+  boost::condition_variable cnd_new_frame;     /// notified if a new frame (cloud, timestamp, need_init) is available
+  boost::condition_variable cnd_filt_cloud;    /// notified if the filtered cloud has been updated
+  boost::condition_variable cnd_map_frames;    /// notified if a new keyframe has been pushed to map_frames
 
   //// -> track (tf), -> init-tracking, -> integrate cloud
 
@@ -65,7 +71,7 @@ public:
 
   cv::Mat image;
   cv::Mat prev_gray, gray;
-  pcl::PointCloud<pcl::PointXYZRGB> cloud;  ///// new cloud
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud;  ///// new cloud (published clouds are not modified, a new frame is exchanged by pointer)
   uint64_t timestamp;
 
   std::vector<cv::Point2f> points[2];
@@ -73,7 +79,7 @@ public:
   Eigen::Matrix4f pose;      /// global pose of the current frame (depth, gray, points[1], ....)
   bool have_pose;
 
-  v4r::DataMatrix2D<Surfel>::Ptr filt_cloud;
+  SurfelCloudSoA::Ptr filt_cloud;  /// published snapshot of the filtered cloud, do not modify in place
   Eigen::Matrix4f filt_pose;
   uint64_t filt_timestamp;
   uint64_t kf_timestamp;
@@ -94,6 +100,9 @@ public:
 
   static void convert(const v4r::DataMatrix2D<v4r::Surfel> &sf_cloud, pcl::PointCloud<pcl::PointXYZRGBNormal> &cloud, const double &thr_weight=-1000000, const double &thr_delta_angle=180. );
   static void convert(const v4r::DataMatrix2D<v4r::Surfel> &sf_cloud, cv::Mat &image);
+  static void convert(const v4r::SurfelCloudSoA &sf_cloud, pcl::PointCloud<pcl::PointXYZRGBNormal> &cloud, const double &thr_weight=-1000000, const double &thr_delta_angle=180. );
+  static void convert(const v4r::SurfelCloudSoA &sf_cloud, pcl::PointCloud<pcl::PointXYZRGB> &cloud);
+  static void convert(const v4r::SurfelCloudSoA &sf_cloud, cv::Mat &image);
 };
 
 
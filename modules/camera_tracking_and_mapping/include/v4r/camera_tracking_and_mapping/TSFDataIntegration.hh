@@ -48,6 +48,7 @@
 #include <boost/shared_ptr.hpp>
 #include <v4r/common/impl/DataMatrix2D.hpp>
 #include <v4r/camera_tracking_and_mapping/TSFData.h>
+#include <v4r/camera_tracking_and_mapping/SurfelCloudSoA.hh>
 #include <v4r/camera_tracking_and_mapping/OcclusionClustering.hh>
 #include <v4r/core/macros.h>
 
@@ -115,7 +116,7 @@ private:
   void operate();
 
   bool selectFrame(const Eigen::Matrix4f &pose0, const Eigen::Matrix4f &pose1);
-  void integrateData(const pcl::PointCloud<pcl::PointXYZRGB> &cloud, const Eigen::Matrix4f &pose, const Eigen::Matrix4f &filt_pose, v4r::DataMatrix2D<Surfel> &filt_cloud);
+  void integrateData(const pcl::PointCloud<pcl::PointXYZRGB> &cloud, const Eigen::Matrix4f &pose, const Eigen::Matrix4f &filt_pose, const SurfelCloudSoA &filt_cloud, SurfelCloudSoA &new_filt_cloud);
   inline float sqr(const float &d) {return d*d;}
 
 
@@ -137,9 +138,12 @@ public:
   void setData(TSFData *_data) { data = _data; }
 
   void initCloud(const pcl::PointCloud<pcl::PointXYZRGB> &cloud, v4r::DataMatrix2D<Surfel> &sf_cloud);
+  void initCloud(const pcl::PointCloud<pcl::PointXYZRGB> &cloud, SurfelCloudSoA &sf_cloud);
 
   static void computeRadius(v4r::DataMatrix2D<Surfel> &sf_cloud, const cv::Mat_<double> &intrinsic);
+  static void computeRadius(SurfelCloudSoA &sf_cloud, const cv::Mat_<double> &intrinsic);
   static void computeNormals(v4r::DataMatrix2D<Surfel> &sf_cloud, int nb_dist=1);
+  static void computeNormals(SurfelCloudSoA &sf_cloud, int nb_dist=1);
 
   void setCameraParameter(const cv::Mat &_intrinsic);
   void setParameter(const Parameter &p);
@@ -40,6 +40,7 @@
 #include <v4r/keypoints/impl/triple.hpp>
 #include <v4r/common/impl/DataMatrix2D.hpp>
 #include <v4r/camera_tracking_and_mapping/Surfel.hh>
+#include <v4r/camera_tracking_and_mapping/SurfelCloudSoA.hh>
 #include <v4r/core/macros.h>
 
 
@@ -77,6 +78,7 @@ public:
 
   TSFFrame();
   TSFFrame(const int &_idx, const Eigen::Matrix4f &_pose, const v4r::DataMatrix2D<Surfel> &_sf_cloud, bool _have_track);
+  TSFFrame(const int &_idx, const Eigen::Matrix4f &_pose, const v4r::SurfelCloudSoA &_sf_cloud, bool _have_track);
   ~TSFFrame();
 
   typedef boost::shared_ptr< ::v4r::TSFFrame> Ptr;
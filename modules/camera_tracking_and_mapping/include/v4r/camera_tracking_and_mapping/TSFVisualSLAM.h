@@ -86,6 +86,7 @@ private:
   cv::Mat_<double> intrinsic;
 
   TSFData data;
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud_buffer;   /// recycled buffer for the next input cloud
 
   TSFDataIntegration tsfDataIntegration;
   TSFPoseTrackerKLT tsfPoseTracker;
@@ -110,6 +111,7 @@ public:
   void getFilteredCloudNormals(pcl::PointCloud<pcl::PointXYZRGB> &cloud, pcl::PointCloud<pcl::Normal> &normals, Eigen::Matrix4f &pose, uint64_t &timestamp);
   void getFilteredCloud(pcl::PointCloud<pcl::PointXYZRGB> &cloud, Eigen::Matrix4f &pose, uint64_t &timestamp);
   void getSurfelCloud(v4r::DataMatrix2D<Surfel> &cloud, Eigen::Matrix4f &pose, uint64_t &timestamp, bool need_normals=false);
+  bool waitForFilteredCloud(const uint64_t &timestamp, int timeout_ms=-1);
 
   void setCameraParameter(const cv::Mat &_intrinsic);
   void setParameter(const Parameter &p);
@@ -0,0 +1,117 @@
+/******************************************************************************
+ * Copyright (c) 2017, Vision4Robotics group, TU Vienna
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+
+#include <v4r/camera_tracking_and_mapping/SurfelCloudSoA.hh>
+#include <limits>
+
+
+namespace v4r
+{
+
+
+/***************************************************************************************/
+
+/**
+ * @brief SurfelCloudSoA::resize
+ * @param _rows
+ * @param _cols
+ */
+void SurfelCloudSoA::resize(const int _rows, const int _cols)
+{
+  rows = _rows;
+  cols = _cols;
+  const int n = rows*cols;
+  x.resize(n); y.resize(n); z.resize(n);
+  nx.resize(n); ny.resize(n); nz.resize(n);
+  weight.resize(n);
+  radius.resize(n);
+  r.resize(n); g.resize(n); b.resize(n);
+}
+
+/**
+ * @brief SurfelCloudSoA::clear
+ */
+void SurfelCloudSoA::clear()
+{
+  resize(0,0);
+}
+
+/**
+ * @brief SurfelCloudSoA::getSurfel
+ * @param idx
+ * @return
+ */
+Surfel SurfelCloudSoA::getSurfel(const int idx) const
+{
+  Surfel s;
+  s.pt = Eigen::Vector3f(x[idx], y[idx], z[idx]);
+  s.n = Eigen::Vector3f(nx[idx], ny[idx], nz[idx]);
+  s.weight = weight[idx];
+  s.radius = radius[idx];
+  s.r = r[idx];
+  s.g = g[idx];
+  s.b = b[idx];
+  return s;
+}
+
+/**
+ * @brief SurfelCloudSoA::setSurfel
+ * @param idx
+ * @param s
+ */
+void SurfelCloudSoA::setSurfel(const int idx, const Surfel &s)
+{
+  x[idx] = s.pt[0]; y[idx] = s.pt[1]; z[idx] = s.pt[2];
+  nx[idx] = s.n[0]; ny[idx] = s.n[1]; nz[idx] = s.n[2];
+  weight[idx] = s.weight;
+  radius[idx] = s.radius;
+  r[idx] = (unsigned char)s.r;
+  g[idx] = (unsigned char)s.g;
+  b[idx] = (unsigned char)s.b;
+}
+
+/**
+ * @brief SurfelCloudSoA::fromSurfels
+ * @param sf_cloud
+ */
+void SurfelCloudSoA::fromSurfels(const v4r::DataMatrix2D<Surfel> &sf_cloud)
+{
+  resize(sf_cloud.rows, sf_cloud.cols);
+  for (int i=0; i<size(); i++)
+    setSurfel(i, sf_cloud.data[i]);
+}
+
+/**
+ * @brief SurfelCloudSoA::toSurfels
+ * @param sf_cloud
+ */
+void SurfelCloudSoA::toSurfels(v4r::DataMatrix2D<Surfel> &sf_cloud) const
+{
+  sf_cloud.resize(rows, cols);
+  for (int i=0; i<size(); i++)
+    sf_cloud.data[i] = getSurfel(i);
+}
+
+
+}
@@ -52,7 +52,8 @@ using namespace std;
 TSFData::TSFData()
  : need_init(false), init_points(0), lk_flags(0), timestamp(std::numeric_limits<uint64_t>::max()), pose(Eigen::Matrix4f::Identity()), have_pose(false), filt_pose(Eigen::Matrix4f::Identity()), filt_timestamp(std::numeric_limits<uint64_t>::max()), kf_timestamp(std::numeric_limits<uint64_t>::max()), kf_pose(Eigen::Matrix4f::Identity()), cnt_pose_lost_map(0), nb_frames_integrated(0)
 {
-  filt_cloud.reset(new DataMatrix2D<Surfel>() );
+  cloud.reset(new pcl::PointCloud<pcl::PointXYZRGB>() );
+  filt_cloud.reset(new SurfelCloudSoA() );
   last_pose_map(0,0) = std::numeric_limits<float>::quiet_NaN();
 }
 
@@ -78,10 +79,10 @@ void TSFData::reset()
   prev_gray = cv::Mat();
   points[0].clear(); points[1].clear();
   points3d[0].clear(); points3d[1].clear();
-  cloud.clear();
+  cloud.reset(new pcl::PointCloud<pcl::PointXYZRGB>() );
   pose = Eigen::Matrix4f::Identity();
   kf_pose = Eigen::Matrix4f::Identity();
-  filt_cloud.reset(new DataMatrix2D<Surfel>() );
+  filt_cloud.reset(new SurfelCloudSoA() );
   filt_pose = Eigen::Matrix4f::Identity();
   timestamp = std::numeric_limits<uint64_t>::max();
   filt_timestamp = std::numeric_limits<uint64_t>::max();
@@ -91,6 +92,7 @@ void TSFData::reset()
   cnt_pose_lost_map = 0;
   last_pose_map(0,0) = std::numeric_limits<float>::quiet_NaN();
   unlock();
+  cnd_filt_cloud.notify_all();    // wake up waitForFilteredCloud
 }
 
 
@@ -154,6 +156,84 @@ void TSFData::convert(const v4r::DataMatrix2D<v4r::Surfel> &sf_cloud, cv::Mat &i
 
 
 
+/**
+ * @brief TSFData::convert
+ * @param sf_cloud
+ * @param cloud
+ * @param thr_weight
+ * @param thr_delta_angle
+ */
+void TSFData::convert(const v4r::SurfelCloudSoA &sf_cloud, pcl::PointCloud<pcl::PointXYZRGBNormal> &cloud, const double &thr_weight, const double &thr_delta_angle )
+{
+  cloud.resize(sf_cloud.size());
+  cloud.width = sf_cloud.cols;
+  cloud.height = sf_cloud.rows;
+  cloud.is_dense = false;
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  double cos_rad_thr_delta_angle = cos(thr_delta_angle*M_PI/180.);
+  for (int i=0; i<sf_cloud.size(); i++)
+  {
+    pcl::PointXYZRGBNormal &o = cloud.points[i];
+    const float x = sf_cloud.x[i], y = sf_cloud.y[i], z = sf_cloud.z[i];
+    const float cos_view = -(sf_cloud.nx[i]*x + sf_cloud.ny[i]*y + sf_cloud.nz[i]*z) / sqrt(x*x + y*y + z*z);
+    if (sf_cloud.weight[i]>=thr_weight && cos_view > cos_rad_thr_delta_angle )
+    {
+      o.x = x; o.y = y; o.z = z;
+      o.normal_x = sf_cloud.nx[i]; o.normal_y = sf_cloud.ny[i]; o.normal_z = sf_cloud.nz[i];
+    }
+    else
+    {
+      o.x = o.y = o.z = nan;
+      o.normal_x = o.normal_y = o.normal_z = nan;
+    }
+    o.r = sf_cloud.r[i];
+    o.g = sf_cloud.g[i];
+    o.b = sf_cloud.b[i];
+  }
+}
+
+/**
+ * @brief TSFData::convert
+ * @param sf_cloud
+ * @param cloud
+ */
+void TSFData::convert(const v4r::SurfelCloudSoA &sf_cloud, pcl::PointCloud<pcl::PointXYZRGB> &cloud)
+{
+  cloud.resize(sf_cloud.size());
+  cloud.width = sf_cloud.cols;
+  cloud.height = sf_cloud.rows;
+  cloud.is_dense = false;
+  for (int i=0; i<sf_cloud.size(); i++)
+  {
+    pcl::PointXYZRGB &o = cloud.points[i];
+    o.x = sf_cloud.x[i];
+    o.y = sf_cloud.y[i];
+    o.z = sf_cloud.z[i];
+    o.r = sf_cloud.r[i];
+    o.g = sf_cloud.g[i];
+    o.b = sf_cloud.b[i];
+  }
+}
+
+/**
+ * @brief TSFData::convert
+ * @param sf_cloud
+ * @param image
+ */
+void TSFData::convert(const v4r::SurfelCloudSoA &sf_cloud, cv::Mat &image)
+{
+  image = cv::Mat_<cv::Vec3b>(sf_cloud.rows, sf_cloud.cols);
+  cv::Vec3b *im = image.ptr<cv::Vec3b>();
+
+  for (int i=0; i<sf_cloud.size(); i++)
+  {
+    im[i][2] = sf_cloud.r[i];
+    im[i][1] = sf_cloud.g[i];
+    im[i][0] = sf_cloud.b[i];
+  }
+}
+
+
 }
 
 
@@ -35,6 +35,9 @@
 #include <v4r/keypoints/impl/invPose.hpp>
 #include <v4r/common/convertImage.h>
 #include <pcl/common/transforms.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 
 
@@ -48,6 +51,167 @@ using namespace std;
 std::vector<cv::Vec4i> TSFDataIntegration::npat = std::vector<cv::Vec4i>();
 
 
+namespace
+{
+
+/**
+ * @brief projectRow transforms a row of surfels (pt = R*p+t) and projects them to the image
+ * (inv_z = 1/pt[2], im = C*pt*inv_z, computed in double precision like the former scalar loop)
+ */
+void projectRow(const float *x, const float *y, const float *z, int n, const Eigen::Matrix3f &R, const Eigen::Vector3f &t,
+                const double *C, float *row_z, float *row_inv_z, float *row_imx, float *row_imy)
+{
+  int u=0;
+#ifdef __SSE2__
+  const __m128 r00=_mm_set1_ps(R(0,0)), r01=_mm_set1_ps(R(0,1)), r02=_mm_set1_ps(R(0,2));
+  const __m128 r10=_mm_set1_ps(R(1,0)), r11=_mm_set1_ps(R(1,1)), r12=_mm_set1_ps(R(1,2));
+  const __m128 r20=_mm_set1_ps(R(2,0)), r21=_mm_set1_ps(R(2,1)), r22=_mm_set1_ps(R(2,2));
+  const __m128 t0=_mm_set1_ps(t[0]), t1=_mm_set1_ps(t[1]), t2=_mm_set1_ps(t[2]);
+  const __m128d c0=_mm_set1_pd(C[0]), c2=_mm_set1_pd(C[2]), c4=_mm_set1_pd(C[4]), c5=_mm_set1_pd(C[5]), one=_mm_set1_pd(1.);
+  for (; u+4<=n; u+=4)
+  {
+    const __m128 px=_mm_loadu_ps(x+u), py=_mm_loadu_ps(y+u), pz=_mm_loadu_ps(z+u);
+    const __m128 qx=_mm_add_ps(_mm_add_ps(_mm_mul_ps(r00,px),_mm_add_ps(_mm_mul_ps(r01,py),_mm_mul_ps(r02,pz))),t0);
+    const __m128 qy=_mm_add_ps(_mm_add_ps(_mm_mul_ps(r10,px),_mm_add_ps(_mm_mul_ps(r11,py),_mm_mul_ps(r12,pz))),t1);
+    const __m128 qz=_mm_add_ps(_mm_add_ps(_mm_mul_ps(r20,px),_mm_add_ps(_mm_mul_ps(r21,py),_mm_mul_ps(r22,pz))),t2);
+    _mm_storeu_ps(row_z+u, qz);
+
+    // lower and upper two lanes in double precision
+    const __m128d qx_lo=_mm_cvtps_pd(qx), qx_hi=_mm_cvtps_pd(_mm_movehl_ps(qx,qx));
+    const __m128d qy_lo=_mm_cvtps_pd(qy), qy_hi=_mm_cvtps_pd(_mm_movehl_ps(qy,qy));
+    const __m128d qz_lo=_mm_cvtps_pd(qz), qz_hi=_mm_cvtps_pd(_mm_movehl_ps(qz,qz));
+    const __m128 inv_z=_mm_movelh_ps(_mm_cvtpd_ps(_mm_div_pd(one,qz_lo)), _mm_cvtpd_ps(_mm_div_pd(one,qz_hi)));
+    _mm_storeu_ps(row_inv_z+u, inv_z);
+    const __m128d iz_lo=_mm_cvtps_pd(inv_z), iz_hi=_mm_cvtps_pd(_mm_movehl_ps(inv_z,inv_z));
+    const __m128 imx=_mm_movelh_ps(_mm_cvtpd_ps(_mm_add_pd(_mm_mul_pd(_mm_mul_pd(c0,qx_lo),iz_lo),c2)),
+                                   _mm_cvtpd_ps(_mm_add_pd(_mm_mul_pd(_mm_mul_pd(c0,qx_hi),iz_hi),c2)));
+    const __m128 imy=_mm_movelh_ps(_mm_cvtpd_ps(_mm_add_pd(_mm_mul_pd(_mm_mul_pd(c4,qy_lo),iz_lo),c5)),
+                                   _mm_cvtpd_ps(_mm_add_pd(_mm_mul_pd(_mm_mul_pd(c4,qy_hi),iz_hi),c5)));
+    _mm_storeu_ps(row_imx+u, imx);
+    _mm_storeu_ps(row_imy+u, imy);
+  }
+#endif
+  for (; u<n; u++)
+  {
+    const Eigen::Vector3f pt = R*Eigen::Vector3f(x[u], y[u], z[u])+t;
+    const float inv_z = 1./pt[2];
+    row_z[u] = pt[2];
+    row_inv_z[u] = inv_z;
+    row_imx[u] = C[0]*pt[0]*inv_z + C[2];
+    row_imy[u] = C[4]*pt[1]*inv_z + C[5];
+  }
+}
+
+/**
+ * @brief IntegrateRowArgs row pointers for integrateRow
+ */
+struct IntegrateRowArgs
+{
+  const float *px, *py, *pz, *occ;                    // occ: 1 if the pixel is occluded, 0 otherwise
+  const float *dn, *dw, *tz, *snx, *sny, *snz, *sr;  // splatted filtered cloud
+  const float *ray_x;                                  // (u-cx)/fx
+  float ray_y;                                         // (v-cy)/fy
+  float max_weight;
+  float *ox, *oy, *oz, *onx, *ony, *onz, *ow, *orad;
+};
+
+#ifdef __SSE2__
+/**
+ * @brief select_ps returns a where mask is set and b otherwise
+ */
+__m128 select_ps(const __m128 &mask, const __m128 &a, const __m128 &b)
+{
+  return _mm_or_ps(_mm_and_ps(mask,a), _mm_andnot_ps(mask,b));
+}
+#endif
+
+/**
+ * @brief integrateRow integrates a row of the new cloud with the splatted filtered cloud (depth_norm, depth_weight, tmp_z)
+ * The per pixel update is branch free (SSE2) and falls back to the scalar code for the remainder / other architectures.
+ */
+void integrateRow(const IntegrateRowArgs &a, int n)
+{
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const float eps = std::numeric_limits<float>::epsilon();
+  int u=0;
+#ifdef __SSE2__
+  const __m128 v_nan=_mm_set1_ps(nan), v_eps=_mm_set1_ps(eps), v_one=_mm_set1_ps(1.f), v_zero=_mm_setzero_ps(), v_half=_mm_set1_ps(.5f);
+  const __m128 v_max_weight=_mm_set1_ps(a.max_weight), v_ray_y=_mm_set1_ps(a.ray_y);
+  const __m128 v_abs=_mm_castsi128_ps(_mm_set1_epi32(0x7fffffff)), v_sign=_mm_castsi128_ps(_mm_set1_epi32(0x80000000));
+  for (; u+4<=n; u+=4)
+  {
+    const __m128 px=_mm_loadu_ps(a.px+u), py=_mm_loadu_ps(a.py+u), pz=_mm_loadu_ps(a.pz+u);
+    const __m128 dn=_mm_loadu_ps(a.dn+u), dw=_mm_loadu_ps(a.dw+u), tz=_mm_loadu_ps(a.tz+u);
+    const __m128 is_nan=_mm_cmpunord_ps(pz,pz);
+    const __m128 occluded=_mm_cmpgt_ps(_mm_loadu_ps(a.occ+u), v_half);
+    const __m128 is_new=_mm_cmple_ps(_mm_and_ps(dw,v_abs), v_eps);
+
+    // update of an existing surfel
+    const __m128 inv_norm=_mm_div_ps(v_one,dn);
+    __m128 w=_mm_mul_ps(dw,inv_norm);
+    __m128 z=_mm_mul_ps(tz,inv_norm);
+    z=select_ps(is_nan, z, _mm_div_ps(_mm_add_ps(_mm_mul_ps(z,w),pz), _mm_add_ps(w,v_one)));
+    w=select_ps(_mm_cmplt_ps(w,v_max_weight), _mm_add_ps(w,v_one), w);
+
+    // new surfel
+    const __m128 inv_len=_mm_div_ps(v_one, _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px,px),_mm_mul_ps(py,py)),_mm_mul_ps(pz,pz))));
+
+    const __m128 rx=_mm_loadu_ps(a.ray_x+u);
+    _mm_storeu_ps(a.ox+u, select_ps(occluded, v_nan, select_ps(is_new, px, _mm_mul_ps(z,rx))));
+    _mm_storeu_ps(a.oy+u, select_ps(occluded, v_nan, select_ps(is_new, py, _mm_mul_ps(z,v_ray_y))));
+    _mm_storeu_ps(a.oz+u, select_ps(occluded, v_nan, select_ps(is_new, pz, z)));
+    _mm_storeu_ps(a.onx+u, select_ps(occluded, v_nan, select_ps(is_new, _mm_xor_ps(_mm_mul_ps(px,inv_len),v_sign), _mm_loadu_ps(a.snx+u))));
+    _mm_storeu_ps(a.ony+u, select_ps(occluded, v_nan, select_ps(is_new, _mm_xor_ps(_mm_mul_ps(py,inv_len),v_sign), _mm_loadu_ps(a.sny+u))));
+    _mm_storeu_ps(a.onz+u, select_ps(occluded, v_nan, select_ps(is_new, _mm_xor_ps(_mm_mul_ps(pz,inv_len),v_sign), _mm_loadu_ps(a.snz+u))));
+    _mm_storeu_ps(a.ow+u, select_ps(occluded, v_zero, select_ps(is_new, _mm_andnot_ps(is_nan,v_one), w)));
+    _mm_storeu_ps(a.orad+u, select_ps(_mm_or_ps(occluded,is_new), v_zero, _mm_loadu_ps(a.sr+u)));
+  }
+#endif
+  for (; u<n; u++)
+  {
+    const bool is_nan = std::isnan(a.pz[u]);
+    const bool occluded = a.occ[u]>.5f;
+    const bool is_new = fabs(a.dw[u])<=eps;
+
+    // update of an existing surfel
+    const float inv_norm = 1.f/a.dn[u];
+    float w = a.dw[u]*inv_norm;
+    float z = a.tz[u]*inv_norm;
+    z = is_nan ? z : (z*w + a.pz[u]) / (w+1.f);
+    w = w<a.max_weight ? w+1.f : w;
+
+    // new surfel (see Surfel(const pcl::PointXYZRGB &))
+    const float inv_len = 1.f/sqrt(a.px[u]*a.px[u] + a.py[u]*a.py[u] + a.pz[u]*a.pz[u]);
+
+    if (occluded)
+    {
+      a.ox[u] = a.oy[u] = a.oz[u] = nan;
+      a.onx[u] = a.ony[u] = a.onz[u] = nan;
+      a.ow[u] = 0.f;
+      a.orad[u] = 0.f;
+    }
+    else if (is_new)
+    {
+      a.ox[u] = a.px[u]; a.oy[u] = a.py[u]; a.oz[u] = a.pz[u];
+      a.onx[u] = -a.px[u]*inv_len; a.ony[u] = -a.py[u]*inv_len; a.onz[u] = -a.pz[u]*inv_len;
+      a.ow[u] = is_nan ? 0.f : 1.f;
+      a.orad[u] = 0.f;
+    }
+    else
+    {
+      a.oz[u] = z;
+      a.ox[u] = z*a.ray_x[u];
+      a.oy[u] = z*a.ray_y;
+      a.onx[u] = a.snx[u]; a.ony[u] = a.sny[u]; a.onz[u] = a.snz[u];
+      a.ow[u] = w;
+      a.orad[u] = a.sr[u];
+    }
+  }
+}
+
+} // namespace
+
+
 
 /************************************************************************************
  * Constructor/Destructor
@@ -68,60 +232,81 @@ TSFDataIntegration::~TSFDataIntegration()
  */
 void TSFDataIntegration::operate()
 {
-  bool have_todo;
+  bool have_new_keyframe, have_track = false;
 
-  pcl::PointCloud<pcl::PointXYZRGB> cloud;  ///// new cloud
+  pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud;  ///// new cloud
   Eigen::Matrix4f pose;      /// global pose of the current frame (depth, gray, points[1], ....)
   uint64_t timestamp = 0;
-  v4r::DataMatrix2D<Surfel> filt_cloud;
+  SurfelCloudSoA::ConstPtr filt_cloud;  /// currently published filtered cloud
+  SurfelCloudSoA::Ptr next_filt_cloud;  /// back buffer the new filtered cloud is integrated into
   Eigen::Matrix4f filt_pose;
 
-  while(run)
+  while(true)
   {
-    have_todo = false;
-    data->lock();
-    if (data->timestamp!=data->filt_timestamp)
     {
-      have_todo = true;
+      boost::unique_lock<boost::mutex> lock(data->mtx_shm);
+      while (run && data->timestamp==data->filt_timestamp)
+        data->cnd_new_frame.wait(lock);
+
+      if (!run)
+        break;
+
       cloud = data->cloud;
-      filt_cloud = *data->filt_cloud;
+      filt_cloud = data->filt_cloud;
       timestamp = data->timestamp;
       pose = data->pose;
       filt_pose = data->filt_pose;
     }
-    data->unlock();
 
-    if (have_todo)
+    // reuse the buffer of an old snapshot if nobody else holds it anymore
+    if (!next_filt_cloud || !next_filt_cloud.unique())
+      next_filt_cloud.reset(new SurfelCloudSoA());
+
+    //v4r::ScopeTime t("TSFDataIntegration::operate");
+    if ((int)cloud->width!=filt_cloud->cols || (int)cloud->height!=filt_cloud->rows)
     {
-      //v4r::ScopeTime t("TSFDataIntegration::operate");
-      if ((int)cloud.width!=filt_cloud.cols || (int)cloud.height!=filt_cloud.rows)
-      {
-        initCloud(cloud, filt_cloud);
-      }
-      else
+      next_filt_cloud->clear();
+      initCloud(*cloud, *next_filt_cloud);
+    }
+    else
+    {
+      integrateData(*cloud, pose, filt_pose, *filt_cloud, *next_filt_cloud);
+      //computeNormals(filt_cloud);
+    }
+
+    have_new_keyframe = false;
+
+    data->lock();
+    data->filt_cloud.swap(next_filt_cloud);
+    data->filt_timestamp = timestamp;
+    data->filt_pose = pose;
+    data->nb_frames_integrated++;
+    if (std::isnan(data->last_pose_map(0,0)) || selectFrame(data->last_pose_map, pose))
+    {
+      if (!data->filt_cloud->empty() && data->nb_frames_integrated>param.min_frames_integrated)
       {
-        integrateData(cloud, pose, filt_pose, filt_cloud);
-        //computeNormals(filt_cloud);
+        have_new_keyframe = true;
+        have_track = (data->cnt_pose_lost_map>0?false:true);
+        data->cnt_pose_lost_map = 0;
+        data->last_pose_map = pose;
       }
+    }
+    filt_cloud = data->filt_cloud;
+    data->unlock();
+
+    data->cnd_filt_cloud.notify_all();
 
+    if (have_new_keyframe)
+    {
+      // copy the keyframe outside of the lock, the published snapshot is not modified anymore
+      TSFFrame::Ptr frame( new TSFFrame(-1,pose,*filt_cloud,have_track) );
       data->lock();
-      *data->filt_cloud = filt_cloud;
-      data->filt_timestamp = timestamp;
-      data->filt_pose = pose;
-      data->nb_frames_integrated++;
-      if (std::isnan(data->last_pose_map(0,0)) || selectFrame(data->last_pose_map, pose))
-      {
-        if (data->filt_cloud->data.size()>0 && data->nb_frames_integrated>param.min_frames_integrated)
-        {
-          data->map_frames.push( TSFFrame::Ptr( new TSFFrame(-1,pose,*data->filt_cloud,(data->cnt_pose_lost_map>0?false:true)) ) );
-          data->cnt_pose_lost_map = 0;
-          data->last_pose_map = pose;
-        }
-      }
+      data->map_frames.push(frame);
       data->unlock();
+      data->cnd_map_frames.notify_one();
     }
 
-    if (!have_todo) usleep(10000);
+    filt_cloud.reset();
   }
 }
 
@@ -163,10 +348,30 @@ void TSFDataIntegration::initCloud(const pcl::PointCloud<pcl::PointXYZRGB> &clou
 
 
 
+/**
+ * @brief TSFDataIntegration::initCloud
+ * @param cloud
+ * @param sf_cloud
+ */
+void TSFDataIntegration::initCloud(const pcl::PointCloud<pcl::PointXYZRGB> &cloud, SurfelCloudSoA &sf_cloud)
+{
+  if (sf_cloud.rows!=(int)cloud.height || sf_cloud.cols!=(int)cloud.width)
+  {
+    sf_cloud.resize(cloud.height, cloud.width);
+    for (unsigned v=0; v<cloud.height; v++)
+    {
+      for (unsigned u=0; u<cloud.width; u++)
+      {
+        sf_cloud.setSurfel(sf_cloud.GetIdx(v,u), Surfel(cloud(u,v)));
+      }
+    }
+  }
+}
+
 /**
  * @brief TSFDataIntegration::addCloud
  */
-void TSFDataIntegration::integrateData(const pcl::PointCloud<pcl::PointXYZRGB> &cloud, const Eigen::Matrix4f &pose, const Eigen::Matrix4f &filt_pose, v4r::DataMatrix2D<Surfel> &filt_cloud)
+void TSFDataIntegration::integrateData(const pcl::PointCloud<pcl::PointXYZRGB> &cloud, const Eigen::Matrix4f &pose, const Eigen::Matrix4f &filt_pose, const SurfelCloudSoA &filt_cloud, SurfelCloudSoA &new_filt_cloud)
 {
   if (intrinsic.empty())
     throw std::runtime_error("[TSFDataIntegration::addCloud] Camera parameter not set!");
@@ -198,19 +403,26 @@ void TSFDataIntegration::integrateData(const pcl::PointCloud<pcl::PointXYZRGB> &
     occ.compute(cloud, occ_mask);
 
   // tranform filt cloud to current frame and update
+  // (the projection is done row wise, the splatting stays scalar because surfels write to overlapping pixels)
+  std::vector<float> row_z(filt_cloud.cols), row_inv_z(filt_cloud.cols), row_imx(filt_cloud.cols), row_imy(filt_cloud.cols);
   for (int v=0; v<filt_cloud.rows; v++)
   {
+    const int offs = filt_cloud.GetIdx(v,0);
+    if (filt_cloud.cols>0)
+      projectRow(&filt_cloud.x[offs], &filt_cloud.y[offs], &filt_cloud.z[offs], filt_cloud.cols, R, t, C, &row_z[0], &row_inv_z[0], &row_imx[0], &row_imy[0]);
+
     for (int u=0; u<filt_cloud.cols; u++)
     {
-      const Surfel &s = filt_cloud(v,u);
+      const int idx = offs+u;
+      const float &sw = filt_cloud.weight[idx];
 
-      if (std::isnan(s.pt[0])||std::isnan(s.pt[1])||std::isnan(s.pt[2]))
+      if (filt_cloud.isNaN(idx))
         continue;
 
-      pt = R*s.pt+t;
-      inv_z = 1./pt[2];
-      im_pt.x = C[0]*pt[0]*inv_z + C[2];
-      im_pt.y = C[4]*pt[1]*inv_z + C[5];
+      pt[2] = row_z[u];
+      inv_z = row_inv_z[u];
+      im_pt.x = row_imx[u];
+      im_pt.y = row_imy[u];
       x = (int)(im_pt.x);
       y = (int)(im_pt.y);
 
@@ -246,7 +458,7 @@ void TSFDataIntegration::integrateData(const pcl::PointCloud<pcl::PointXYZRGB> &
         }
         norm *= (1.-ax) * (1.-ay);
         tz[0] += norm*pt[2];
-        dw[0] += norm*s.weight;
+        dw[0] += norm*sw;
         dn[0] += norm;
       }
       {
@@ -272,7 +484,7 @@ void TSFDataIntegration::integrateData(const pcl::PointCloud<pcl::PointXYZRGB> &
         }
         norm *= ax * (1.-ay);
         tz[1] += norm*pt[2];
-        dw[1] += norm*s.weight;
+        dw[1] += norm*sw;
         dn[1] += norm;
       }
       {
@@ -298,7 +510,7 @@ void TSFDataIntegration::integrateData(const pcl::PointCloud<pcl::PointXYZRGB> &
         }
         norm *= (1.-ax) *  ay;
         tz[width] += norm*pt[2];
-        dw[width] += norm*s.weight;
+        dw[width] += norm*sw;
         dn[width] += norm;
       }
       {
@@ -324,45 +536,55 @@ void TSFDataIntegration::integrateData(const pcl::PointCloud<pcl::PointXYZRGB> &
         }
         norm *= ax * ay;
         tz[width+1] += norm*pt[2];
-        dw[width+1] += norm*s.weight;
+        dw[width+1] += norm*sw;
         dn[width+1] += norm;
       }
     }
   }
 
-  // integrate new data
-  float inv_norm;
-  for (unsigned v=0; v<cloud.height; v++)
+  // integrate new data (row wise over the surfel planes, see integrateRow)
+  const float cx = C[2], cy = C[5];
+  const float inv_fx = invC0, inv_fy = invC4;
+  std::vector<float> px(width), py(width), pz(width), occ_row(width, 0.f), ray_x(width);
+  new_filt_cloud.resize(height, width);
+
+  for (int u=0; u<width; u++)
+    ray_x[u] = (u-cx)*inv_fx;
+
+  IntegrateRowArgs args;
+  args.px = &px[0]; args.py = &py[0]; args.pz = &pz[0]; args.occ = &occ_row[0];
+  args.ray_x = &ray_x[0];
+  args.max_weight = param.max_integration_frames;
+
+  for (int v=0; v<height; v++)
   {
-    for (unsigned u=0; u<cloud.width; u++)
+    const int offs = v*width;
+    for (int u=0; u<width; u++)
     {
-      const float &dw = depth_weight(v,u);
-      Surfel &sf = filt_cloud(v,u);
-      const pcl::PointXYZRGB &pt = cloud(u,v);
+      const pcl::PointXYZRGB &p = cloud(u,v);
+      px[u] = p.x; py[u] = p.y; pz[u] = p.z;
+      new_filt_cloud.r[offs+u] = p.r;
+      new_filt_cloud.g[offs+u] = p.g;
+      new_filt_cloud.b[offs+u] = p.b;
+    }
 
-      if (!param.filter_occlusions || occ_mask(v,u)<128)
-      {
-        if (fabs(dw)<=std::numeric_limits<float>::epsilon())
-        {
-          sf = Surfel(pt);
-        }
-        else
-        {
-          const float &tz = tmp_z(v,u);
-          inv_norm = 1./depth_norm(v,u);
-          sf.pt[2] = tz*inv_norm;
-          sf.weight = dw*inv_norm;
-          if (!isnan(pt.z))
-            sf.pt[2] = (sf.pt[2]*(float)sf.weight + pt.z) / (float)(sf.weight+1.);
-          sf.pt[0] = sf.pt[2]*((u-C[2])*invC0);
-          sf.pt[1] = sf.pt[2]*((v-C[5])*invC4);
-          if (sf.weight<param.max_integration_frames) sf.weight+=1;
-        }
-      } else sf = Surfel();
-      sf.r = pt.r;
-      sf.g = pt.g;
-      sf.b = pt.b;
+    if (param.filter_occlusions)
+    {
+      for (int u=0; u<width; u++)
+        occ_row[u] = (occ_mask(v,u)>=128 ? 1.f : 0.f);
     }
+
+    args.dn = &depth_norm(v,0);
+    args.dw = &depth_weight(v,0);
+    args.tz = &tmp_z(v,0);
+    args.snx = &filt_cloud.nx[offs]; args.sny = &filt_cloud.ny[offs]; args.snz = &filt_cloud.nz[offs];
+    args.sr = &filt_cloud.radius[offs];
+    args.ray_y = (v-cy)*inv_fy;
+    args.ox = &new_filt_cloud.x[offs]; args.oy = &new_filt_cloud.y[offs]; args.oz = &new_filt_cloud.z[offs];
+    args.onx = &new_filt_cloud.nx[offs]; args.ony = &new_filt_cloud.ny[offs]; args.onz = &new_filt_cloud.nz[offs];
+    args.ow = &new_filt_cloud.weight[offs]; args.orad = &new_filt_cloud.radius[offs];
+
+    integrateRow(args, width);
   }
 }
 
@@ -392,7 +614,14 @@ void TSFDataIntegration::start()
  */
 void TSFDataIntegration::stop()
 {
-  run = false;
+  if (data!=NULL)
+  {
+    data->lock();
+    run = false;
+    data->unlock();
+    data->cnd_new_frame.notify_all();
+  }
+  else run = false;
   th_obectmanagement.join();
   have_thread = false;
 }
@@ -431,6 +660,25 @@ void TSFDataIntegration::computeRadius(v4r::DataMatrix2D<Surfel> &sf_cloud, cons
   }
 }
 
+/**
+ * @brief TSFDataIntegration::computeRadius
+ * @param sf_cloud
+ */
+void TSFDataIntegration::computeRadius(SurfelCloudSoA &sf_cloud, const cv::Mat_<double> &intrinsic)
+{
+  if (sf_cloud.empty())
+    return;
+
+  const float norm = 1./sqrt(2)*(2./(intrinsic(0,0)+intrinsic(1,1)));
+  Eigen::Map<const Eigen::ArrayXf> x(&sf_cloud.x[0], sf_cloud.size());
+  Eigen::Map<const Eigen::ArrayXf> y(&sf_cloud.y[0], sf_cloud.size());
+  Eigen::Map<const Eigen::ArrayXf> z(&sf_cloud.z[0], sf_cloud.size());
+  Eigen::Map<Eigen::ArrayXf> radius(&sf_cloud.radius[0], sf_cloud.size());
+
+  // (x == x) is false for NaNs
+  radius = ((x == x) && (y == y) && (z == z)).select(norm*z, 0.f);
+}
+
 /**
  * @brief TSFDataIntegration::computeNormals
  * @param sf_cloud
@@ -487,6 +735,97 @@ void TSFDataIntegration::computeNormals(v4r::DataMatrix2D<Surfel> &sf_cloud, int
 
 
 
+/**
+ * @brief TSFDataIntegration::computeNormals
+ * The cross product with the right and lower neighbour is computed for a whole row over the surfel planes, the remaining
+ * neighbourhood patterns (see computeNormals(v4r::DataMatrix2D<Surfel> &, int)) are only tested if it is not valid.
+ * @param sf_cloud
+ */
+void TSFDataIntegration::computeNormals(SurfelCloudSoA &sf_cloud, int nb_dist)
+{
+  if (sf_cloud.empty())
+    return;
+
+  const int pat[4][4] = { {nb_dist,0,0,nb_dist}, {0,nb_dist,-nb_dist,0}, {-nb_dist,0,0,-nb_dist}, {0,-nb_dist,0,nb_dist} };
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  const int cols = sf_cloud.cols;
+  const int rows = sf_cloud.rows;
+  const float *x = &sf_cloud.x[0], *y = &sf_cloud.y[0], *z = &sf_cloud.z[0];
+  std::vector<float> tnx(cols), tny(cols), tnz(cols);
+
+  for (int v=0; v<rows; v++)
+  {
+    const int offs = v*cols;
+    const int offs3 = (v+nb_dist)*cols;
+    const int end = (v+nb_dist<rows ? cols-nb_dist : 0);
+
+    // fast path: first neighbourhood pattern, NaNs propagate to the normal
+    for (int u=0; u<end; u++)
+    {
+      const int i1 = offs+u, i2 = offs+u+nb_dist, i3 = offs3+u;
+      const float l1x = x[i2]-x[i1], l1y = y[i2]-y[i1], l1z = z[i2]-z[i1];
+      const float l2x = x[i3]-x[i1], l2y = y[i3]-y[i1], l2z = z[i3]-z[i1];
+      float cx = l1y*l2z - l1z*l2y;
+      float cy = l1z*l2x - l1x*l2z;
+      float cz = l1x*l2y - l1y*l2x;
+      const float inv_len = 1.f/sqrt(cx*cx + cy*cy + cz*cz);
+      const float sign = (cx*x[i1] + cy*y[i1] + cz*z[i1]) > 0 ? -inv_len : inv_len;
+      tnx[u] = cx*sign;
+      tny[u] = cy*sign;
+      tnz[u] = cz*sign;
+    }
+    for (int u=std::max(end,0); u<cols; u++)
+      tnx[u] = tny[u] = tnz[u] = nan;
+
+    for (int u=0; u<cols; u++)
+    {
+      const int i1 = offs+u;
+      if (sf_cloud.isNaN(i1))
+        continue;
+
+      if (!std::isnan(tnx[u]) && !std::isnan(tny[u]) && !std::isnan(tnz[u]))
+      {
+        sf_cloud.nx[i1] = tnx[u];
+        sf_cloud.ny[i1] = tny[u];
+        sf_cloud.nz[i1] = tnz[u];
+        continue;
+      }
+
+      // fallback: test the other neighbourhood patterns
+      int k, i2=-1, i3=-1;
+      for (k=0; k<4; k++)
+      {
+        const int *p = pat[k];
+        if (u+p[0]>=0 && u+p[0]<cols && v+p[1]>=0 && v+p[1]<rows &&
+            u+p[2]>=0 && u+p[2]<cols && v+p[3]>=0 && v+p[3]<rows)
+        {
+          i2 = sf_cloud.GetIdx(v+p[1],u+p[0]);
+          if (sf_cloud.isNaN(i2))
+            continue;
+          i3 = sf_cloud.GetIdx(v+p[3],u+p[2]);
+          if (sf_cloud.isNaN(i3))
+            continue;
+          break;
+        }
+      }
+      if (k<4)
+      {
+        Eigen::Vector3f pt1(x[i1],y[i1],z[i1]);
+        Eigen::Vector3f l1 = Eigen::Vector3f(x[i2],y[i2],z[i2])-pt1;
+        Eigen::Vector3f l2 = Eigen::Vector3f(x[i3],y[i3],z[i3])-pt1;
+        Eigen::Vector3f n = l1.cross(l2).normalized();
+        if (n.dot(pt1) > 0) n *= -1;
+        sf_cloud.nx[i1] = n[0];
+        sf_cloud.ny[i1] = n[1];
+        sf_cloud.nz[i1] = n[2];
+      }
+      else sf_cloud.nx[i1] = sf_cloud.ny[i1] = sf_cloud.nz[i1] = nan;
+    }
+  }
+}
+
+
+
 /**
  * setCameraParameter
  */
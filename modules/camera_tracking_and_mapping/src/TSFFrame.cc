@@ -58,6 +58,12 @@ TSFFrame::TSFFrame(const int &_idx, const Eigen::Matrix4f &_pose, const v4r::Dat
 {
 }
 
+TSFFrame::TSFFrame(const int &_idx, const Eigen::Matrix4f &_pose, const v4r::SurfelCloudSoA &_sf_cloud,  bool _have_track)
+ : idx(_idx), pose(_pose), delta_cloud_rgb_pose(Eigen::Matrix4f::Identity()), fw_link(-1), bw_link(-1), have_track(_have_track)
+{
+  _sf_cloud.toSurfels(sf_cloud);
+}
+
 TSFFrame::~TSFFrame()
 {
 }
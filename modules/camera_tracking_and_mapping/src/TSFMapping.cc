@@ -77,52 +77,47 @@ TSFMapping::~TSFMapping()
  */
 void TSFMapping::operate()
 {
-  bool have_todo;
-
-  while(run)
+  while(true)
   {
-    have_todo = false;
-    data->lock();
-    if (data->map_frames.size()>0)
     {
+      boost::unique_lock<boost::mutex> lock(data->mtx_shm);
+      while (run && data->map_frames.empty())
+        data->cnd_map_frames.wait(lock);
+
+      if (!run)
+        break;
+
       map_frames.push_back(data->map_frames.front());
       data->map_frames.pop();
-      have_todo = true;
     }
-    data->unlock();
 
-    if (have_todo)
+    //v4r::ScopeTime t("[Mapping]");
+    map_frames.back()->idx = map_frames.size()-1;
+    TSFData::convert(map_frames.back()->sf_cloud, image0);
+    cv::cvtColor( image0, im_gray0, CV_BGR2GRAY );
+    TSFDataIntegration::computeNormals(map_frames.back()->sf_cloud, 2);
+    initKeypoints( im_gray0, *map_frames.back() );
+
+    if (map_frames.size()>=2)
     {
-      //v4r::ScopeTime t("[Mapping]");
-      map_frames.back()->idx = map_frames.size()-1;
-      TSFData::convert(map_frames.back()->sf_cloud, image0);
-      cv::cvtColor( image0, im_gray0, CV_BGR2GRAY );
-      TSFDataIntegration::computeNormals(map_frames.back()->sf_cloud, 2);
-      initKeypoints( im_gray0, *map_frames.back() );
-
-      if (map_frames.size()>=2)
+      for (int i=0; i<param.nb_tracked_frames; i++)
       {
-        for (int i=0; i<param.nb_tracked_frames; i++)
+        if (i+2<=(int)map_frames.size() && map_frames[map_frames.size()-i-1]->have_track)
         {
-          if (i+2<=(int)map_frames.size() && map_frames[map_frames.size()-i-1]->have_track)
-          {
-            TSFData::convert(map_frames[map_frames.size()-i-2]->sf_cloud, image);
-            cv::cvtColor( image, im_gray1, CV_BGR2GRAY );
-            addFeatureLinks(*map_frames.back(), *map_frames[map_frames.size()-i-2], im_gray0, im_gray1, map_frames.back()->pose, map_frames[map_frames.size()-i-2]->pose, false);
-            cout<<"  Have track ("<<map_frames[map_frames.size()-i-2]->idx<<"-"<<map_frames.back()->idx<<")"<<endl;
-          }
+          TSFData::convert(map_frames[map_frames.size()-i-2]->sf_cloud, image);
+          cv::cvtColor( image, im_gray1, CV_BGR2GRAY );
+          addFeatureLinks(*map_frames.back(), *map_frames[map_frames.size()-i-2], im_gray0, im_gray1, map_frames.back()->pose, map_frames[map_frames.size()-i-2]->pose, false);
+          cout<<"  Have track ("<<map_frames[map_frames.size()-i-2]->idx<<"-"<<map_frames.back()->idx<<")"<<endl;
         }
-
-        if (param.detect_loops) addLoops();
-        cout<<"  Number keyframes: "<<map_frames.size()<<endl;
       }
-      
-      data->lock();
-      // copy back results????
-      data->unlock();
-    }
 
-    if (!have_todo) usleep(10000);
+      if (param.detect_loops) addLoops();
+      cout<<"  Number keyframes: "<<map_frames.size()<<endl;
+    }
+    
+    data->lock();
+    // copy back results????
+    data->unlock();
   }
 }
 
@@ -596,7 +591,14 @@ void TSFMapping::start()
  */
 void TSFMapping::stop()
 {
-  run = false;
+  if (data!=NULL)
+  {
+    data->lock();
+    run = false;
+    data->unlock();
+    data->cnd_map_frames.notify_all();
+  }
+  else run = false;
   th_obectmanagement.join();
   have_thread = false;
 }
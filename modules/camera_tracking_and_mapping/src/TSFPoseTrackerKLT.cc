@@ -67,50 +67,44 @@ TSFPoseTrackerKLT::~TSFPoseTrackerKLT()
  */
 void TSFPoseTrackerKLT::operate()
 {
-  bool have_todo;
-
   cv::Mat im_gray;
-  pcl::PointCloud<pcl::PointXYZRGB> cloud;
+  pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr cloud;
   std::vector<cv::Point2f> points;
   std::vector<Eigen::Vector3f> points3d;
   Eigen::Matrix4f pose;
   uint64_t timestamp = 0;
 
-  while(run)
+  while(true)
   {
-    have_todo = false;
-
-    data->lock();
-    if (data->need_init && data->cloud.points.size() > 0 && data->timestamp!=data->kf_timestamp)
     {
-      have_todo = true;
+      boost::unique_lock<boost::mutex> lock(data->mtx_shm);
+      while (run && !(data->need_init && data->cloud->points.size() > 0 && data->timestamp!=data->kf_timestamp))
+        data->cnd_new_frame.wait(lock);
+
+      if (!run)
+        break;
+
       cloud = data->cloud;
       pose = data->pose;
       timestamp = data->timestamp;
       data->gray.copyTo(im_gray);
     }
-    data->unlock();
 
-    if (have_todo)
-    {
-      cv::goodFeaturesToTrack(im_gray, points, param.max_count, 0.01, 10, cv::Mat(), 3, 0, 0.04);
-      getPoints3D(cloud, points, points3d);
-      filterValidPoints3D(points, points3d);
-
-      data->lock();
-      data->init_points = points.size();
-      data->lk_flags = 0;
-      im_gray.copyTo(data->prev_gray);
-      data->points[0] = points;
-      data->points3d[0] = points3d;
-      data->kf_pose = pose;
-      data->kf_timestamp = timestamp;
-      if (data->points[0].size() > param.max_count*param.pcent_reinit)
-        data->need_init = false;
-      data->unlock();
-    }
+    cv::goodFeaturesToTrack(im_gray, points, param.max_count, 0.01, 10, cv::Mat(), 3, 0, 0.04);
+    getPoints3D(*cloud, points, points3d);
+    filterValidPoints3D(points, points3d);
 
-    if (!have_todo) usleep(10000);
+    data->lock();
+    data->init_points = points.size();
+    data->lk_flags = 0;
+    im_gray.copyTo(data->prev_gray);
+    data->points[0] = points;
+    data->points3d[0] = points3d;
+    data->kf_pose = pose;
+    data->kf_timestamp = timestamp;
+    if (data->points[0].size() > param.max_count*param.pcent_reinit)
+      data->need_init = false;
+    data->unlock();
   }
 }
 
@@ -298,8 +292,8 @@ bool TSFPoseTrackerKLT::needReinit(const std::vector<cv::Point2f> &points)
   if (points.size() < data->init_points*param.pcent_reinit)
     return true;
 
-  int hw = data->cloud.width/2;
-  int hh = data->cloud.height/2;
+  int hw = data->cloud->width/2;
+  int hh = data->cloud->height/2;
 
   int cnt[4] = {0,0,0,0};
 
@@ -357,7 +351,7 @@ bool TSFPoseTrackerKLT::trackCamera(double &conf_ransac_iter, double &conf_track
 
 
   // track pose
-  getPoints3D(data->cloud, data->points[1], data->points3d[1]);
+  getPoints3D(*data->cloud, data->points[1], data->points3d[1]);
   filterValidPoints3D(data->points[0],data->points3d[0], data->points[1], data->points3d[1]);
 
   if (data->points3d[1].size()>4)
@@ -427,7 +421,14 @@ void TSFPoseTrackerKLT::start()
  */
 void TSFPoseTrackerKLT::stop()
 {
-  run = false;
+  if (data!=NULL)
+  {
+    data->lock();
+    run = false;
+    data->unlock();
+    data->cnd_new_frame.notify_all();
+  }
+  else run = false;
   th_obectmanagement.join();
   have_thread = false;
 }
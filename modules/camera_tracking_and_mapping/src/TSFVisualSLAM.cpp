@@ -40,6 +40,7 @@
 #include <v4r/camera_tracking_and_mapping/TSFVisualSLAM.h>
 #include <v4r/common/convertImage.h>
 #include <pcl/common/transforms.h>
+#include <limits>
 
 #include "opencv2/highgui/highgui.hpp"
 
@@ -118,11 +119,16 @@ bool TSFVisualSLAM::track(const pcl::PointCloud<pcl::PointXYZRGB> &cloud, const
 
   if (!dbg.empty()) tsfPoseTracker.dbg = dbg;
 
+  // copy the new frame outside of the lock, reuse the buffer of an old frame if no other thread holds it anymore
+  if (!cloud_buffer || !cloud_buffer.unique())
+    cloud_buffer.reset(new pcl::PointCloud<pcl::PointXYZRGB>());
+  *cloud_buffer = cloud;
+
   // the tracker does not copy data, we need to lock the shared memory
   data.lock();
 
-  data.have_pose = (data.cloud.points.size()==0?true:false);
-  data.cloud = cloud;
+  data.have_pose = (data.cloud->points.size()==0?true:false);
+  data.cloud.swap(cloud_buffer);
   data.timestamp = timestamp;
   tsfPoseTracker.track(conf_ransac_iter, conf_tracked_points);
   pose = data.pose;
@@ -131,6 +137,9 @@ bool TSFVisualSLAM::track(const pcl::PointCloud<pcl::PointXYZRGB> &cloud, const
 
   data.unlock();
 
+  // wake up data integration and keyframe initialization
+  data.cnd_new_frame.notify_all();
+
   return have_pose;
 }
 
@@ -142,25 +151,31 @@ bool TSFVisualSLAM::track(const pcl::PointCloud<pcl::PointXYZRGB> &cloud, const
 void TSFVisualSLAM::getFilteredCloudNormals(pcl::PointCloud<pcl::PointXYZRGBNormal> &cloud, Eigen::Matrix4f &pose, uint64_t &timestamp)
 {
   data.lock();
-  v4r::DataMatrix2D<Surfel> &cfilt = *data.filt_cloud;
-  cloud.resize(cfilt.data.size());
+  SurfelCloudSoA::ConstPtr filt_cloud = data.filt_cloud;
+  timestamp = data.filt_timestamp;
+  pose = data.filt_pose;
+  data.unlock();
+
+  // the published cloud is shared, hence normals are computed on a copy
+  SurfelCloudSoA cfilt = *filt_cloud;
+  TSFDataIntegration::computeNormals(cfilt);
+  cloud.resize(cfilt.size());
   cloud.width = cfilt.cols;
   cloud.height = cfilt.rows;
   cloud.is_dense = false;
-  TSFDataIntegration::computeNormals(cfilt);
-  for (unsigned i=0; i<cfilt.data.size(); i++)
+  for (int i=0; i<cfilt.size(); i++)
   {
-    const Surfel &s = cfilt.data[i];
     pcl::PointXYZRGBNormal &o = cloud.points[i];
-    o.getVector3fMap() = s.pt;
-    o.r = s.r;
-    o.g = s.g;
-    o.b = s.b;
-    o.getNormalVector3fMap() = s.n;
+    o.x = cfilt.x[i];
+    o.y = cfilt.y[i];
+    o.z = cfilt.z[i];
+    o.r = cfilt.r[i];
+    o.g = cfilt.g[i];
+    o.b = cfilt.b[i];
+    o.normal_x = cfilt.nx[i];
+    o.normal_y = cfilt.ny[i];
+    o.normal_z = cfilt.nz[i];
   }
-  timestamp = data.filt_timestamp;
-  pose = data.filt_pose;
-  data.unlock();
 }
 
 /**
@@ -173,28 +188,33 @@ void TSFVisualSLAM::getFilteredCloudNormals(pcl::PointCloud<pcl::PointXYZRGBNorm
 void TSFVisualSLAM::getFilteredCloudNormals(pcl::PointCloud<pcl::PointXYZRGBNormal> &cloud, std::vector<float> &radius, Eigen::Matrix4f &pose, uint64_t &timestamp)
 {
   data.lock();
-  v4r::DataMatrix2D<Surfel> &cfilt = *data.filt_cloud;
+  SurfelCloudSoA::ConstPtr filt_cloud = data.filt_cloud;
+  timestamp = data.filt_timestamp;
+  pose = data.filt_pose;
+  data.unlock();
+
+  // the published cloud is shared, hence normals are computed on a copy
+  SurfelCloudSoA cfilt = *filt_cloud;
   tsfDataIntegration.computeRadius(cfilt, intrinsic);
-  cloud.resize(cfilt.data.size());
+  TSFDataIntegration::computeNormals(cfilt);
+  cloud.resize(cfilt.size());
   cloud.width = cfilt.cols;
   cloud.height = cfilt.rows;
   cloud.is_dense = false;
-  radius.resize(cloud.points.size());
-  TSFDataIntegration::computeNormals(cfilt);
-  for (unsigned i=0; i<cfilt.data.size(); i++)
+  for (int i=0; i<cfilt.size(); i++)
   {
-    const Surfel &s = cfilt.data[i];
     pcl::PointXYZRGBNormal &o = cloud.points[i];
-    o.getVector3fMap() = s.pt;
-    o.r = s.r;
-    o.g = s.g;
-    o.b = s.b;
-    o.getNormalVector3fMap() = s.n;
-    radius[i] = s.radius;
+    o.x = cfilt.x[i];
+    o.y = cfilt.y[i];
+    o.z = cfilt.z[i];
+    o.r = cfilt.r[i];
+    o.g = cfilt.g[i];
+    o.b = cfilt.b[i];
+    o.normal_x = cfilt.nx[i];
+    o.normal_y = cfilt.ny[i];
+    o.normal_z = cfilt.nz[i];
   }
-  timestamp = data.filt_timestamp;
-  pose = data.filt_pose;
-  data.unlock();
+  radius.assign(cfilt.radius.begin(), cfilt.radius.end());
 }
 
 /**
@@ -206,29 +226,26 @@ void TSFVisualSLAM::getFilteredCloudNormals(pcl::PointCloud<pcl::PointXYZRGBNorm
 void TSFVisualSLAM::getFilteredCloudNormals(pcl::PointCloud<pcl::PointXYZRGB> &cloud, pcl::PointCloud<pcl::Normal> &normals, Eigen::Matrix4f &pose, uint64_t &timestamp)
 {
   data.lock();
-  v4r::DataMatrix2D<Surfel> &cfilt = *data.filt_cloud;
-  cloud.resize(cfilt.data.size());
-  cloud.width = cfilt.cols;
-  cloud.height = cfilt.rows;
-  cloud.is_dense = false;
-  normals.resize(cfilt.data.size());
+  SurfelCloudSoA::ConstPtr filt_cloud = data.filt_cloud;
+  timestamp = data.filt_timestamp;
+  pose = data.filt_pose;
+  data.unlock();
+
+  // the published cloud is shared, hence normals are computed on a copy
+  SurfelCloudSoA cfilt = *filt_cloud;
+  TSFDataIntegration::computeNormals(cfilt);
+  TSFData::convert(cfilt, cloud);
+  normals.resize(cfilt.size());
   normals.width = cfilt.cols;
   normals.height = cfilt.rows;
   normals.is_dense = false;
-  TSFDataIntegration::computeNormals(cfilt);
-  for (unsigned i=0; i<cfilt.data.size(); i++)
+  for (int i=0; i<cfilt.size(); i++)
   {
-    const Surfel &s = cfilt.data[i];
-    pcl::PointXYZRGB &o = cloud.points[i];
-    o.getVector3fMap() = s.pt;
-    o.r = s.r;
-    o.g = s.g;
-    o.b = s.b;
-    normals.points[i].getNormalVector3fMap() = s.n;
+    pcl::Normal &n = normals.points[i];
+    n.normal_x = cfilt.nx[i];
+    n.normal_y = cfilt.ny[i];
+    n.normal_z = cfilt.nz[i];
   }
-  timestamp = data.filt_timestamp;
-  pose = data.filt_pose;
-  data.unlock();
 }
 
 /**
@@ -239,23 +256,12 @@ void TSFVisualSLAM::getFilteredCloudNormals(pcl::PointCloud<pcl::PointXYZRGB> &c
 void TSFVisualSLAM::getFilteredCloud(pcl::PointCloud<pcl::PointXYZRGB> &cloud, Eigen::Matrix4f &pose, uint64_t &timestamp)
 {
   data.lock();
-  const v4r::DataMatrix2D<Surfel> &cfilt = *data.filt_cloud;
-  cloud.resize(cfilt.data.size());
-  cloud.width = cfilt.cols;
-  cloud.height = cfilt.rows;
-  cloud.is_dense = false;
-  for (unsigned i=0; i<cfilt.data.size(); i++)
-  {
-    const Surfel &s = cfilt.data[i];
-    pcl::PointXYZRGB &o = cloud.points[i];
-    o.getVector3fMap() = s.pt;
-    o.r = s.r;
-    o.g = s.g;
-    o.b = s.b;
-  }
+  SurfelCloudSoA::ConstPtr filt_cloud = data.filt_cloud;
   timestamp = data.filt_timestamp;
   pose = data.filt_pose;
   data.unlock();
+
+  TSFData::convert(*filt_cloud, cloud);
 }
 
 /**
@@ -267,11 +273,50 @@ void TSFVisualSLAM::getFilteredCloud(pcl::PointCloud<pcl::PointXYZRGB> &cloud, E
 void TSFVisualSLAM::getSurfelCloud(v4r::DataMatrix2D<Surfel> &cloud, Eigen::Matrix4f &pose, uint64_t &timestamp, bool need_normals)
 {
   data.lock();
-  cloud = *data.filt_cloud;
+  SurfelCloudSoA::ConstPtr filt_cloud = data.filt_cloud;
   timestamp = data.filt_timestamp;
   pose = data.filt_pose;
   data.unlock();
-  if (need_normals) TSFDataIntegration::computeNormals(cloud);
+
+  if (need_normals)
+  {
+    SurfelCloudSoA cfilt = *filt_cloud;
+    TSFDataIntegration::computeNormals(cfilt);
+    cfilt.toSurfels(cloud);
+  }
+  else filt_cloud->toSurfels(cloud);
+}
+
+/**
+ * @brief TSFVisualSLAM::waitForFilteredCloud blocks until the frame with the given timestamp or a newer one has been integrated
+ * (the integration thread only processes the newest frame and may skip the requested one)
+ * @param timestamp
+ * @param timeout_ms maximum time to wait (-1 waits without timeout)
+ * @return false if the timeout expired or the data has been reset while waiting
+ */
+bool TSFVisualSLAM::waitForFilteredCloud(const uint64_t &timestamp, int timeout_ms)
+{
+  const uint64_t none = std::numeric_limits<uint64_t>::max();   // filt_timestamp as long as no frame has been integrated (after init/reset)
+  if (timestamp==none) return false;
+
+  boost::unique_lock<boost::mutex> lock(data.mtx_shm);
+  boost::system_time const until = boost::get_system_time() + boost::posix_time::milliseconds(timeout_ms);
+  bool integrated = (data.filt_timestamp!=none);
+  while (!integrated || data.filt_timestamp<timestamp)
+  {
+    bool notified = true;
+    if (timeout_ms<0) data.cnd_filt_cloud.wait(lock);
+    else notified = data.cnd_filt_cloud.timed_wait(lock, until);
+
+    if (data.filt_timestamp==none)
+    {
+      if (integrated) return false;   // reset while waiting
+    }
+    else integrated = true;
+
+    if (!notified) return integrated && data.filt_timestamp>=timestamp;
+  }
+  return true;
 }
 
 
@@ -57,17 +57,20 @@ public:
   {
   public:
     float dist_thr;
+    bool use_index;   ///< search nearest neighbours with a dynamic kd-tree instead of a linear scan (same result, much faster for large sample sets)
 
-    Parameter(float _dist_thr=0.4)
-     : dist_thr(_dist_thr) {}
+    Parameter(float _dist_thr=0.4, bool _use_index=true)
+     : dist_thr(_dist_thr), use_index(_use_index) {}
   };
 
 private:
   std::vector< Cluster::Ptr > clusters;
 
-  int getNearestNeighbour(const Cluster &cluster, const std::vector<Cluster::Ptr> &clusters, float &sim);
   void agglomerate(const Cluster &src, Cluster &dst);
 
+  template<class ClusterSet>
+  void clusterChains(ClusterSet &remaining);
+
   void initDataStructure(const DataMatrix2Df &samples, std::vector< Cluster::Ptr > &data);
 
 
@@ -190,6 +190,17 @@ public:
 //        visualize_graph_ = false;
     }
 
+    /**
+     * @brief creates a new grouping instance with the same parameters but without any input, scene or correspondences set.
+     * Use this to get an independent instance per thread, as clustering mutates the object state.
+     * @return fresh grouping instance
+     */
+    boost::shared_ptr<GraphGeometricConsistencyGrouping<PointModelT, PointSceneT> >
+    clone() const
+    {
+        return boost::shared_ptr<GraphGeometricConsistencyGrouping<PointModelT, PointSceneT> > (new GraphGeometricConsistencyGrouping<PointModelT, PointSceneT> (param_) );
+    }
+
     inline
     bool poseExists(const Eigen::Matrix4f &corr_rej_trans)
     {
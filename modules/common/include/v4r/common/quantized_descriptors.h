@@ -0,0 +1,184 @@
+/******************************************************************************
+ * Copyright (c) 2017, Vision4Robotics group, TU Vienna
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+/**
+*
+*      @brief 8 bit quantization of feature descriptors (e.g. SIFT, SHOT) and FLANN distance functors working on them
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <v4r/core/macros.h>
+
+namespace v4r
+{
+
+/**
+ * @brief Linear quantization of each descriptor dimension into 8 bit, i.e. value = offset[dim] + scale[dim] * quantized value.
+ * The offset and scale of each dimension are computed from the range of the training descriptors.
+ */
+class V4R_EXPORTS DescriptorQuantizer
+{
+private:
+    std::vector<float> offset_;
+    std::vector<float> scale_;
+
+public:
+    /**
+     * @brief computes offset and scale of each dimension from the given descriptors
+     * @param data descriptors (row-major, rows x cols)
+     */
+    void
+    compute(const float *data, size_t rows, size_t cols);
+
+    void
+    set(const std::vector<float> &offset, const std::vector<float> &scale);
+
+    /**
+     * @brief quantizes descriptors (row-major, rows x dimensions()). Values outside the trained range are clamped.
+     */
+    void
+    quantize(const float *src, size_t rows, unsigned char *dst) const;
+
+    /**
+     * @brief reconstructs descriptors (row-major, rows x dimensions()) from their quantized values
+     */
+    void
+    dequantize(const unsigned char *src, size_t rows, float *dst) const;
+
+    size_t
+    dimensions() const
+    {
+        return offset_.size();
+    }
+
+    const std::vector<float> &
+    getOffset() const
+    {
+        return offset_;
+    }
+
+    const std::vector<float> &
+    getScale() const
+    {
+        return scale_;
+    }
+};
+
+/**
+ * @brief squared L2 distance of two quantized descriptors in units of the original descriptors
+ * @param weights squared scale of each dimension
+ */
+V4R_EXPORTS float
+quantizedL2Distance(const unsigned char *a, const unsigned char *b, const float *weights, size_t size);
+
+/**
+ * @brief L1 distance of two quantized descriptors in units of the original descriptors
+ * @param weights scale of each dimension
+ */
+V4R_EXPORTS float
+quantizedL1Distance(const unsigned char *a, const unsigned char *b, const float *weights, size_t size);
+
+
+/**
+ * @brief FLANN distance functor for quantized descriptors which returns the same values as flann::L2<float> (squared L2 distance)
+ * on the dequantized descriptors
+ */
+struct QuantizedL2
+{
+    typedef bool is_kdtree_distance;
+    typedef bool is_vector_space_distance;
+
+    typedef unsigned char ElementType;
+    typedef float ResultType;
+
+    boost::shared_ptr<const std::vector<float> > weights_;  ///< squared scale of each dimension
+
+    QuantizedL2() { }
+
+    explicit QuantizedL2(const DescriptorQuantizer &q)
+    {
+        boost::shared_ptr<std::vector<float> > w (new std::vector<float>( q.getScale() ));
+        for(float &v : *w)
+            v *= v;
+        weights_ = w;
+    }
+
+    template <typename Iterator1, typename Iterator2>
+    ResultType
+    operator()(Iterator1 a, Iterator2 b, size_t size, ResultType worst_dist = -1) const
+    {
+        (void) worst_dist;
+        return quantizedL2Distance( &a[0], &b[0], weights_->data(), size );
+    }
+
+    template <typename U, typename V>
+    ResultType
+    accum_dist(const U &a, const V &b, int dim) const
+    {
+        const float diff = static_cast<float>(a) - static_cast<float>(b);
+        return (*weights_)[dim] * diff * diff;
+    }
+};
+
+/**
+ * @brief FLANN distance functor for quantized descriptors which returns the same values as flann::L1<float> on the dequantized descriptors
+ */
+struct QuantizedL1
+{
+    typedef bool is_kdtree_distance;
+    typedef bool is_vector_space_distance;
+
+    typedef unsigned char ElementType;
+    typedef float ResultType;
+
+    boost::shared_ptr<const std::vector<float> > weights_;  ///< scale of each dimension
+
+    QuantizedL1() { }
+
+    explicit QuantizedL1(const DescriptorQuantizer &q)
+        : weights_ ( new std::vector<float>( q.getScale() ) )
+    { }
+
+    template <typename Iterator1, typename Iterator2>
+    ResultType
+    operator()(Iterator1 a, Iterator2 b, size_t size, ResultType worst_dist = -1) const
+    {
+        (void) worst_dist;
+        return quantizedL1Distance( &a[0], &b[0], weights_->data(), size );
+    }
+
+    template <typename U, typename V>
+    ResultType
+    accum_dist(const U &a, const V &b, int dim) const
+    {
+        return (*weights_)[dim] * std::abs( static_cast<float>(a) - static_cast<float>(b) );
+    }
+};
+
+}
@@ -0,0 +1,136 @@
+/******************************************************************************
+ * Copyright (c) 2017, Vision4Robotics group, TU Vienna
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+/**
+*
+*      @brief uniform grid for fixed-radius neighbor search in a static point cloud
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/unordered_map.hpp>
+#include <Eigen/Core>
+#include <pcl/point_cloud.h>
+#include <v4r/core/macros.h>
+
+namespace v4r
+{
+
+/**
+ * @brief Uniform grid with a cell size equal to the search radius. All neighbors of a query point are found in the
+ * 3x3x3 cells around it. Points are stored contiguously per cell. The grid is built once and
+ * radiusSearch is thread-safe.
+ */
+class V4R_EXPORTS RadiusSearchGrid
+{
+private:
+    struct GridPoint
+    {
+        float x, y, z;
+        int idx;  ///< index of the point in the input cloud
+    };
+
+    struct Range
+    {
+        int begin, end;
+    };
+
+    float radius_;
+    float sqr_radius_;
+    float inv_cell_size_;
+    Eigen::Vector3f origin_;    ///< minimum corner of the grid
+    std::vector<GridPoint> points_;  ///< points sorted by cell
+    boost::unordered_map<uint64_t, Range> cells_;  ///< range of points in points_ for each non-empty cell
+
+    static int
+    maxCell()
+    {
+        return (1 << 21) - 1;
+    }
+
+    uint64_t
+    cellKey(int x, int y, int z) const
+    {
+        return ( static_cast<uint64_t>(x) << 42 ) | ( static_cast<uint64_t>(y) << 21 ) | static_cast<uint64_t>(z);
+    }
+
+    void
+    build(const std::vector<GridPoint> &points);
+
+public:
+    typedef boost::shared_ptr< RadiusSearchGrid > Ptr;
+    typedef boost::shared_ptr< RadiusSearchGrid const> ConstPtr;
+
+    /**
+     * @param radius search radius (and cell size)
+     */
+    explicit RadiusSearchGrid(float radius);
+
+    /**
+     * @brief builds the grid for the given point cloud (points with non-finite coordinates are ignored)
+     */
+    template<typename PointT>
+    void
+    setInputCloud(const pcl::PointCloud<PointT> &cloud)
+    {
+        std::vector<GridPoint> points;
+        points.reserve( cloud.points.size() );
+        for(size_t i=0; i<cloud.points.size(); i++)
+        {
+            const PointT &p = cloud.points[i];
+            if( !pcl_isfinite(p.x) || !pcl_isfinite(p.y) || !pcl_isfinite(p.z) )
+                continue;
+
+            GridPoint gp;
+            gp.x = p.x;
+            gp.y = p.y;
+            gp.z = p.z;
+            gp.idx = i;
+            points.push_back(gp);
+        }
+        build( points );
+    }
+
+    /**
+     * @brief finds all points within the search radius of the query point. The output vectors are cleared first,
+     * so they can be reused for subsequent queries without reallocating memory.
+     * @param query query point
+     * @param[out] indices indices of the points within the search radius
+     * @param[out] sqr_distances squared distances of these points to the query point
+     * @return number of found points
+     */
+    size_t
+    radiusSearch(const Eigen::Vector3f &query, std::vector<int> &indices, std::vector<float> &sqr_distances) const;
+
+    float
+    getRadius() const
+    {
+        return radius_;
+    }
+};
+
+}
@@ -0,0 +1,225 @@
+/******************************************************************************
+ * Copyright (c) 2017, Vision4Robotics group, TU Vienna
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+/**
+*
+*      @brief timing and tracing of a single call (e.g. recognition of one frame)
+*/
+
+#pragma once
+
+#include <chrono>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+#include <v4r/core/macros.h>
+
+namespace v4r
+{
+
+/**
+ * @brief Collects timed spans and counters of one call. All methods are thread-safe, so a context can be shared
+ * by all components (and threads) involved in processing e.g. one frame. Spans nest by time, i.e. a span
+ * started and finished within another span on the same thread is its child.
+ */
+class V4R_EXPORTS TraceContext
+{
+public:
+    typedef boost::shared_ptr<TraceContext> Ptr;
+    typedef boost::shared_ptr<TraceContext const> ConstPtr;
+
+    enum EventType
+    {
+        SPAN,
+        COUNTER
+    };
+
+    struct Event
+    {
+        EventType type_;
+        std::string name_;
+        int64_t start_us_;  ///< start time in micro seconds since creation of the context
+        int64_t duration_us_;   ///< duration in micro seconds (only for spans)
+        double value_;  ///< value (only for counters)
+        size_t thread_; ///< index of the thread that recorded the event (in order of first appearance)
+        size_t depth_;  ///< nesting level of the span on its thread
+    };
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point start_time_;
+
+    mutable boost::mutex mutex_;
+    std::vector<Event> events_;
+    std::map<boost::thread::id, size_t> thread_ids_;
+    std::vector<size_t> open_spans_;    ///< number of currently open spans for each thread
+
+    size_t threadIndex();   ///< requires mutex_ to be locked
+
+public:
+    TraceContext();
+
+    /**
+     * @return micro seconds elapsed since creation of the context
+     */
+    int64_t
+    now() const;
+
+    /**
+     * @brief marks the begin of a span
+     * @return start time in micro seconds (to be passed to endSpan)
+     */
+    int64_t
+    beginSpan();
+
+    /**
+     * @brief records a span that started at start_us and ends now
+     * @return duration of the span in micro seconds
+     */
+    int64_t
+    endSpan(const std::string &name, int64_t start_us);
+
+    /**
+     * @brief records a counter (e.g. number of hypotheses)
+     */
+    void
+    addCounter(const std::string &name, double value);
+
+    /**
+     * @brief removes all recorded events
+     */
+    void
+    clear();
+
+    /**
+     * @return recorded events in order of their completion
+     */
+    std::vector<Event>
+    getEvents() const;
+
+    /**
+     * @brief flat list of span durations in milliseconds and counter values in order of completion
+     */
+    std::vector<std::pair<std::string, float> >
+    getElapsedTimes() const;
+
+    /**
+     * @brief writes all events in the Chrome trace event format (can be opened with chrome://tracing)
+     */
+    void
+    writeChromeTrace(std::ostream &os) const;
+
+    /**
+     * @brief writes all events in the Chrome trace event format into a file
+     */
+    void
+    saveChromeTrace(const std::string &filename) const;
+};
+
+
+/**
+ * @brief RAII helper recording a span from its construction until its destruction. If the context is empty, only logs the duration.
+ */
+class V4R_EXPORTS TraceSpan
+{
+private:
+    TraceContext *trace_;
+    std::string name_;
+    int64_t start_us_;
+    std::chrono::steady_clock::time_point start_time_;
+
+public:
+    TraceSpan(const TraceContext::Ptr &trace, const std::string &name);
+    ~TraceSpan();
+};
+
+
+/**
+ * @brief Aggregates spans and counters of many trace contexts (e.g. one per frame) into statistics
+ */
+class V4R_EXPORTS TraceStatistics
+{
+public:
+    struct Summary
+    {
+        size_t count_;
+        double mean_;
+        double min_;
+        double p50_;
+        double p90_;
+        double p99_;
+        double max_;
+    };
+
+private:
+    std::map<std::string, std::vector<double> > spans_ms_;  ///< all span durations in milliseconds
+    std::map<std::string, std::vector<double> > counters_;  ///< all counter values
+
+    static Summary
+    summarize(std::vector<double> values);
+
+public:
+    /**
+     * @brief adds all events of a trace context. Spans with the same name that occur several times within one context are summed up.
+     */
+    void
+    add(const TraceContext &trace);
+
+    void
+    clear()
+    {
+        spans_ms_.clear();
+        counters_.clear();
+    }
+
+    /**
+     * @return statistics of the span durations in milliseconds for each span name
+     */
+    std::map<std::string, Summary>
+    getSpanSummaries() const;
+
+    /**
+     * @return statistics of the values for each counter name
+     */
+    std::map<std::string, Summary>
+    getCounterSummaries() const;
+
+    /**
+     * @brief computes the given percentile (0..100) of the durations in milliseconds of a span (using nearest rank)
+     */
+    double
+    getSpanPercentile(const std::string &name, double percentile) const;
+
+    /**
+     * @brief prints a table with the statistics of all spans and counters
+     */
+    void
+    print(std::ostream &os) const;
+};
+
+}
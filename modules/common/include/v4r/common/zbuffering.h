@@ -24,6 +24,9 @@
 #ifndef V4R_ZBUFFERING_H_
 #define V4R_ZBUFFERING_H_
 
+#include <atomic>
+#include <memory>
+
 #include <boost/dynamic_bitset.hpp>
 #include <pcl/common/common.h>
 #include <pcl/common/transforms.h>
@@ -69,15 +72,30 @@ class V4R_EXPORTS ZBuffering
 
 private:
     ZBufferingParameter param_;
-    std::vector<float> depth_;
+    std::vector<float> depth_;  ///< depth of each pixel of the rendered view (row-major)
+    std::vector<int> index_plane_;  ///< index of the input point each pixel of the rendered view represents (row-major, -1 for non-occupied pixels)
     std::vector<int> kept_indices_;
     Camera::ConstPtr cam_;   ///< camera parameters
     Eigen::MatrixXi index_map_; ///< saves for each pixel which indices of the input cloud it represents. Non-occupied pixels are labelled with index -1.
     pcl::PointCloud<pcl::Normal>::ConstPtr cloud_normals_;
 
+    /**
+     * @brief fillHoles replaces each pixel (except the ones within smoothing radius to the image boundary) by the closest point within the smoothing radius (separable min-filter over depth and index plane)
+     */
+    void fillHoles(size_t width, size_t height);
+
+    /**
+     * @brief removeNoise marks pixels without finite depth (except the ones within smoothing radius to the image boundary) as non-occupied (NaN depth, index -1).
+     * The inlier threshold is not used.
+     */
+    void removeNoise(size_t width, size_t height);
+
+    std::unique_ptr<std::atomic<uint64_t>[]> zbuffer_; ///< for each pixel the depth (upper 32 bit, order-preserving) and index (lower 32 bit) of the closest point. Kept across calls to avoid reallocation.
+    size_t zbuffer_size_; ///< number of allocated pixels in zbuffer_
+
 public:
     ZBuffering (const Camera::ConstPtr cam, const ZBufferingParameter &p=ZBufferingParameter()) :
-        param_(p), cam_ (cam) { }
+        param_(p), cam_ (cam), zbuffer_size_ (0) { }
 
     void
     setCamera(const Camera::ConstPtr cam)
@@ -93,7 +111,8 @@ public:
 
 
     /**
-     * @brief renderPointCloud renders a point cloud using the given camera parameters
+     * @brief renderPointCloud renders a point cloud using the given camera parameters. The z-buffer is lock-free (atomic depth+index updates)
+     * and its memory is reused if the same object renders multiple clouds of the same image size.
      * @param cloud input point cloud
      * @param rendered_view[out] rendered point cloud
      * @param subsample subsampling step size n. If greater 1, will only use every n-th point for rendering
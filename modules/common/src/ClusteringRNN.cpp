@@ -28,6 +28,7 @@
 
 
 #include <v4r/common/ClusteringRNN.h>
+#include <algorithm>
 
 
 namespace v4r
@@ -36,52 +37,351 @@ namespace v4r
 using namespace std;
 
 
+namespace
+{
 
-
-ClusteringRNN::ClusteringRNN(const Parameter &_param, bool _dbg)
- : param(_param), dbg(_dbg)
+/**
+ * Clusters which are not part of the current chain, kept in the order of the original
+ * implementation (appended at the end, removed without reordering). Nearest neighbours
+ * are searched with a linear scan.
+ */
+class LinearClusterSet
 {
-}
+private:
+  std::vector< Cluster::Ptr > clusters;
 
-ClusteringRNN::~ClusteringRNN()
+public:
+  void init(std::vector< Cluster::Ptr > &data) { clusters.swap(data); }
+  bool empty() const { return clusters.empty(); }
+  void push_back(const Cluster::Ptr &c) { clusters.push_back(c); }
+
+  Cluster::Ptr pop_back()
+  {
+    Cluster::Ptr c = clusters.back();
+    clusters.pop_back();
+    return c;
+  }
+
+  Cluster::Ptr take(int idx)
+  {
+    Cluster::Ptr c = clusters[idx];
+    clusters.erase(clusters.begin()+idx);
+    return c;
+  }
+
+  /**
+   * find nearest neighbour of CodebookEntries
+   */
+  int getNearestNeighbour(const Cluster &cluster, float &sim) const
+  {
+    sim = -FLT_MAX;
+    int idx = INT_MAX;
+    float tmp;
+
+    for (unsigned i=0; i<clusters.size(); i++)
+    {
+      tmp = -( cluster.sqr_sigma + clusters[i]->sqr_sigma +
+               (cluster.data-clusters[i]->data).squaredNorm() );
+      if (tmp > sim)
+      {
+        sim = tmp;
+        idx = i;
+      }
+    }
+
+    return idx;
+  }
+};
+
+
+/**
+ * Same as LinearClusterSet, but the clusters are stored in a dynamic kd-tree (bounding
+ * boxes of the means plus the smallest sqr_sigma of each subtree). Clusters are identified
+ * by the order they have been added (key), so that ties are resolved exactly like the
+ * linear scan. Removing a cluster only decrements the counters of the tree (boxes stay
+ * valid lower bounds), overfull leafs are split and the tree is rebuilt from time to time.
+ */
+class KdClusterSet
 {
-}
+private:
+  struct Node
+  {
+    int parent;
+    int left, right;          ///< children (-1 for leafs)
+    int split_dim;
+    float split_val;
+    Eigen::VectorXf min_pt, max_pt;
+    float min_sqr_sigma;
+    int size;                 ///< number of clusters in the subtree
+    std::vector<int> keys;    ///< clusters of a leaf
+  };
+
+  struct Entry
+  {
+    Cluster::Ptr cluster;
+    int leaf;                 ///< -1 if removed
+    int pos;                  ///< position in the leaf
+  };
+
+  static const int leaf_size = 16;
+
+  int dims;
+  int root;
+  int num;
+  int num_modified;           ///< number of insertions and removals since the last rebuild
+  std::vector<Entry> entries; ///< indexed by key
+  std::vector<int> order;     ///< keys in increasing order (may contain removed ones)
+  std::vector<Node> nodes;
+
+  int createNode(int parent, std::vector<int> &keys, int begin, int end)
+  {
+    nodes.push_back(Node());
+    int n = nodes.size()-1;
+    Node &node = nodes[n];
+    node.parent = parent;
+    node.left = node.right = -1;
+    node.split_dim = 0;
+    node.split_val = 0;
+    node.min_pt = Eigen::VectorXf::Constant(dims, FLT_MAX);
+    node.max_pt = Eigen::VectorXf::Constant(dims, -FLT_MAX);
+    node.min_sqr_sigma = FLT_MAX;
+    node.size = end-begin;
+
+    for (int i=begin; i<end; i++)
+    {
+      const Cluster &c = *entries[keys[i]].cluster;
+      node.min_pt = node.min_pt.cwiseMin(c.data);
+      node.max_pt = node.max_pt.cwiseMax(c.data);
+      node.min_sqr_sigma = std::min(node.min_sqr_sigma, c.sqr_sigma);
+    }
 
+    if (end-begin <= leaf_size)
+    {
+      for (int i=begin; i<end; i++)
+        addToLeaf(n, keys[i]);
+    }
+    else split(n, keys, begin, end);
 
+    return n;
+  }
 
+  void split(int n, std::vector<int> &keys, int begin, int end)
+  {
+    int dim;
+    (nodes[n].max_pt-nodes[n].min_pt).maxCoeff(&dim);
+    int mid = (begin+end)/2;
+    std::nth_element(keys.begin()+begin, keys.begin()+mid, keys.begin()+end, CmpDim(entries, dim));
+
+    nodes[n].split_dim = dim;
+    nodes[n].split_val = entries[keys[mid]].cluster->data[dim];
+    nodes[n].keys.clear();
+
+    int left = createNode(n, keys, begin, mid);
+    int right = createNode(n, keys, mid, end);
+    nodes[n].left = left;
+    nodes[n].right = right;
+  }
 
-/************************************** PRIVATE ************************************/
+  struct CmpDim
+  {
+    const std::vector<Entry> &entries;
+    int dim;
+    CmpDim(const std::vector<Entry> &_entries, int _dim) : entries(_entries), dim(_dim) {}
+    bool operator()(int a, int b) const { return entries[a].cluster->data[dim] < entries[b].cluster->data[dim]; }
+  };
 
+  void addToLeaf(int n, int key)
+  {
+    entries[key].leaf = n;
+    entries[key].pos = nodes[n].keys.size();
+    nodes[n].keys.push_back(key);
+  }
 
+  void rebuild()
+  {
+    std::vector<int> keys;
+    keys.reserve(num);
+    for (unsigned i=0; i<order.size(); i++)
+      if (entries[order[i]].leaf >= 0)
+        keys.push_back(order[i]);
+
+    nodes.clear();
+    root = createNode(-1, keys, 0, keys.size());
+    num_modified = 0;
+  }
 
+  void checkRebuild()
+  {
+    if (num_modified > std::max(num, leaf_size))
+      rebuild();
+  }
 
+  void insert(int key)
+  {
+    const Cluster &c = *entries[key].cluster;
+    int n = root;
 
-/************************************** PUBLIC ************************************/
+    while (true)
+    {
+      Node &node = nodes[n];
+      node.min_pt = node.min_pt.cwiseMin(c.data);
+      node.max_pt = node.max_pt.cwiseMax(c.data);
+      node.min_sqr_sigma = std::min(node.min_sqr_sigma, c.sqr_sigma);
+      node.size++;
+      if (node.left < 0)
+        break;
+      n = ( c.data[node.split_dim] < node.split_val ? node.left : node.right );
+    }
 
+    addToLeaf(n, key);
 
-/**
- * find nearest neighbour of CodebookEntries
- */
-int ClusteringRNN::getNearestNeighbour(const Cluster &cluster, const std::vector<Cluster::Ptr> &_clusters, float &sim)
-{
-  sim = -FLT_MAX;
-  int idx = INT_MAX;
-  float tmp;
+    if ((int)nodes[n].keys.size() > 2*leaf_size)
+    {
+      std::vector<int> keys = nodes[n].keys;
+      split(n, keys, 0, keys.size());
+    }
+  }
 
-  for (unsigned i=0; i<_clusters.size(); i++)
+  void search(int n, const Cluster &q, float &best_dist, int &best_key) const
   {
-    tmp = -( cluster.sqr_sigma + _clusters[i]->sqr_sigma +
-             (cluster.data-_clusters[i]->data).squaredNorm() );
-    if (tmp > sim)
+    const Node &node = nodes[n];
+
+    if (node.left < 0)
+    {
+      for (unsigned i=0; i<node.keys.size(); i++)
+      {
+        int key = node.keys[i];
+        const Cluster &c = *entries[key].cluster;
+        float dist = q.sqr_sigma + c.sqr_sigma + (q.data-c.data).squaredNorm();
+        if (dist < best_dist || (dist == best_dist && key < best_key))
+        {
+          best_dist = dist;
+          best_key = key;
+        }
+      }
+      return;
+    }
+
+    float lb_left = lowerBound(node.left, q);
+    float lb_right = lowerBound(node.right, q);
+    int first = node.left, second = node.right;
+    if (lb_right < lb_left)
     {
-      sim = tmp;
-      idx = i;
+      std::swap(first, second);
+      std::swap(lb_left, lb_right);
     }
+
+    // the bounds are computed in a different order than the distances -> be conservative w.r.t. rounding
+    if (nodes[first].size > 0 && lb_left*(1.f-1e-4f) <= best_dist)
+      search(first, q, best_dist, best_key);
+    if (nodes[second].size > 0 && lb_right*(1.f-1e-4f) <= best_dist)
+      search(second, q, best_dist, best_key);
+  }
+
+  float lowerBound(int n, const Cluster &q) const
+  {
+    const Node &node = nodes[n];
+    return q.sqr_sigma + node.min_sqr_sigma +
+           (node.min_pt-q.data).cwiseMax(q.data-node.max_pt).cwiseMax(0.f).squaredNorm();
   }
 
-  return idx;
+public:
+  KdClusterSet() : dims(0), root(-1), num(0), num_modified(0) {}
+
+  void init(std::vector< Cluster::Ptr > &data)
+  {
+    dims = ( data.size()>0 ? data[0]->data.size() : 0 );
+    num = data.size();
+    entries.resize(data.size());
+    order.resize(data.size());
+    for (unsigned i=0; i<data.size(); i++)
+    {
+      entries[i].cluster = data[i];
+      order[i] = i;
+    }
+    data.clear();
+    rebuild();
+  }
+
+  bool empty() const { return num==0; }
+
+  void push_back(const Cluster::Ptr &c)
+  {
+    int key = entries.size();
+    entries.push_back(Entry());
+    entries.back().cluster = c;
+    order.push_back(key);
+    insert(key);
+    num++;
+    num_modified++;
+    checkRebuild();
+  }
+
+  Cluster::Ptr pop_back()
+  {
+    while (entries[order.back()].leaf < 0)
+      order.pop_back();
+    int key = order.back();
+    order.pop_back();
+    return take(key);
+  }
+
+  Cluster::Ptr take(int key)
+  {
+    Entry &e = entries[key];
+    std::vector<int> &keys = nodes[e.leaf].keys;
+    keys[e.pos] = keys.back();
+    entries[keys[e.pos]].pos = e.pos;
+    keys.pop_back();
+
+    for (int n=e.leaf; n>=0; n=nodes[n].parent)
+      nodes[n].size--;
+
+    Cluster::Ptr c = e.cluster;
+    e.cluster = Cluster::Ptr();
+    e.leaf = -1;
+    num--;
+    num_modified++;
+    checkRebuild();
+    return c;
+  }
+
+  int getNearestNeighbour(const Cluster &cluster, float &sim) const
+  {
+    float best_dist = FLT_MAX;
+    int best_key = INT_MAX;
+    search(root, cluster, best_dist, best_key);
+    sim = -best_dist;
+    return best_key;
+  }
+};
+
 }
 
+
+
+
+ClusteringRNN::ClusteringRNN(const Parameter &_param, bool _dbg)
+ : param(_param), dbg(_dbg)
+{
+}
+
+ClusteringRNN::~ClusteringRNN()
+{
+}
+
+
+
+
+/************************************** PRIVATE ************************************/
+
+
+
+
+
+/************************************** PUBLIC ************************************/
+
+
 /**
  * Agglomerate
  */
@@ -117,40 +417,33 @@ void ClusteringRNN::initDataStructure(const DataMatrix2Df &samples, std::vector<
   }
 }
 
-
 /**
- * create clusters
+ * grow nearest neighbour chains and agglomerate reciprocal nearest neighbours
  */
-void ClusteringRNN::cluster(const DataMatrix2Df &samples)
+template<class ClusterSet>
+void ClusteringRNN::clusterChains(ClusterSet &remaining)
 {
   int nn, last;
   float sim;
   std::vector<float> lastsim;
   std::vector< Cluster::Ptr > chain;
-  std::vector< Cluster::Ptr > remaining;
-
-  initDataStructure(samples, remaining);  
-
-  clusters.clear();
 
-  if (remaining.size()==0)
+  if (remaining.empty())
     return;
 
   last=0;
   lastsim.push_back(-FLT_MAX);
 
-  chain.push_back(remaining.back());
-  remaining.pop_back();
+  chain.push_back(remaining.pop_back());
   float sqrThr = -param.dist_thr*param.dist_thr;
 
-  while (remaining.size()!=0){
-    nn = getNearestNeighbour(*chain[last], remaining, sim);
+  while (!remaining.empty()){
+    nn = remaining.getNearestNeighbour(*chain[last], sim);
 
     if(sim > lastsim[last]){
       //no RNN -> add to chain
       last++;
-      chain.push_back(remaining[nn]);
-      remaining.erase(remaining.begin()+nn);
+      chain.push_back(remaining.take(nn));
       lastsim.push_back(sim);
     } else {
       //RNN found
@@ -173,7 +466,7 @@ void ClusteringRNN::cluster(const DataMatrix2Df &samples)
         if (dbg){ printf("."); fflush(stdout); }
       }
     }
-    if (remaining.size()==0)
+    if (remaining.empty())
     {
       if (lastsim[last] > sqrThr){
         agglomerate(*chain[last-1], *chain[last]);
@@ -186,19 +479,47 @@ void ClusteringRNN::cluster(const DataMatrix2Df &samples)
       }
     }
 
-    if (last<0 && remaining.size()>0){
+    if (last<0 && !remaining.empty()){
       //init new chain
       last++;
       lastsim.push_back(-FLT_MAX);
 
-      chain.push_back(remaining.back());
-      remaining.pop_back();
+      chain.push_back(remaining.pop_back());
     }
   }
 
   for (unsigned i=0; i<chain.size(); i++){
     clusters.push_back(chain[i]);
-  }  
+  }
+}
+
+
+/**
+ * create clusters
+ */
+void ClusteringRNN::cluster(const DataMatrix2Df &samples)
+{
+  std::vector< Cluster::Ptr > data;
+
+  initDataStructure(samples, data);
+
+  clusters.clear();
+
+  if (data.size()==0)
+    return;
+
+  if (param.use_index)
+  {
+    KdClusterSet remaining;
+    remaining.init(data);
+    clusterChains(remaining);
+  }
+  else
+  {
+    LinearClusterSet remaining;
+    remaining.init(data);
+    clusterChains(remaining);
+  }
 
   if (dbg) cout<<endl;
   //if (dbg) cout<<"clusters.size()="<<clusters.size()<<endl;
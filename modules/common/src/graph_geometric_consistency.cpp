@@ -6,11 +6,15 @@
 #include <pcl/common/time.h>
 #include <pcl/point_types.h>
 #include <boost/unordered_map.hpp>
+#include <boost/graph/adjacency_list.hpp>
 #include <boost/graph/connected_components.hpp>
 #include <boost/graph/copy.hpp>
 #include <boost/graph/biconnected_components.hpp>
 #include <boost/graph/prim_minimum_spanning_tree.hpp>
+#include <algorithm>
+#include <cmath>
 #include <exception>
+#include <limits>
 
 struct V4R_EXPORTS ExtendedClique
 {
@@ -34,6 +38,187 @@ gcGraphCorrespSorter (pcl::Correspondence i, pcl::Correspondence j)
     return i.distance < j.distance;
 }
 
+/**
+ * @brief undirected graph in compressed sparse row format. The neighbors of each vertex are sorted in ascending order.
+ */
+struct CorrespondenceGraphCSR
+{
+    std::vector<size_t> offsets_;   ///< neighbors of vertex v are stored in neighbors_[ offsets_[v] ] ... neighbors_[ offsets_[v+1] - 1 ]
+    std::vector<size_t> neighbors_;
+    std::vector<size_t> edge_ids_;  ///< index of the edge (in the edge list the graph was built from) connecting the vertex to the respective neighbor
+    size_t num_edges_;
+
+    CorrespondenceGraphCSR() : num_edges_ (0) {}
+
+    /**
+     * @brief builds the graph from an edge list
+     * @param num_vertices number of vertices
+     * @param edges edges (a,b) with a < b in lexicographical order
+     * @param edge_ids index of the edges within the original edge list (if empty, position in edges is used)
+     */
+    void
+    build(size_t num_vertices, const std::vector<std::pair<size_t, size_t> > &edges, const std::vector<size_t> &edge_ids = std::vector<size_t>())
+    {
+        offsets_.assign(num_vertices + 1, 0);
+        for(const std::pair<size_t, size_t> &e : edges)
+        {
+            offsets_[ e.first + 1 ]++;
+            offsets_[ e.second + 1 ]++;
+        }
+
+        for(size_t v = 0; v < num_vertices; v++)
+            offsets_[v + 1] += offsets_[v];
+
+        neighbors_.resize( offsets_.back() );
+        edge_ids_.resize( offsets_.back() );
+        num_edges_ = edges.size();
+
+        // since edges are sorted, each vertex first receives its smaller neighbors (in ascending order) and then its larger ones
+        std::vector<size_t> fill ( offsets_.begin(), offsets_.end() - 1 );
+        for(size_t e_id = 0; e_id < edges.size(); e_id++)
+        {
+            const std::pair<size_t, size_t> &e = edges[e_id];
+            const size_t id = edge_ids.empty() ? e_id : edge_ids[e_id];
+            neighbors_[ fill[e.first] ] = e.second;
+            edge_ids_[ fill[e.first]++ ] = id;
+            neighbors_[ fill[e.second] ] = e.first;
+            edge_ids_[ fill[e.second]++ ] = id;
+        }
+    }
+
+    size_t
+    numVertices() const
+    {
+        return offsets_.empty() ? 0 : offsets_.size() - 1;
+    }
+
+    size_t
+    degree(size_t v) const
+    {
+        return offsets_[v + 1] - offsets_[v];
+    }
+
+    bool
+    hasEdge(size_t u, size_t v) const
+    {
+        return std::binary_search( neighbors_.begin() + offsets_[u], neighbors_.begin() + offsets_[u + 1], v);
+    }
+};
+
+/**
+ * @brief positions and normals of the scene and model points of each correspondence, stored as structure of arrays
+ */
+struct CorrespondenceEndpoints
+{
+    std::vector<int> scene_idx_, model_idx_;
+    std::vector<float> sx_, sy_, sz_, snx_, sny_, snz_;
+    std::vector<float> mx_, my_, mz_, mnx_, mny_, mnz_;
+
+    template<typename PointModelT, typename PointSceneT>
+    void
+    gather(const pcl::Correspondences &corrs,
+           const pcl::PointCloud<PointSceneT> &scene, const pcl::PointCloud<pcl::Normal> &scene_normals,
+           const pcl::PointCloud<PointModelT> &model, const pcl::PointCloud<pcl::Normal> &model_normals)
+    {
+        const size_t n = corrs.size();
+        scene_idx_.resize(n); model_idx_.resize(n);
+        sx_.resize(n); sy_.resize(n); sz_.resize(n); snx_.resize(n); sny_.resize(n); snz_.resize(n);
+        mx_.resize(n); my_.resize(n); mz_.resize(n); mnx_.resize(n); mny_.resize(n); mnz_.resize(n);
+
+        for(size_t k = 0; k < n; k++)
+        {
+            scene_idx_[k] = corrs[k].index_match;
+            model_idx_[k] = corrs[k].index_query;
+            const PointSceneT &sp = scene.at( scene_idx_[k] );
+            const pcl::Normal &sn = scene_normals.at( scene_idx_[k] );
+            const PointModelT &mp = model.at( model_idx_[k] );
+            const pcl::Normal &mn = model_normals.at( model_idx_[k] );
+            sx_[k] = sp.x; sy_[k] = sp.y; sz_[k] = sp.z;
+            snx_[k] = sn.normal_x; sny_[k] = sn.normal_y; snz_[k] = sn.normal_z;
+            mx_[k] = mp.x; my_[k] = mp.y; mz_[k] = mp.z;
+            mnx_[k] = mn.normal_x; mny_[k] = mn.normal_y; mnz_[k] = mn.normal_z;
+        }
+    }
+
+    size_t
+    size() const
+    {
+        return scene_idx_.size();
+    }
+};
+
+/**
+ * @brief computes all pairs of geometrically consistent correspondences. Rows are processed in parallel,
+ * each row in tiles of fixed size whose constraints are evaluated without branches.
+ * @param[out] edges consistent pairs (k,j) with k < j in lexicographical order
+ */
+void
+computeConsistentPairs(const CorrespondenceEndpoints &e, float min_dist_for_cluster, float gc_size,
+                       bool check_normals_orientation, float thres_dot_distance,
+                       std::vector<std::pair<size_t, size_t> > &edges)
+{
+    const size_t n = e.size();
+    const size_t tile_size = 64;
+    std::vector< std::vector<size_t> > row_neighbors (n);
+
+#pragma omp parallel for schedule(dynamic, 16)
+    for (size_t k = 0; k < n; k++)
+    {
+        const int scene_index_k = e.scene_idx_[k], model_index_k = e.model_idx_[k];
+        const float sx = e.sx_[k], sy = e.sy_[k], sz = e.sz_[k], snx = e.snx_[k], sny = e.sny_[k], snz = e.snz_[k];
+        const float mx = e.mx_[k], my = e.my_[k], mz = e.mz_[k], mnx = e.mnx_[k], mny = e.mny_[k], mnz = e.mnz_[k];
+        unsigned char consistent[tile_size];
+
+        for (size_t tile_start = k + 1; tile_start < n; tile_start += tile_size)
+        {
+            const size_t tile_end = std::min(n, tile_start + tile_size);
+            const size_t len = tile_end - tile_start;
+
+            for (size_t t = 0; t < len; t++)
+            {
+                const size_t j = tile_start + t;
+
+                const float dmx = mx - e.mx_[j], dmy = my - e.my_[j], dmz = mz - e.mz_[j];
+                const float dsx = sx - e.sx_[j], dsy = sy - e.sy_[j], dsz = sz - e.sz_[j];
+                const float dist_model_pts = std::sqrt( dmx * dmx + dmy * dmy + dmz * dmz );
+                const float dist_scene_pts = std::sqrt( dsx * dsx + dsy * dsy + dsz * dsz );
+
+                bool ok = (e.scene_idx_[j] != scene_index_k) & (e.model_idx_[j] != model_index_k);   // same scene or model point constraint
+                ok &= !(dist_model_pts < min_dist_for_cluster) & !(dist_scene_pts < min_dist_for_cluster);   // minimum distance constraint
+                ok &= !( std::fabs(dist_model_pts - dist_scene_pts) > gc_size );  // distance consistency
+
+                if( check_normals_orientation )
+                {
+                    const float dot_scene_pts = snx * e.snx_[j] + sny * e.sny_[j] + snz * e.snz_[j];
+                    const float dot_model_pts = mnx * e.mnx_[j] + mny * e.mny_[j] + mnz * e.mnz_[j];
+                    const bool any_nan = (dot_scene_pts != dot_scene_pts) | (dot_model_pts != dot_model_pts);
+                    const float dot_distance = any_nan ? 0.f : std::fabs(dot_scene_pts - dot_model_pts);
+                    ok &= !(dot_model_pts < -0.1f) & !(dot_distance > thres_dot_distance); //Model normals should be consistently oriented! otherwise reject!
+                }
+                consistent[t] = ok;
+            }
+
+            for (size_t t = 0; t < len; t++)
+            {
+                if( consistent[t] )
+                    row_neighbors[k].push_back( tile_start + t );
+            }
+        }
+    }
+
+    size_t num_edges = 0;
+    for (size_t k = 0; k < n; k++)
+        num_edges += row_neighbors[k].size();
+
+    edges.clear();
+    edges.reserve( num_edges );
+    for (size_t k = 0; k < n; k++)
+    {
+        for (size_t j : row_neighbors[k])
+            edges.push_back( std::pair<size_t, size_t>(k, j) );
+    }
+}
+
 struct V4R_EXPORTS ViewD
 {
     size_t idx_;
@@ -265,7 +450,7 @@ public:
     }
 
     void
-    find_cliques (const Graph & G, size_t num_v)
+    find_cliques (const CorrespondenceGraphCSR & G)
     {
         SetType cand, done;
         VectorType clique_so_far;
@@ -275,22 +460,17 @@ public:
         time_elapsed_.reset();
         max_time_reached_ = false;
 
-        typename boost::graph_traits<Graph>::vertex_iterator vertexIt, vertexEnd;
-        boost::tie (vertexIt, vertexEnd) = vertices (G);
-        nnbrs.resize (num_v);
+        nnbrs.resize (G.numVertices ());
 
-        size_t i = 0;
-        for (; vertexIt != vertexEnd; ++vertexIt, ++i)
+        for (size_t v = 0; v < G.numVertices (); v++)
         {
-            typename boost::graph_traits<Graph>::adjacency_iterator vi, vi_end;
-            size_t k = 0;
-            for (boost::tie (vi, vi_end) = boost::adjacent_vertices (*vertexIt, G); vi != vi_end; ++vi, ++k)
+            for (size_t i = G.offsets_[v]; i < G.offsets_[v + 1]; i++)
             {
-                nnbrs[i].insert (*vi);
-                cand.insert (*vi);
+                nnbrs[v].insert (G.neighbors_[i]);
+                cand.insert (G.neighbors_[i]);
             }
 
-            used_ntimes_in_cliques_[*vertexIt] = 0;
+            used_ntimes_in_cliques_[v] = 0;
         }
 
         extend (cand, done, clique_so_far);
@@ -401,92 +581,47 @@ GraphGeometricConsistencyGrouping<PointModelT, PointSceneT>::clusterCorresponden
         PointCloudPtr temp_scene_cloud_ptr (new PointCloud ());
         pcl::copyPointCloud<PointSceneT, PointModelT> (*scene_, *temp_scene_cloud_ptr);
 
-        GraphGGCG correspondence_graph (model_scene_corrs_->size ());
+        const size_t num_corrs = model_scene_corrs_->size ();
         float min_dist_for_cluster = param_.gc_size_ * param_.dist_for_cluster_factor_;
 
-        for (size_t k = 0; k < model_scene_corrs_->size (); ++k)
-        {
-            int scene_index_k = model_scene_corrs_->at(k).index_match;
-            int model_index_k = model_scene_corrs_->at(k).index_query;
-            const Eigen::Vector3f& scene_point_k = scene_->at (scene_index_k).getVector3fMap ();
-            const Eigen::Vector3f& model_point_k = input_->at (model_index_k).getVector3fMap ();
-            const Eigen::Vector3f& scene_normal_k = scene_normals_->at (scene_index_k).getNormalVector3fMap ();
-            const Eigen::Vector3f& model_normal_k = input_normals_->at (model_index_k).getNormalVector3fMap ();
-
-            for (size_t j = (k + 1); j < model_scene_corrs_->size (); ++j)
-            {
-                int scene_index_j = model_scene_corrs_->at(j).index_match;
-                int model_index_j = model_scene_corrs_->at(j).index_query;
-
-                //same scene or model point constraint
-                if(scene_index_j == scene_index_k || model_index_j == model_index_k)
-                    continue;
-
-                const Eigen::Vector3f& scene_point_j = scene_->at (scene_index_j).getVector3fMap ();
-                const Eigen::Vector3f& model_point_j = input_->at (model_index_j).getVector3fMap ();
-
-                const Eigen::Vector3f& scene_normal_j = scene_normals_->at (scene_index_j).getNormalVector3fMap ();
-                const Eigen::Vector3f& model_normal_j = input_normals_->at (model_index_j).getNormalVector3fMap ();
-
-                float dist_model_pts = (model_point_k - model_point_j).norm();
-                float dist_scene_pts = (scene_point_k - scene_point_j).norm();
-
-                //minimum distance constraint
-                if ((dist_model_pts < min_dist_for_cluster) || (dist_scene_pts < min_dist_for_cluster))
-                    continue;
-
-                // check distance consistency
-                float distance = fabs (dist_model_pts - dist_scene_pts);
-                if( distance > param_.gc_size_ )
-                    continue;
-
-                if( param_.check_normals_orientation_ )
-                {
-                    // check normal consistency
-                    float dot_scene_pts = scene_normal_k.dot (scene_normal_j);
-                    float dot_model_pts = model_normal_k.dot (model_normal_j);
-
-                    //Model normals should be consistently oriented! otherwise reject!
-                    if(dot_model_pts < -0.1f)
-                        continue;
-
-                    float dot_distance = 0.f;
-                    if ( !pcl_isnan(dot_scene_pts)  && !pcl_isnan(dot_model_pts))
-                        dot_distance = fabs(dot_scene_pts - dot_model_pts);
-
-                    if ( (dot_distance > param_.thres_dot_distance_) )
-                        continue;
-
-                }
+        CorrespondenceEndpoints endpoints;
+        endpoints.gather<PointModelT, PointSceneT> (*model_scene_corrs_, *scene_, *scene_normals_, *input_, *input_normals_);
 
-                boost::add_edge (k, j, correspondence_graph);
-            }
-        }
+        std::vector<std::pair<size_t, size_t> > graph_edges;
+        computeConsistentPairs (endpoints, min_dist_for_cluster, param_.gc_size_, param_.check_normals_orientation_, param_.thres_dot_distance_, graph_edges);
 
+        // biconnected components (edge ids are the position in graph_edges)
+        typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::undirectedS, boost::no_property, boost::property<boost::edge_index_t, size_t> > GraphBCC;
+        GraphBCC correspondence_graph (num_corrs);
+        for (size_t e_id = 0; e_id < graph_edges.size (); e_id++)
+            boost::add_edge (graph_edges[e_id].first, graph_edges[e_id].second, e_id, correspondence_graph);
 
-        typename boost::property_map < GraphGGCG, edge_component_t>::type components = get(edge_component, correspondence_graph);
-        size_t n_cc = biconnected_components(correspondence_graph, components);
+        std::vector<size_t> components (graph_edges.size ());
+        size_t n_cc = biconnected_components(correspondence_graph, boost::make_iterator_property_map(components.begin (), boost::get (boost::edge_index, correspondence_graph)));
 
         if(n_cc < 1)
             return;
 
         std::vector<size_t> model_instances_kept_indices;
 
-        std::vector< std::set<size_t> > unique_vertices_per_cc (n_cc);
+        std::vector< std::vector<size_t> > edges_per_cc (n_cc);
+        for (size_t e_id = 0; e_id < graph_edges.size (); e_id++)
+            edges_per_cc[ components[e_id] ].push_back (e_id);
 
-        typename boost::graph_traits<GraphGGCG>::edge_iterator edgeIt, edgeEnd;
-        boost::tie (edgeIt, edgeEnd) = edges (correspondence_graph);
-        for (; edgeIt != edgeEnd; ++edgeIt)
+        std::vector<size_t> cc_sizes (n_cc, 0);
         {
-            int c = components[*edgeIt];
-            unique_vertices_per_cc[c].insert(boost::source(*edgeIt, correspondence_graph));
-            unique_vertices_per_cc[c].insert(boost::target(*edgeIt, correspondence_graph));
+            std::vector<size_t> last_seen_in_cc (num_corrs, std::numeric_limits<size_t>::max ());
+            for(size_t i=0; i < n_cc; i++)
+            {
+                for (size_t e_id : edges_per_cc[i])
+                {
+                    const std::pair<size_t, size_t> &e = graph_edges[e_id];
+                    if (last_seen_in_cc[e.first] != i)  { last_seen_in_cc[e.first] = i; cc_sizes[i]++; }
+                    if (last_seen_in_cc[e.second] != i) { last_seen_in_cc[e.second] = i; cc_sizes[i]++; }
+                }
+            }
         }
 
-        std::vector<size_t> cc_sizes (unique_vertices_per_cc.size(), 0);
-        for(size_t i=0; i < unique_vertices_per_cc.size(); i++)
-            cc_sizes[i] = unique_vertices_per_cc[i].size();
-
         //Go through the connected components and decide whether to use CliqueGC or usualGC or ignore (cc_sizes[i] < gc_threshold_)
         //Decision based on the number of vertices in the connected component and graph arbocity...
 
@@ -503,20 +638,20 @@ GraphGeometricConsistencyGrouping<PointModelT, PointSceneT>::clusterCorresponden
 
             analyzed_ccs++;
 
-            GraphGGCG connected_graph(correspondence_graph);
-
-            //iterate over edges and remove those not belonging to this biconnected component
-            boost::tie (edgeIt, edgeEnd) = edges (connected_graph);
-            for (; edgeIt != edgeEnd; ++edgeIt)
+            // graph containing only the edges of this biconnected component
+            CorrespondenceGraphCSR connected_graph;
             {
-                if (components[*edgeIt] != c)
-                    boost::remove_edge(*edgeIt, connected_graph);
+                std::vector<std::pair<size_t, size_t> > cc_edges;
+                cc_edges.reserve (edges_per_cc[c].size ());
+                for (size_t e_id : edges_per_cc[c])
+                    cc_edges.push_back (graph_edges[e_id]);
+                connected_graph.build (num_corrs, cc_edges, edges_per_cc[c]);
             }
 
-            //std::cout << "Num edges connnected component:" << boost::num_edges(connected_graph) << std::endl;
+            //std::cout << "Num edges connnected component:" << connected_graph.num_edges_ << std::endl;
             //        visualizeGraph(connected_graph, "connected component");
 
-            float arboricity = num_edges (connected_graph) / static_cast<float>(num_v_in_cc - 1);
+            float arboricity = connected_graph.num_edges_ / static_cast<float>(num_v_in_cc - 1);
             //std::cout << "arboricity:" << arboricity << " num_v:" << num_v_in_cc << " edges:" << num_edges (connected_graph) << std::endl;
             //std::vector<std::pair<int, int> > edges_used;
             std::set<size_t> correspondences_used;
@@ -531,7 +666,7 @@ GraphGeometricConsistencyGrouping<PointModelT, PointSceneT>::clusterCorresponden
 
                 Tomita<GraphGGCG> tom (param_.gc_threshold_);
                 tom.setMaxTimeAllowed(param_.max_time_allowed_cliques_comptutation_);
-                tom.find_cliques (connected_graph, model_scene_corrs_->size ());
+                tom.find_cliques (connected_graph);
 
                 if( tom.getMaxTimeReached( ))
                 {
@@ -738,21 +873,10 @@ GraphGeometricConsistencyGrouping<PointModelT, PointSceneT>::clusterCorresponden
                 std::vector<size_t> consensus_set ( model_scene_corrs_->size () );
                 std::vector<bool> taken_corresps ( model_scene_corrs_->size (), false );
 
-                GraphGGCG connected_graph2(correspondence_graph);
-                //iterate over edges and remove those not belonging to this biconnected component
-                boost::tie (edgeIt, edgeEnd) = edges (connected_graph2);
-                for (; edgeIt != edgeEnd; ++edgeIt)
-                {
-                    if (components[*edgeIt] != c)
-                        boost::remove_edge(*edgeIt, connected_graph2);
-                }
-
-                typename boost::graph_traits<GraphGGCG>::vertex_iterator vertexIt, vertexEnd;
-                boost::tie (vertexIt, vertexEnd) = vertices (connected_graph2);
-                for (; vertexIt != vertexEnd; ++vertexIt)
+                for (size_t v = 0; v < num_corrs; v++)
                 {
-                    if ( boost::out_degree(*vertexIt, connected_graph2) < (param_.gc_threshold_ - 1))
-                        taken_corresps[*vertexIt] = true;
+                    if ( connected_graph.degree (v) < (param_.gc_threshold_ - 1))
+                        taken_corresps[v] = true;
                 }
 
                 for (size_t i = 0; i < model_scene_corrs_->size (); ++i)
@@ -773,7 +897,7 @@ GraphGeometricConsistencyGrouping<PointModelT, PointSceneT>::clusterCorresponden
                             for (size_t k = 0; k < consensus_size; k++)
                             {
                                 //check if edge (j, consensus_set[k] exists in the graph, if it does not, is_a_good_candidate = false!...
-                                if (!(boost::edge (j, consensus_set[k], connected_graph2).second))
+                                if (!connected_graph.hasEdge (j, consensus_set[k]))
                                 {
                                     is_a_good_candidate = false;
                                     break;
@@ -878,23 +1002,38 @@ GraphGeometricConsistencyGrouping<PointModelT, PointSceneT>::clusterCorresponden
             if( param_.prune_by_CC_ )
             {
                 //pcl::ScopeTime t("final post-processing...");
-                GraphGGCG connected_graph_used_edges(connected_graph);
-                typename boost::graph_traits<GraphGGCG>::vertex_iterator vertexIt, vertexEnd;
-                std::vector<typename boost::graph_traits<GraphGGCG>::vertex_descriptor> to_be_removed;
-                boost::tie (vertexIt, vertexEnd) = vertices (connected_graph_used_edges);
-                for (; vertexIt != vertexEnd; ++vertexIt)
+                // connected components of the graph spanned by the edges between used correspondences (unused correspondences are isolated vertices)
+                std::vector<size_t> components2 (num_corrs, std::numeric_limits<size_t>::max ());
+                size_t n_cc2 = 0;
                 {
-                    std::set<size_t>::const_iterator it;
-                    it = correspondences_used.find(*vertexIt);
-                    if (it == correspondences_used.end())
-                        to_be_removed.push_back (*vertexIt);
-                }
-
-                for (size_t i = 0; i < to_be_removed.size (); i++)
-                    clear_vertex (to_be_removed[i], connected_graph_used_edges);
+                    std::vector<size_t> stack;
+                    for (size_t v = 0; v < num_corrs; v++)
+                    {
+                        if (components2[v] != std::numeric_limits<size_t>::max ())
+                            continue;
 
-                boost::vector_property_map<size_t> components2 (boost::num_vertices (connected_graph_used_edges));
-                size_t n_cc2 = boost::connected_components (connected_graph_used_edges, &components2[0]);
+                        components2[v] = n_cc2;
+                        if (correspondences_used.find (v) != correspondences_used.end ())
+                        {
+                            stack.push_back (v);
+                            while (!stack.empty ())
+                            {
+                                size_t u = stack.back ();
+                                stack.pop_back ();
+                                for (size_t i = connected_graph.offsets_[u]; i < connected_graph.offsets_[u + 1]; i++)
+                                {
+                                    size_t w = connected_graph.neighbors_[i];
+                                    if (components2[w] == std::numeric_limits<size_t>::max () && correspondences_used.find (w) != correspondences_used.end ())
+                                    {
+                                        components2[w] = n_cc2;
+                                        stack.push_back (w);
+                                    }
+                                }
+                            }
+                        }
+                        n_cc2++;
+                    }
+                }
 
                 std::vector<size_t> cc_sizes2  (n_cc2, 0);
                 for (size_t i = 0; i < model_scene_corrs_->size (); i++)
@@ -921,17 +1060,13 @@ GraphGeometricConsistencyGrouping<PointModelT, PointSceneT>::clusterCorresponden
                         continue;
 
                     std::set<size_t> instances_for_this_cc;
+                    for (size_t v = 0; v < num_corrs; v++)
                     {
-                        boost::tie (vertexIt, vertexEnd) = vertices (connected_graph_used_edges);
-
-                        for (; vertexIt != vertexEnd; ++vertexIt)
+                        if (components2[v] == internal_c)
                         {
-                            if (components2[*vertexIt] == internal_c)
+                            for(size_t k=0; k < correspondence_to_instance[v].size(); k++)
                             {
-                                for(size_t k=0; k < correspondence_to_instance[*vertexIt].size(); k++)
-                                {
-                                    instances_for_this_cc.insert(correspondence_to_instance[*vertexIt][k]);
-                                }
+                                instances_for_this_cc.insert(correspondence_to_instance[v][k]);
                             }
                         }
                     }
@@ -0,0 +1,175 @@
+#include <v4r/common/quantized_descriptors.h>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace v4r
+{
+
+namespace
+{
+#if defined(__SSE2__)
+/**
+ * @brief absolute differences of 16 bytes converted into four float vectors
+ */
+inline void
+absDiff16(const unsigned char *a, const unsigned char *b, __m128 &f0, __m128 &f1, __m128 &f2, __m128 &f3)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i va = _mm_loadu_si128( reinterpret_cast<const __m128i*>(a) );
+    const __m128i vb = _mm_loadu_si128( reinterpret_cast<const __m128i*>(b) );
+    const __m128i diff = _mm_or_si128( _mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va) );
+    const __m128i lo = _mm_unpacklo_epi8(diff, zero);
+    const __m128i hi = _mm_unpackhi_epi8(diff, zero);
+    f0 = _mm_cvtepi32_ps( _mm_unpacklo_epi16(lo, zero) );
+    f1 = _mm_cvtepi32_ps( _mm_unpackhi_epi16(lo, zero) );
+    f2 = _mm_cvtepi32_ps( _mm_unpacklo_epi16(hi, zero) );
+    f3 = _mm_cvtepi32_ps( _mm_unpackhi_epi16(hi, zero) );
+}
+
+inline float
+horizontalSum(__m128 v)
+{
+    float tmp[4];
+    _mm_storeu_ps(tmp, v);
+    return (tmp[0] + tmp[1]) + (tmp[2] + tmp[3]);
+}
+#endif
+}
+
+void
+DescriptorQuantizer::compute(const float *data, size_t rows, size_t cols)
+{
+    std::vector<float> min_val (cols, std::numeric_limits<float>::max());
+    std::vector<float> max_val (cols, -std::numeric_limits<float>::max());
+
+    for(size_t r=0; r<rows; r++)
+    {
+        const float *row = data + r * cols;
+        for(size_t c=0; c<cols; c++)
+        {
+            min_val[c] = std::min( min_val[c], row[c] );
+            max_val[c] = std::max( max_val[c], row[c] );
+        }
+    }
+
+    offset_.resize(cols);
+    scale_.resize(cols);
+    for(size_t c=0; c<cols; c++)
+    {
+        if( rows == 0 || !(max_val[c] > min_val[c]) )    // constant dimension
+        {
+            offset_[c] = rows ? min_val[c] : 0.f;
+            scale_[c] = 1.f;
+        }
+        else
+        {
+            offset_[c] = min_val[c];
+            scale_[c] = (max_val[c] - min_val[c]) / 255.f;
+        }
+    }
+}
+
+void
+DescriptorQuantizer::set(const std::vector<float> &offset, const std::vector<float> &scale)
+{
+    CHECK( offset.size() == scale.size() );
+    offset_ = offset;
+    scale_ = scale;
+}
+
+void
+DescriptorQuantizer::quantize(const float *src, size_t rows, unsigned char *dst) const
+{
+    const size_t cols = dimensions();
+    std::vector<float> inv_scale (cols);
+    for(size_t c=0; c<cols; c++)
+        inv_scale[c] = 1.f / scale_[c];
+
+    for(size_t r=0; r<rows; r++)
+    {
+        const float *row = src + r * cols;
+        unsigned char *q = dst + r * cols;
+        for(size_t c=0; c<cols; c++)
+        {
+            const float v = (row[c] - offset_[c]) * inv_scale[c] + 0.5f;
+            q[c] = v <= 0.f ? 0 : ( v >= 255.f ? 255 : static_cast<unsigned char>(v) ); // also maps NaN to 0
+        }
+    }
+}
+
+void
+DescriptorQuantizer::dequantize(const unsigned char *src, size_t rows, float *dst) const
+{
+    const size_t cols = dimensions();
+    for(size_t r=0; r<rows; r++)
+    {
+        for(size_t c=0; c<cols; c++)
+            dst[r * cols + c] = offset_[c] + scale_[c] * src[r * cols + c];
+    }
+}
+
+
+float
+quantizedL2Distance(const unsigned char *a, const unsigned char *b, const float *weights, size_t size)
+{
+    size_t d = 0;
+    float result = 0.f;
+
+#if defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for(; d+16 <= size; d+=16)
+    {
+        __m128 f0, f1, f2, f3;
+        absDiff16(a+d, b+d, f0, f1, f2, f3);
+        acc0 = _mm_add_ps( acc0, _mm_mul_ps( _mm_mul_ps(f0, f0), _mm_loadu_ps(weights+d) ) );
+        acc1 = _mm_add_ps( acc1, _mm_mul_ps( _mm_mul_ps(f1, f1), _mm_loadu_ps(weights+d+4) ) );
+        acc0 = _mm_add_ps( acc0, _mm_mul_ps( _mm_mul_ps(f2, f2), _mm_loadu_ps(weights+d+8) ) );
+        acc1 = _mm_add_ps( acc1, _mm_mul_ps( _mm_mul_ps(f3, f3), _mm_loadu_ps(weights+d+12) ) );
+    }
+    result = horizontalSum( _mm_add_ps(acc0, acc1) );
+#endif
+
+    for(; d<size; d++)
+    {
+        const float diff = static_cast<float>(a[d]) - static_cast<float>(b[d]);
+        result += weights[d] * diff * diff;
+    }
+    return result;
+}
+
+float
+quantizedL1Distance(const unsigned char *a, const unsigned char *b, const float *weights, size_t size)
+{
+    size_t d = 0;
+    float result = 0.f;
+
+#if defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for(; d+16 <= size; d+=16)
+    {
+        __m128 f0, f1, f2, f3;
+        absDiff16(a+d, b+d, f0, f1, f2, f3);
+        acc0 = _mm_add_ps( acc0, _mm_mul_ps( f0, _mm_loadu_ps(weights+d) ) );
+        acc1 = _mm_add_ps( acc1, _mm_mul_ps( f1, _mm_loadu_ps(weights+d+4) ) );
+        acc0 = _mm_add_ps( acc0, _mm_mul_ps( f2, _mm_loadu_ps(weights+d+8) ) );
+        acc1 = _mm_add_ps( acc1, _mm_mul_ps( f3, _mm_loadu_ps(weights+d+12) ) );
+    }
+    result = horizontalSum( _mm_add_ps(acc0, acc1) );
+#endif
+
+    for(; d<size; d++)
+        result += weights[d] * std::abs( static_cast<float>(a[d]) - static_cast<float>(b[d]) );
+
+    return result;
+}
+
+}
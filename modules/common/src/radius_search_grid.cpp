@@ -0,0 +1,115 @@
+#include <v4r/common/radius_search_grid.h>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace v4r
+{
+
+RadiusSearchGrid::RadiusSearchGrid(float radius)
+    : radius_ (radius), sqr_radius_ (radius * radius), inv_cell_size_ (1.f / radius), origin_ (Eigen::Vector3f::Zero())
+{
+    CHECK( radius > 0.f );
+}
+
+void
+RadiusSearchGrid::build(const std::vector<GridPoint> &points)
+{
+    points_.clear();
+    cells_.clear();
+
+    if( points.empty() )
+        return;
+
+    origin_ = Eigen::Vector3f::Constant( std::numeric_limits<float>::max() );
+    for(const GridPoint &p : points)
+    {
+        origin_(0) = std::min( origin_(0), p.x );
+        origin_(1) = std::min( origin_(1), p.y );
+        origin_(2) = std::min( origin_(2), p.z );
+    }
+
+    const int max_cell = maxCell();
+    std::vector<std::pair<uint64_t, int> > key_and_point ( points.size() );
+    for(size_t i=0; i<points.size(); i++)
+    {
+        const GridPoint &p = points[i];
+        const int x = static_cast<int>( (p.x - origin_(0)) * inv_cell_size_ );
+        const int y = static_cast<int>( (p.y - origin_(1)) * inv_cell_size_ );
+        const int z = static_cast<int>( (p.z - origin_(2)) * inv_cell_size_ );
+        CHECK( x <= max_cell && y <= max_cell && z <= max_cell ) << "Point cloud extent too large for search radius " << radius_;
+        key_and_point[i] = std::make_pair( cellKey(x, y, z), static_cast<int>(i) );
+    }
+    std::sort( key_and_point.begin(), key_and_point.end() );
+
+    points_.resize( points.size() );
+    cells_.reserve( points.size() );
+    for(size_t i=0; i<key_and_point.size(); i++)
+    {
+        points_[i] = points[ key_and_point[i].second ];
+
+        if( i==0 || key_and_point[i].first != key_and_point[i-1].first )
+        {
+            Range r;
+            r.begin = i;
+            r.end = i + 1;
+            cells_[ key_and_point[i].first ] = r;
+        }
+        else
+            cells_[ key_and_point[i].first ].end = i + 1;
+    }
+}
+
+size_t
+RadiusSearchGrid::radiusSearch(const Eigen::Vector3f &query, std::vector<int> &indices, std::vector<float> &sqr_distances) const
+{
+    indices.clear();
+    sqr_distances.clear();
+
+    if( cells_.empty() )
+        return 0;
+
+    const float max_cell = maxCell();
+    int c[3];
+    for(int i=0; i<3; i++)
+    {
+        const float cell = std::floor( (query(i) - origin_(i)) * inv_cell_size_ );
+        if( !(cell >= -1.f && cell <= max_cell + 1.f) )    // also catches NaN
+            return 0;
+        c[i] = static_cast<int>(cell);
+    }
+    const int cx = c[0], cy = c[1], cz = c[2];
+
+    for(int x = std::max(0, cx-1); x <= std::min(cx+1, maxCell()); x++)
+    {
+        for(int y = std::max(0, cy-1); y <= std::min(cy+1, maxCell()); y++)
+        {
+            for(int z = std::max(0, cz-1); z <= std::min(cz+1, maxCell()); z++)
+            {
+                const boost::unordered_map<uint64_t, Range>::const_iterator it = cells_.find( cellKey(x, y, z) );
+                if( it == cells_.end() )
+                    continue;
+
+                for(int i = it->second.begin; i < it->second.end; i++)
+                {
+                    const GridPoint &p = points_[i];
+                    const float dx = p.x - query(0);
+                    const float dy = p.y - query(1);
+                    const float dz = p.z - query(2);
+                    const float sqr_dist = dx * dx + dy * dy + dz * dz;
+                    if( sqr_dist <= sqr_radius_ )
+                    {
+                        indices.push_back( p.idx );
+                        sqr_distances.push_back( sqr_dist );
+                    }
+                }
+            }
+        }
+    }
+    return indices.size();
+}
+
+}
@@ -0,0 +1,308 @@
+#include <v4r/common/trace.h>
+
+#include <glog/logging.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <stdexcept>
+
+namespace v4r
+{
+
+namespace
+{
+void
+writeJsonString(std::ostream &os, const std::string &s)
+{
+    os << '"';
+    for(char c : s)
+    {
+        switch(c)
+        {
+        case '"':  os << "\\\""; break;
+        case '\\': os << "\\\\"; break;
+        case '\n': os << "\\n"; break;
+        case '\r': os << "\\r"; break;
+        case '\t': os << "\\t"; break;
+        default:
+            if( static_cast<unsigned char>(c) < 0x20 )
+                os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec << std::setfill(' ');
+            else
+                os << c;
+        }
+    }
+    os << '"';
+}
+
+/**
+ * @brief nearest rank percentile (0..100) of sorted values
+ */
+double
+percentileOfSorted(const std::vector<double> &sorted_values, double percentile)
+{
+    size_t rank = static_cast<size_t>( std::ceil( percentile / 100. * sorted_values.size() ) );
+    rank = std::min( std::max<size_t>(rank, 1), sorted_values.size() );
+    return sorted_values[rank - 1];
+}
+}
+
+TraceContext::TraceContext()
+    : start_time_ ( Clock::now() )
+{ }
+
+int64_t
+TraceContext::now() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>( Clock::now() - start_time_ ).count();
+}
+
+size_t
+TraceContext::threadIndex()
+{
+    const boost::thread::id id = boost::this_thread::get_id();
+    std::map<boost::thread::id, size_t>::const_iterator it = thread_ids_.find(id);
+    if( it != thread_ids_.end() )
+        return it->second;
+
+    const size_t idx = thread_ids_.size();
+    thread_ids_[id] = idx;
+    open_spans_.push_back(0);
+    return idx;
+}
+
+int64_t
+TraceContext::beginSpan()
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    open_spans_[ threadIndex() ]++;
+    return now();
+}
+
+int64_t
+TraceContext::endSpan(const std::string &name, int64_t start_us)
+{
+    const int64_t end_us = now();
+
+    Event e;
+    e.type_ = SPAN;
+    e.name_ = name;
+    e.start_us_ = start_us;
+    e.duration_us_ = end_us - start_us;
+    e.value_ = 0.;
+
+    boost::mutex::scoped_lock lock(mutex_);
+    e.thread_ = threadIndex();
+    size_t &open = open_spans_[e.thread_];
+    if( open > 0 )
+        open--;
+    e.depth_ = open;
+    events_.push_back(e);
+    return e.duration_us_;
+}
+
+void
+TraceContext::addCounter(const std::string &name, double value)
+{
+    Event e;
+    e.type_ = COUNTER;
+    e.name_ = name;
+    e.start_us_ = now();
+    e.duration_us_ = 0;
+    e.value_ = value;
+
+    boost::mutex::scoped_lock lock(mutex_);
+    e.thread_ = threadIndex();
+    e.depth_ = open_spans_[e.thread_];
+    events_.push_back(e);
+}
+
+void
+TraceContext::clear()
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    events_.clear();
+}
+
+std::vector<TraceContext::Event>
+TraceContext::getEvents() const
+{
+    boost::mutex::scoped_lock lock(mutex_);
+    return events_;
+}
+
+std::vector<std::pair<std::string, float> >
+TraceContext::getElapsedTimes() const
+{
+    const std::vector<Event> events = getEvents();
+
+    std::vector<std::pair<std::string, float> > elapsed_times;
+    elapsed_times.reserve( events.size() );
+    for(const Event &e : events)
+    {
+        if( e.type_ == SPAN )
+            elapsed_times.push_back( std::pair<std::string, float>( e.name_, e.duration_us_ / 1000.f ) );
+        else
+            elapsed_times.push_back( std::pair<std::string, float>( e.name_, static_cast<float>(e.value_) ) );
+    }
+    return elapsed_times;
+}
+
+void
+TraceContext::writeChromeTrace(std::ostream &os) const
+{
+    const std::vector<Event> events = getEvents();
+    const std::streamsize precision = os.precision();
+
+    os << "{\"traceEvents\":[";
+    for(size_t i=0; i<events.size(); i++)
+    {
+        const Event &e = events[i];
+        os << (i ? ",\n" : "\n") << "{\"name\":";
+        writeJsonString(os, e.name_);
+        if( e.type_ == SPAN )
+            os << ",\"ph\":\"X\",\"ts\":" << e.start_us_ << ",\"dur\":" << e.duration_us_;
+        else
+        {
+            os << ",\"ph\":\"C\",\"ts\":" << e.start_us_ << ",\"args\":{\"value\":";
+            if( std::isfinite(e.value_) )
+                os << std::setprecision(10) << e.value_;
+            else
+                os << "null";
+            os << "}";
+        }
+        os << ",\"pid\":0,\"tid\":" << e.thread_ << "}";
+    }
+    os << "\n],\"displayTimeUnit\":\"ms\"}" << std::endl;
+    os.precision(precision);
+}
+
+void
+TraceContext::saveChromeTrace(const std::string &filename) const
+{
+    std::ofstream ofs(filename.c_str());
+    if( !ofs.is_open() )
+        throw std::runtime_error("Could not open file " + filename + " for writing!");
+
+    writeChromeTrace(ofs);
+}
+
+
+TraceSpan::TraceSpan(const TraceContext::Ptr &trace, const std::string &name)
+    : trace_ ( trace.get() ), name_ (name), start_us_ (0)
+{
+    if( trace_ )
+        start_us_ = trace_->beginSpan();
+    else
+        start_time_ = std::chrono::steady_clock::now();
+}
+
+TraceSpan::~TraceSpan()
+{
+    int64_t duration_us;
+    if( trace_ )
+        duration_us = trace_->endSpan(name_, start_us_);
+    else
+        duration_us = std::chrono::duration_cast<std::chrono::microseconds>( std::chrono::steady_clock::now() - start_time_ ).count();
+
+    VLOG(1) << name_ << " took " << duration_us / 1000.f << " ms.";
+}
+
+
+TraceStatistics::Summary
+TraceStatistics::summarize(std::vector<double> values)
+{
+    Summary s;
+    s.count_ = values.size();
+    s.mean_ = s.min_ = s.p50_ = s.p90_ = s.p99_ = s.max_ = 0.;
+
+    if( values.empty() )
+        return s;
+
+    std::sort( values.begin(), values.end() );
+
+    double sum = 0.;
+    for(double v : values)
+        sum += v;
+
+    s.mean_ = sum / values.size();
+    s.min_ = values.front();
+    s.max_ = values.back();
+    s.p50_ = percentileOfSorted(values, 50.);
+    s.p90_ = percentileOfSorted(values, 90.);
+    s.p99_ = percentileOfSorted(values, 99.);
+    return s;
+}
+
+void
+TraceStatistics::add(const TraceContext &trace)
+{
+    std::map<std::string, double> span_sums;
+    for(const TraceContext::Event &e : trace.getEvents())
+    {
+        if( e.type_ == TraceContext::SPAN )
+            span_sums[e.name_] += e.duration_us_ / 1000.;
+        else
+            counters_[e.name_].push_back( e.value_ );
+    }
+
+    for(const std::pair<const std::string, double> &s : span_sums)
+        spans_ms_[s.first].push_back( s.second );
+}
+
+std::map<std::string, TraceStatistics::Summary>
+TraceStatistics::getSpanSummaries() const
+{
+    std::map<std::string, Summary> summaries;
+    for(const std::pair<const std::string, std::vector<double> > &s : spans_ms_)
+        summaries[s.first] = summarize( s.second );
+    return summaries;
+}
+
+std::map<std::string, TraceStatistics::Summary>
+TraceStatistics::getCounterSummaries() const
+{
+    std::map<std::string, Summary> summaries;
+    for(const std::pair<const std::string, std::vector<double> > &c : counters_)
+        summaries[c.first] = summarize( c.second );
+    return summaries;
+}
+
+double
+TraceStatistics::getSpanPercentile(const std::string &name, double percentile) const
+{
+    std::map<std::string, std::vector<double> >::const_iterator it = spans_ms_.find(name);
+    if( it == spans_ms_.end() || it->second.empty() )
+        return std::numeric_limits<double>::quiet_NaN();
+
+    std::vector<double> values = it->second;
+    std::sort( values.begin(), values.end() );
+    return percentileOfSorted(values, percentile);
+}
+
+void
+TraceStatistics::print(std::ostream &os) const
+{
+    const std::map<std::string, Summary> spans = getSpanSummaries();
+    const std::map<std::string, Summary> counters = getCounterSummaries();
+
+    const std::ios_base::fmtflags flags = os.flags();
+    const std::streamsize precision = os.precision();
+
+    os << std::fixed << std::setprecision(2);
+    os << "span [ms]: count mean min p50 p90 p99 max" << std::endl;
+    for(const std::pair<const std::string, Summary> &s : spans)
+        os << s.first << ": " << s.second.count_ << " " << s.second.mean_ << " " << s.second.min_ << " " << s.second.p50_
+           << " " << s.second.p90_ << " " << s.second.p99_ << " " << s.second.max_ << std::endl;
+
+    os << "counter: count mean min p50 p90 p99 max" << std::endl;
+    for(const std::pair<const std::string, Summary> &c : counters)
+        os << c.first << ": " << c.second.count_ << " " << c.second.mean_ << " " << c.second.min_ << " " << c.second.p50_
+           << " " << c.second.p90_ << " " << c.second.p99_ << " " << c.second.max_ << std::endl;
+    os.flags(flags);
+    os.precision(precision);
+}
+
+}
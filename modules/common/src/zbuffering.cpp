@@ -7,6 +7,10 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <pcl/impl/instantiate.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
 namespace v4r
 {
 
@@ -14,12 +18,13 @@ template<typename PointT>
 void
 ZBuffering<PointT>::renderPointCloud(const pcl::PointCloud<PointT> &cloud, pcl::PointCloud<PointT> & rendered_view, int subsample)
 {
-    if ( param_.use_normals_ && (!cloud_normals_ || cloud_normals_->points.size() != cloud.points.size()) )
+    const bool normals_match = cloud_normals_ && cloud_normals_->points.size() == cloud.points.size();
+    if ( param_.use_normals_ && !normals_match )
     {
         LOG(WARNING) << "Parameters set to use normals but normals are not set or do not correspond with "
-                        "input cloud! Will ignore normals!!";
-        param_.use_normals_ = false;
+                        "input cloud! Will ignore normals for this cloud!!";
     }
+    const bool use_normals = param_.use_normals_ && normals_match;
 
     float cx = cam_->getCx();
     float cy = cam_->getCy();
@@ -32,24 +37,28 @@ ZBuffering<PointT>::renderPointCloud(const pcl::PointCloud<PointT> &cloud, pcl::
     rendered_view.height = height;
     rendered_view.is_dense = false;
 
-    index_map_ = -1 * Eigen::MatrixXi::Ones( height, width );
+    index_map_.resize( height, width );
 
-//    Eigen::MatrixXf smoothing_px_dist1st = -1.f * Eigen::MatrixXf::Ones(height, width);
-//    Eigen::MatrixXf smoothing_px_dist2nd (height, width);
-//    smoothing_px_dist2nd.setTo( -1.f );
-//    index_2nd_map =  -1 * Eigen::MatrixXi::Ones( height, width );;
+    if( zbuffer_size_ != width * height )
+    {
+        zbuffer_.reset( new std::atomic<uint64_t>[ width * height ] );
+        zbuffer_size_ = width * height;
+    }
 
-    for (size_t i=0; i< width * height ; i++)    // initialize points to infinity
-        rendered_view.points[i].x = rendered_view.points[i].y = rendered_view.points[i].z = std::numeric_limits<float>::quiet_NaN();
+    const uint64_t empty_px = std::numeric_limits<uint64_t>::max();
 
-    std::vector<omp_lock_t> pt_locks (width * height);
-    for(size_t i=0; i<pt_locks.size(); i++)
-        omp_init_lock(&pt_locks[i]);
+#pragma omp parallel for schedule (static)
+    for (int i=0; i< static_cast<int>(width * height) ; i++)
+        zbuffer_[i].store( empty_px, std::memory_order_relaxed );
 
-#pragma omp parallel for schedule (dynamic)
+#pragma omp parallel for schedule (dynamic, 1024)
     for (int i=0; i< static_cast<int>(cloud.points.size()); i = i + subsample)
     {
         const PointT &pt = cloud.points[i];
+
+        if ( !pcl_isfinite(pt.z) )
+            continue;
+
         float uf = f * pt.x / pt.z + cx;
         float vf = f * pt.y / pt.z + cy;
 
@@ -59,135 +68,175 @@ ZBuffering<PointT>::renderPointCloud(const pcl::PointCloud<PointT> &cloud, pcl::
         if (u >= (int)width || v >= (int)height  || u < 0 || v < 0)
             continue;
 
-        if(param_.use_normals_)
+        if(use_normals)
         {
             const Eigen::Vector3f &normal = cloud_normals_->points[i].getNormalVector3fMap();
             if( normal.dot(pt.getVector3fMap()) > 0.f ) ///NOTE: We do not need to normalize here
                 continue;
         }
 
-        int idx = v * width + u;
-        omp_set_lock(&pt_locks[idx]);
-        PointT &r_pt = rendered_view.points[idx];
+        // map depth to an unsigned integer with the same ordering (flip all bits of negative, the sign bit of positive numbers)
+        uint32_t z_bits;
+        memcpy(&z_bits, &pt.z, sizeof(z_bits));
+        z_bits = (z_bits & 0x80000000u) ? ~z_bits : (z_bits | 0x80000000u);
+
+        // atomic minimum - the closest point wins (the smaller index on equal depth)
+        const uint64_t px_val = ( static_cast<uint64_t>(z_bits) << 32 ) | static_cast<uint32_t>(i);
+        std::atomic<uint64_t> &zbuf_px = zbuffer_[ v * width + u ];
+        uint64_t old_px_val = zbuf_px.load( std::memory_order_relaxed );
+        while ( px_val < old_px_val && !zbuf_px.compare_exchange_weak( old_px_val, px_val, std::memory_order_relaxed ) )
+            ;
+    }
 
-//        Eigen::Vector2f dist (uf - (u + 0.5f), vf - (v + 0.5f));
-//        float dist_norm = dist.norm();
+    // depth and index plane (row-major) of the rendered view
+    depth_.resize( width * height );
+    index_plane_.resize( width * height );
 
-//        if ( smoothing_px_dist1st(v,u)<0.f || (dist_norm < smoothing_px_dist1st(v,u)) || (pt.z < (r_pt.z-param_.inlier_threshold_) ) )
-        if ( !pcl_isfinite(r_pt.z) || (pt.z < r_pt.z ) )
+#pragma omp parallel for schedule (static)
+    for (int i=0; i< static_cast<int>(width * height); i++)
+    {
+        uint64_t px_val = zbuffer_[i].load( std::memory_order_relaxed );
+
+        if ( px_val == empty_px )
         {
-//            smoothing_px_dist1st(v,u) = dist_norm;
-            r_pt = pt;
-            index_map_(v,u) = i;
+            depth_[i] = std::numeric_limits<float>::quiet_NaN();
+            index_plane_[i] = -1;
         }
-        omp_unset_lock(&pt_locks[idx]);
-/*
-        for (int uu = (u - param_.smoothing_radius_); uu <= (u + param_.smoothing_radius_); uu++)
+        else
         {
-            for (int vv = (v - param_.smoothing_radius_); vv <= (v + param_.smoothing_radius_); vv++)
-            {
-                if( uu<0 || vv<0 || uu>=(int)width || vv>=(int)height)
-                    continue;
+            index_plane_[i] = static_cast<int>( px_val & 0xFFFFFFFFu );
+            depth_[i] = cloud.points[ index_plane_[i] ].z;
+        }
+    }
+
+    if (param_.do_smoothing_)
+        fillHoles(width, height);
+
+    if (param_.do_noise_filtering_)
+        removeNoise(width, height);
 
-                Eigen::Vector2f dist (uf - (uu + 0.5f), vf - (vv + 0.5f));
-                float dist_norm = dist.norm();
+    boost::dynamic_bitset<> pt_is_kept ( cloud.points.size(), 0);
+
+    for(size_t v=0; v<height; v++)
+    {
+        for(size_t u=0; u<width; u++)
+        {
+            size_t idx = v * width + u;
+            int pt_idx = index_plane_[idx];
+            index_map_(v,u) = pt_idx;
 
-                if(smoothing_px_dist2nd>0.f && dist_norm < smoothing_px_dist2nd)
-                {
-                    smoothing_px_dist2nd = dist_norm;
-                    index_2nd_map = i;
-                }
+            if( pt_idx >= 0 )
+            {
+                rendered_view.points[idx] = cloud.points[pt_idx];
+                pt_is_kept.set(pt_idx);
+            }
+            else
+            {
+                PointT &r_pt = rendered_view.points[idx];
+                r_pt.x = r_pt.y = r_pt.z = std::numeric_limits<float>::quiet_NaN();
             }
         }
-        */
     }
 
-    for(size_t i=0; i<pt_locks.size(); i++)
-        omp_destroy_lock(&pt_locks[i]);
-
+    kept_indices_ = createIndicesFromMask<int>( pt_is_kept );
+}
 
-    if (param_.do_smoothing_)
+template<typename PointT>
+void
+ZBuffering<PointT>::fillHoles(size_t width, size_t height)
+{
+    const int r = param_.smoothing_radius_;
+    if( r <= 0 || (int)width <= 2*r || (int)height <= 2*r )
+        return;
+
+    // Each pixel is represented by a key packing its (order-preserving) depth with its column-major pixel position. The minimum key
+    // within a window is therefore the closest point, and on equal depth the one with smaller u and then smaller v.
+    const uint64_t empty_px = std::numeric_limits<uint64_t>::max();
+    std::vector<uint64_t> px_key ( width * height );
+    std::vector<uint64_t> row_min ( width * height, empty_px );
+
+#pragma omp parallel for schedule (static)
+    for (int v=0; v < static_cast<int>(height); v++)
     {
-        pcl::PointCloud<PointT> rendered_view_unsmooth = rendered_view;
-
-        for (int u = param_.smoothing_radius_; u < ((int)width - param_.smoothing_radius_); u++)
+        for (size_t u=0; u < width; u++)
         {
-            for (int v = param_.smoothing_radius_; v < ((int)height - param_.smoothing_radius_); v++)
+            size_t idx = v * width + u;
+            if( index_plane_[idx] < 0 )
+                px_key[idx] = empty_px;
+            else
             {
-                float min = std::numeric_limits<float>::max();
-                int min_uu = u, min_vv = v;
-                for (int uu = (u - param_.smoothing_radius_); uu <= (u + param_.smoothing_radius_); uu++)
-                {
-                    for (int vv = (v - param_.smoothing_radius_); vv <= (v + param_.smoothing_radius_); vv++)
-                    {
-                        if( uu<0 || vv<0 || uu>=(int)width || vv>=(int)height)    // this shouldn't happen anyway
-                            continue;
-
-                        PointT &p = rendered_view_unsmooth.at(uu,vv);
-                        if ( !pcl_isfinite(min) || (pcl::isFinite(p) && ( p.z < min)) )
-                        {
-                            min = p.z;
-                            min_uu = uu;
-                            min_vv = vv;
-                        }
-                    }
-                }
-
-                rendered_view.at(u,v) = rendered_view_unsmooth.at(min_uu, min_vv);
-                index_map_(v,u) = index_map_(min_vv, min_uu);   ///NOTE: Be careful, this is maybe not what you want to get!
+                uint32_t z_bits;
+                memcpy(&z_bits, &depth_[idx], sizeof(z_bits));
+                z_bits = (z_bits & 0x80000000u) ? ~z_bits : (z_bits | 0x80000000u);
+                px_key[idx] = ( static_cast<uint64_t>(z_bits) << 32 ) | static_cast<uint32_t>(u * height + v);
             }
         }
     }
 
-    if (param_.do_noise_filtering_)
+    // separable min-filter: horizontal pass over each row ...
+#pragma omp parallel for schedule (static)
+    for (int v=0; v < static_cast<int>(height); v++)
     {
-        pcl::PointCloud<PointT> rendered_view_filtered = rendered_view;
-
-        for (int u = param_.smoothing_radius_; u < ((int)width - param_.smoothing_radius_); u++)
+        const uint64_t *key_row = &px_key[v * width];
+        uint64_t *min_row = &row_min[v * width];
+        for (int du = -r; du <= r; du++)
         {
-            for (int v = param_.smoothing_radius_; v < ((int)height - param_.smoothing_radius_); v++)
-            {
-                PointT &p = rendered_view_filtered.at(u,v);
-                bool is_noise = true;
-                for (int uu = (u - param_.smoothing_radius_); uu <= (u + param_.smoothing_radius_) && is_noise; uu++)
-                {
-                    for (int vv = (v - param_.smoothing_radius_); vv <= (v + param_.smoothing_radius_); vv++)
-                    {
-                        if( uu<0 || vv<0 || uu>=(int)width || vv>=(int)height)    // this shouldn't happen anyway
-                            continue;
-
-                        PointT &p_tmp = rendered_view.at(uu,vv);
-                        if ( std::abs(p.z - p_tmp.z) < param_.inlier_threshold_ )
-                        {
-                            is_noise=false;
-                            break;
-                        }
-                    }
-                }
-                if(is_noise)
-                {
-                    p.x = p.y = p.z = std::numeric_limits<float>::quiet_NaN();
-                    index_map_(v,u) = -1;
-                }
-           }
+            for (size_t u = r; u < width - r; u++)
+                min_row[u] = std::min( min_row[u], key_row[u + du] );
         }
-        rendered_view = rendered_view_filtered;
     }
 
-    boost::dynamic_bitset<> pt_is_kept ( cloud.points.size(), 0);
+    const std::vector<int> index_plane_unsmooth = index_plane_;
+    const std::vector<float> depth_unsmooth = depth_;
 
-    for(int v=0; v<index_map_.rows(); v++)
+    // ... followed by a vertical pass combining rows (contiguous in memory)
+#pragma omp parallel for schedule (static)
+    for (int v = r; v < static_cast<int>(height) - r; v++)
     {
-        for(int u=0; u<index_map_.cols(); u++)
+        std::vector<uint64_t> win_min ( row_min.begin() + v * width, row_min.begin() + (v + 1) * width );
+        for (int dv = -r; dv <= r; dv++)
+        {
+            const uint64_t *min_row = &row_min[(v + dv) * width];
+            for (size_t u = r; u < width - r; u++)
+                win_min[u] = std::min( win_min[u], min_row[u] );
+        }
+
+        for (size_t u = r; u < width - r; u++)
         {
-            if(index_map_(v,u)>=0)
+            if( win_min[u] == empty_px )
+                continue;
+
+            uint32_t src_px = static_cast<uint32_t>( win_min[u] & 0xFFFFFFFFu );
+            size_t src_idx = (src_px % height) * width + src_px / height;
+            index_plane_[ v * width + u ] = index_plane_unsmooth[ src_idx ];
+            depth_[ v * width + u ] = depth_unsmooth[ src_idx ];
+        }
+    }
+}
+
+template<typename PointT>
+void
+ZBuffering<PointT>::removeNoise(size_t width, size_t height)
+{
+    const int r = param_.smoothing_radius_;
+    if( r <= 0 || (int)width <= 2*r || (int)height <= 2*r )
+        return;
+
+    // A pixel is noise if no pixel within the smoothing radius has a similar depth. As the window includes the pixel
+    // itself, only pixels without finite depth can be noise (this keeps the output of the original implementation).
+#pragma omp parallel for schedule (static)
+    for (int v = r; v < static_cast<int>(height) - r; v++)
+    {
+        for (size_t u = r; u < width - r; u++)
+        {
+            const size_t idx = v * width + u;
+            if( !pcl_isfinite( depth_[idx] ) )
             {
-                pt_is_kept.set(index_map_(v,u));
+                depth_[idx] = std::numeric_limits<float>::quiet_NaN();
+                index_plane_[idx] = -1;
             }
         }
     }
-
-    kept_indices_ = createIndicesFromMask<int>( pt_is_kept );
 }
 
 
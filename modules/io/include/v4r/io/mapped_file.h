@@ -0,0 +1,60 @@
+#pragma once
+
+#include <v4r/core/macros.h>
+
+#include <cstddef>
+#include <string>
+
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+
+namespace v4r
+{
+namespace io
+{
+
+/**
+ * @brief The MappedFile class maps a file read-only into memory (POSIX mmap). The mapping is released on destruction,
+ * so any pointer obtained by data() must not outlive this object.
+ */
+class V4R_EXPORTS MappedFile : private boost::noncopyable
+{
+private:
+    const char *data_; ///< start of the mapped memory
+    size_t size_;   ///< size of the mapped file in bytes
+
+public:
+    /**
+     * @brief MappedFile maps the given file into memory
+     * @param filename file to map (throws std::runtime_error if the file can not be opened or mapped)
+     */
+    explicit MappedFile(const std::string &filename);
+
+    ~MappedFile();
+
+    /**
+     * @brief data
+     * @return pointer to the beginning of the mapped file
+     */
+    const char *
+    data() const
+    {
+        return data_;
+    }
+
+    /**
+     * @brief size
+     * @return size of the mapped file in bytes
+     */
+    size_t
+    size() const
+    {
+        return size_;
+    }
+
+    typedef boost::shared_ptr< MappedFile > Ptr;
+    typedef boost::shared_ptr< MappedFile const> ConstPtr;
+};
+
+}
+}
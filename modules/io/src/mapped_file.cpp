@@ -0,0 +1,54 @@
+#include <v4r/io/mapped_file.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace v4r
+{
+namespace io
+{
+
+MappedFile::MappedFile(const std::string &filename)
+    : data_ (NULL), size_ (0)
+{
+    int fd = open( filename.c_str(), O_RDONLY );
+    if( fd < 0 )
+        throw std::runtime_error("Could not open file " + filename + " for memory mapping: " + std::strerror(errno));
+
+    struct stat st;
+    if( fstat(fd, &st) != 0 )
+    {
+        close(fd);
+        throw std::runtime_error("Could not get size of file " + filename + ": " + std::strerror(errno));
+    }
+
+    size_ = st.st_size;
+
+    if( size_ > 0 )
+    {
+        void *addr = mmap( NULL, size_, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if( addr == MAP_FAILED )
+        {
+            close(fd);
+            throw std::runtime_error("Could not memory map file " + filename + ": " + std::strerror(errno));
+        }
+        data_ = static_cast<const char*>(addr);
+    }
+
+    close(fd);  // the mapping stays valid after closing the file descriptor
+}
+
+MappedFile::~MappedFile()
+{
+    if( data_ )
+        munmap( const_cast<char*>(data_), size_ );
+}
+
+}
+}
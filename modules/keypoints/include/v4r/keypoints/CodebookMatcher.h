@@ -64,6 +64,22 @@ public:
   };
 
 private:
+  /**
+   * FlannBasedMatcher which can store its trained index in a file and load it instead of training
+   */
+  class FlannIndexMatcher : public cv::FlannBasedMatcher
+  {
+  public:
+    FlannIndexMatcher(const cv::Ptr<cv::flann::IndexParams> &index_params, const cv::Ptr<cv::flann::SearchParams> &search_params)
+     : cv::FlannBasedMatcher(index_params, search_params) {}
+
+    /** the matcher needs to be trained **/
+    void saveIndex(const std::string &filename) const { flannIndex->save(filename); }
+
+    /** the descriptors need to be added, returns false if the index does not fit to them **/
+    bool loadIndex(const std::string &filename);
+  };
+
   Parameter param;
 
   ClusteringRNN rnn;
@@ -76,7 +92,9 @@ private:
   std::vector< std::vector< std::pair<int,int> > > cb_entries;
   std::vector< std::pair<int, int> > view_rank;
 
-  cv::Ptr<cv::DescriptorMatcher> matcher;
+  cv::Ptr<FlannIndexMatcher> matcher;
+
+  void createMatcher(const std::string &index_filename="");
 
 public:
   cv::Mat dbg;
@@ -88,7 +106,8 @@ public:
   void addView(const cv::Mat &descriptors, int view_idx);
   void createCodebook();
   void createCodebook(cv::Mat &_cb_centers, std::vector< std::vector< std::pair<int,int> > > &_cb_entries);
-  void setCodebook(const cv::Mat &_cb_centers, const std::vector< std::vector< std::pair<int,int> > > &_cb_entries);
+  void setCodebook(const cv::Mat &_cb_centers, const std::vector< std::vector< std::pair<int,int> > > &_cb_entries, const std::string &index_filename="");
+  bool saveIndex(const std::string &filename) const;
   void queryViewRank(const cv::Mat &descriptors, std::vector< std::pair<int, int> > &view_rank);
   void queryMatches(const cv::Mat &descriptors, std::vector< std::vector< cv::DMatch > > &matches, bool sort_view_rank=true);
 
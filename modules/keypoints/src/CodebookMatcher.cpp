@@ -32,6 +32,7 @@
 
 #include <v4r/keypoints/CodebookMatcher.h>
 #include <pcl/common/time.h>
+#include <exception>
 
 
 namespace v4r
@@ -64,8 +65,73 @@ CodebookMatcher::~CodebookMatcher()
 
 
 
+/**
+ * @brief CodebookMatcher::FlannIndexMatcher::loadIndex
+ * @param filename
+ * @return
+ */
+bool CodebookMatcher::FlannIndexMatcher::loadIndex(const std::string &filename)
+{
+  mergedDescriptors.set(trainDescCollection);
+  flannIndex = new cv::flann::Index();
+
+  bool ok;
+
+  try
+  {
+    ok = flannIndex->load(mergedDescriptors.getDescriptors(), filename);
+  }
+  catch (const std::exception &)   // cv::Exception, or cvflann::FLANNException for a truncated/corrupt/stale index file
+  {
+    ok = false;
+  }
+
+  if (!ok)
+    flannIndex.release();
+
+  return ok;
+}
+
+/**
+ * @brief CodebookMatcher::createMatcher
+ * @param index_filename
+ */
+void CodebookMatcher::createMatcher(const std::string &index_filename)
+{
+  matcher = new FlannIndexMatcher(new cv::flann::KDTreeIndexParams(16), new cv::flann::SearchParams(150,0,true));
+  matcher->add(std::vector<cv::Mat>(1,cb_centers));
+
+  if (!index_filename.empty() && std::ifstream(index_filename.c_str()).good())
+  {
+    pcl::ScopeTime t("load FLANN");
+    if (matcher->loadIndex(index_filename))
+      return;
+    cout<<"[CodebookMatcher] FLANN index "<<index_filename<<" does not fit to the codebook!"<<endl;
+  }
+
+  { pcl::ScopeTime t("create FLANN");
+  matcher->train();
+  }
+}
+
+
+
 /***************************************************************************************/
 
+/**
+ * @brief CodebookMatcher::saveIndex stores the trained flann index (load it with setCodebook)
+ * @param filename
+ * @return false if there is no trained index
+ */
+bool CodebookMatcher::saveIndex(const std::string &filename) const
+{
+  if (matcher.empty())
+    return false;
+
+  matcher->saveIndex(filename);
+  return true;
+}
+
 /**
  * @brief CodebookMatcher::clear
  */
@@ -127,17 +193,13 @@ void CodebookMatcher::createCodebook()
   cout<<"codbeook.size()="<<clusters.size()<<"/"<<descs.rows<<endl;
 
   // create flann for matching
-  { pcl::ScopeTime t("create FLANN");
-  matcher = new cv::FlannBasedMatcher(new cv::flann::KDTreeIndexParams(16), new cv::flann::SearchParams(150,0,true));
-  matcher->add(std::vector<cv::Mat>(1,cb_centers));
-  matcher->train();
-  }
+  createMatcher();
 
   // once the codebook is created clear the temp containers
   rnn = ClusteringRNN();
   descs = DataMatrix2Df();
   vk_indices = std::vector< std::pair<int,int> >();
-//  cb_centers.release(); // o.k. we could release them, but then we need to store the flann
+//  cb_centers.release(); // o.k. we could release them, but the stored flann index needs them too
 
 }
 
@@ -174,11 +236,7 @@ void CodebookMatcher::createCodebook(cv::Mat &_cb_centers, std::vector< std::vec
   cout<<"codbeook.size()="<<clusters.size()<<"/"<<descs.rows<<endl;
 
   // create flann for matching
-  { pcl::ScopeTime t("create FLANN");
-  matcher = new cv::FlannBasedMatcher(new cv::flann::KDTreeIndexParams(16), new cv::flann::SearchParams(150,0,true));
-  matcher->add(std::vector<cv::Mat>(1,cb_centers));
-  matcher->train();
-  }
+  createMatcher();
 
   // return codebook
   cb_centers.copyTo(_cb_centers);
@@ -195,8 +253,9 @@ void CodebookMatcher::createCodebook(cv::Mat &_cb_centers, std::vector< std::vec
  * @brief CodebookMatcher::setCodebook
  * @param _cb_centers
  * @param _cb_entries
+ * @param index_filename flann index stored with saveIndex (optional, if it can not be loaded the index is trained)
  */
-void CodebookMatcher::setCodebook(const cv::Mat &_cb_centers, const std::vector< std::vector< std::pair<int,int> > > &_cb_entries)
+void CodebookMatcher::setCodebook(const cv::Mat &_cb_centers, const std::vector< std::vector< std::pair<int,int> > > &_cb_entries, const std::string &index_filename)
 {
   cb_centers = _cb_centers;
   cb_entries = _cb_entries;
@@ -210,13 +269,8 @@ void CodebookMatcher::setCodebook(const cv::Mat &_cb_centers, const std::vector<
 
   max_view_index++;
 
-  // create flann for matching
-  { pcl::ScopeTime t("create FLANN");
-  matcher = new cv::FlannBasedMatcher(new cv::flann::KDTreeIndexParams(16), new cv::flann::SearchParams(150,0,true));
-  matcher->add(std::vector<cv::Mat>(1,cb_centers));
-  matcher->train();
-  }
-
+  // create flann for matching (or load a stored index)
+  createMatcher(index_filename);
 
 }
 
@@ -0,0 +1,151 @@
+/*
+    Copyright (c) 2013, <copyright holder> <email>
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+        * Neither the name of the <organization> nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY <copyright holder> <email> ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL <copyright holder> <email> BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef FLATFOREST_H
+#define FLATFOREST_H
+
+#include <stdint.h>
+#include <vector>
+#include <Eigen/Dense>
+#include <boost/shared_ptr.hpp>
+
+#include "forest.h"
+
+#include <v4r/core/macros.h>
+#include <v4r/io/mapped_file.h>
+
+namespace v4r {
+namespace RandomForest {
+
+/**
+ * @brief The FlatForest class is a compiled, read-only inference representation of a trained Forest. The nodes of all trees
+ * are packed into one array (16 bytes each, breadth-first per tree, both children of a split node are adjacent) and the
+ * label distributions are stored in one contiguous float array.
+ * The flat representation can be stored in a binary file (see save()), which is memory-mapped on load and used for inference
+ * without any parsing or copying.
+ */
+class V4R_EXPORTS FlatForest
+{
+public:
+  struct FlatNode
+  {
+    int32_t feature;    ///< index of the feature to split on (-1 for leaf nodes)
+    float threshold;    ///< points with feature value > threshold go to the right child
+    uint32_t child;     ///< index of the left child (right child is at child+1)
+    uint32_t dist;      ///< offset of the label distribution in the distribution array (NO_DIST if the node has none)
+  };
+
+  static const uint32_t NO_DIST = 0xFFFFFFFF;
+
+private:
+  // storage of a compiled forest (empty if loaded from a mapped file)
+  std::vector<FlatNode> nodeStorage_;
+  std::vector<uint32_t> rootStorage_;
+  std::vector<float> distStorage_;
+  io::MappedFile::ConstPtr mapping_;
+
+  const FlatNode *nodes_;     ///< nodes of all trees
+  const uint32_t *roots_;     ///< index of the root node of each tree
+  const float *dists_;        ///< label distributions (labels_.size() values per node)
+  size_t nNodes_, nTrees_, nDists_;
+  size_t nFeatures_;          ///< feature dimension required by the split nodes (largest feature index + 1)
+  std::vector<int> labels_;
+  bool splitNodesStoreLabelDistribution_;
+
+  inline const float* traverse(uint32_t node_idx, const float *point, int depth) const;
+  void useStorage();
+  void validate() const;
+
+public:
+  FlatForest();
+  explicit FlatForest(const Forest &forest);
+
+  /**
+   * @brief FlatForest loads a forest from a binary file (see load())
+   */
+  explicit FlatForest(const std::string &filename, bool use_mmap = true);
+
+  FlatForest(const FlatForest &other);
+  FlatForest& operator=(const FlatForest &other);
+
+  /**
+   * @brief compile converts a trained forest into the flat representation
+   */
+  void compile(const Forest &forest);
+
+  /**
+   * @brief softClassify computes the averaged label distribution for a batch of points
+   * @param points (each point is a row entry, the feature dimensions are equal to the number of columns, at least getFeatureDimension())
+   * @param depth traverse trees only down to this depth (-1 ... down to leaf nodes)
+   * @param useNTrees number of trees to evaluate (-1 ... all)
+   * @return label distributions (one row per point, one column per label, see getLabels())
+   */
+  Eigen::MatrixXf softClassify(const Eigen::MatrixXf &points, int depth = -1, int useNTrees = -1) const;
+
+  /**
+   * @brief classify returns the index (into getLabels()) of the most likely label for each point
+   * @param points (each point is a row entry, the feature dimensions are equal to the number of columns)
+   */
+  Eigen::VectorXi classify(const Eigen::MatrixXf &points, int depth = -1, int useNTrees = -1) const;
+
+  std::vector<float> SoftClassify(const std::vector<float>& point, int depth = -1, int useNTrees = -1) const;
+  int ClassifyPoint(const std::vector<float>& point, int depth = -1, int useNTrees = -1) const;
+
+  /**
+   * @brief save writes the forest into a binary file (versioned header followed by the label, root, node and
+   * distribution arrays, each 64-byte aligned)
+   */
+  void save(const std::string &filename) const;
+
+  /**
+   * @brief load reads a forest from a binary file written by save(). Throws std::runtime_error if the file is not a valid forest file.
+   * @param use_mmap if true, the file is memory-mapped and nodes and distributions are used directly from the mapping,
+   * otherwise they are copied into memory
+   */
+  void load(const std::string &filename, bool use_mmap = true);
+
+  /**
+   * @brief convertArchive converts a forest stored by Forest::SaveToFile (boost archive) into the binary format
+   */
+  static void convertArchive(const std::string &archive_filename, const std::string &filename);
+
+  const std::vector<int>& getLabels() const { return labels_; }
+  size_t getNumTrees() const { return nTrees_; }
+
+  /**
+   * @brief getFeatureDimension returns the number of feature dimensions (columns) a point needs to have
+   */
+  size_t getFeatureDimension() const { return nFeatures_; }
+
+  typedef boost::shared_ptr< FlatForest > Ptr;
+  typedef boost::shared_ptr< FlatForest const> ConstPtr;
+};
+
+}
+}
+#endif // FLATFOREST_H
@@ -60,6 +60,7 @@ class V4R_EXPORTS Forest
 {   
 private:
   friend class boost::serialization::access;  
+  friend class FlatForest;
   template<class Archive>
   void serialize(Archive & ar, const unsigned int version)
   {
@@ -75,12 +75,13 @@ public:
   void ClearSplitNodeLabelDistribution();
   void AddToAbsLabelDistribution(int labelIdx);
   void UpdateLabelDistribution(std::vector< int > labels, std::map< int, unsigned int >& pointsPerLabel);
-  inline int GetLeftChildIdx();
-  inline int GetRightChildIdx();
+  inline int GetLeftChildIdx() const;
+  inline int GetRightChildIdx() const;
   inline std::vector<float>& GetLabelDistribution();
-  inline float GetThreshold();
-  inline int GetSplitFeatureIdx();
-  inline bool IsSplitNode();
+  inline const std::vector<float>& GetLabelDistribution() const;
+  inline float GetThreshold() const;
+  inline int GetSplitFeatureIdx() const;
+  inline bool IsSplitNode() const;
   inline int EvaluateNode(std::vector< float >& point);
   virtual ~Node();
 };
@@ -90,7 +91,12 @@ inline std::vector< float >& Node::GetLabelDistribution()
   return labelDistribution_;
 }
 
-inline bool Node::IsSplitNode()
+inline const std::vector< float >& Node::GetLabelDistribution() const
+{
+  return labelDistribution_;
+}
+
+inline bool Node::IsSplitNode() const
 {
   return isSplitNode_;
 }
@@ -101,22 +107,22 @@ inline int Node::EvaluateNode(std::vector< float >& point)
   return point[splitOnFeatureIdx_] > threshold_ ? rightChildIdx_ : leftChildIdx_;
 }
 
-inline int Node::GetLeftChildIdx()
+inline int Node::GetLeftChildIdx() const
 {
   return leftChildIdx_;
 }
 
-inline int Node::GetRightChildIdx()
+inline int Node::GetRightChildIdx() const
 {
   return rightChildIdx_;
 }
 
-inline int Node::GetSplitFeatureIdx()
+inline int Node::GetSplitFeatureIdx() const
 {
   return splitOnFeatureIdx_;
 }
 
-inline float Node::GetThreshold()
+inline float Node::GetThreshold() const
 {
   return threshold_;
 }
@@ -50,10 +50,13 @@ namespace v4r
 
 namespace RandomForest {
 
+class FlatForest;
+
 class V4R_EXPORTS Tree
 {
 private:
   friend class boost::serialization::access;
+  friend class FlatForest;
   template<class Archive>
   void serialize(Archive & ar, const unsigned int version)
   {
@@ -0,0 +1,434 @@
+/*
+    Copyright (c) 2013, <copyright holder> <email>
+    All rights reserved.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are met:
+        * Redistributions of source code must retain the above copyright
+        notice, this list of conditions and the following disclaimer.
+        * Redistributions in binary form must reproduce the above copyright
+        notice, this list of conditions and the following disclaimer in the
+        documentation and/or other materials provided with the distribution.
+        * Neither the name of the <organization> nor the
+        names of its contributors may be used to endorse or promote products
+        derived from this software without specific prior written permission.
+
+    THIS SOFTWARE IS PROVIDED BY <copyright holder> <email> ''AS IS'' AND ANY
+    EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+    WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+    DISCLAIMED. IN NO EVENT SHALL <copyright holder> <email> BE LIABLE FOR ANY
+    DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+    (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+    LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+    ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+    SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <v4r/ml/flatforest.h>
+#include <glog/logging.h>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <stdexcept>
+
+using namespace v4r::RandomForest;
+
+static_assert(sizeof(FlatForest::FlatNode) == 16, "FlatNode must be packed into 16 bytes");
+
+namespace
+{
+
+const char FLAT_FOREST_MAGIC[8] = {'V','4','R','F','O','R','S','T'};
+const uint32_t FLAT_FOREST_VERSION = 2;
+const uint32_t FLAT_FOREST_ENDIANNESS = 0x01020304;
+const uint32_t FLAT_FOREST_SPLIT_NODE_DISTS = 0x1;
+const uint64_t FLAT_FOREST_ALIGNMENT = 64;
+
+struct FlatForestFileHeader
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t endianness;
+  uint32_t flags;
+  uint32_t nLabels;
+  uint32_t nFeatures;
+  uint32_t reserved;
+  uint64_t nTrees;
+  uint64_t nNodes;
+  uint64_t nDists;
+  uint64_t labelsOffset;
+  uint64_t rootsOffset;
+  uint64_t nodesOffset;
+  uint64_t distsOffset;
+};
+
+inline uint64_t alignOffset(uint64_t offset)
+{
+  return (offset + FLAT_FOREST_ALIGNMENT - 1) / FLAT_FOREST_ALIGNMENT * FLAT_FOREST_ALIGNMENT;
+}
+
+void writeAt(std::ofstream &ofs, uint64_t offset, const void *data, uint64_t size)
+{
+  ofs.seekp(offset);
+  ofs.write(static_cast<const char*>(data), size);
+}
+
+// true if count elements of elementSize bytes starting at offset lie within a file of fileSize bytes (without overflowing)
+inline bool fitsInFile(uint64_t offset, uint64_t count, uint64_t elementSize, uint64_t fileSize)
+{
+  return offset <= fileSize && count <= (fileSize - offset) / elementSize;
+}
+
+}
+
+// number of points evaluated together, so the upper levels of each tree stay in cache
+#define FLAT_FOREST_BLOCK_SIZE 64
+
+const uint32_t FlatForest::NO_DIST;
+
+FlatForest::FlatForest()
+  : nodes_(0), roots_(0), dists_(0), nNodes_(0), nTrees_(0), nDists_(0), nFeatures_(0), splitNodesStoreLabelDistribution_(false)
+{
+}
+
+FlatForest::FlatForest(const Forest &forest)
+{
+  compile(forest);
+}
+
+FlatForest::FlatForest(const std::string &filename, bool use_mmap)
+{
+  load(filename, use_mmap);
+}
+
+FlatForest::FlatForest(const FlatForest &other)
+{
+  *this = other;
+}
+
+FlatForest& FlatForest::operator=(const FlatForest &other)
+{
+  if(this == &other)
+    return *this;
+
+  nodeStorage_ = other.nodeStorage_;
+  rootStorage_ = other.rootStorage_;
+  distStorage_ = other.distStorage_;
+  labels_ = other.labels_;
+  nFeatures_ = other.nFeatures_;
+  splitNodesStoreLabelDistribution_ = other.splitNodesStoreLabelDistribution_;
+
+  if(other.mapping_)
+  {
+    // the mapping is shared, so the pointers into it stay valid
+    mapping_ = other.mapping_;
+    nodes_ = other.nodes_;
+    roots_ = other.roots_;
+    dists_ = other.dists_;
+    nNodes_ = other.nNodes_;
+    nTrees_ = other.nTrees_;
+    nDists_ = other.nDists_;
+  }
+  else
+    useStorage();
+
+  return *this;
+}
+
+void FlatForest::useStorage()
+{
+  mapping_.reset();
+  nodes_ = nodeStorage_.empty() ? 0 : &nodeStorage_[0];
+  roots_ = rootStorage_.empty() ? 0 : &rootStorage_[0];
+  dists_ = distStorage_.empty() ? 0 : &distStorage_[0];
+  nNodes_ = nodeStorage_.size();
+  nTrees_ = rootStorage_.size();
+  nDists_ = distStorage_.size();
+}
+
+void FlatForest::compile(const Forest &forest)
+{
+  const size_t nLabels = forest.labels.size();
+
+  nodeStorage_.clear();
+  rootStorage_.clear();
+  distStorage_.clear();
+  labels_ = forest.labels;
+  nFeatures_ = 0;
+  splitNodesStoreLabelDistribution_ = forest.splitNodesStoreLabelDistribution;
+
+  for(size_t t=0; t < forest.trees.size(); t++)
+  {
+    const Tree &tree = forest.trees[t];
+
+    // breadth-first traversal, children of a node are appended next to each other
+    std::deque< std::pair<int, uint32_t> > queue;   // (index in tree, index in flat array)
+    rootStorage_.push_back(nodeStorage_.size());
+    nodeStorage_.push_back(FlatNode());
+    queue.push_back(std::make_pair(tree.rootNodeIdx, rootStorage_.back()));
+
+    while(!queue.empty())
+    {
+      const Node &node = tree.nodes[queue.front().first];
+      const uint32_t flat_idx = queue.front().second;
+      queue.pop_front();
+
+      FlatNode fn;
+      fn.feature = -1;
+      fn.threshold = 0.f;
+      fn.child = 0;
+      fn.dist = NO_DIST;
+
+      const std::vector<float> &dist = node.GetLabelDistribution();
+      if(dist.size() == nLabels && nLabels > 0)
+      {
+        fn.dist = distStorage_.size();
+        distStorage_.insert(distStorage_.end(), dist.begin(), dist.end());
+      }
+
+      if(node.IsSplitNode())
+      {
+        fn.feature = node.GetSplitFeatureIdx();
+        nFeatures_ = std::max(nFeatures_, (size_t)fn.feature + 1);
+        fn.threshold = node.GetThreshold();
+        fn.child = nodeStorage_.size();
+        nodeStorage_.push_back(FlatNode());
+        nodeStorage_.push_back(FlatNode());
+        queue.push_back(std::make_pair(node.GetLeftChildIdx(), fn.child));
+        queue.push_back(std::make_pair(node.GetRightChildIdx(), fn.child+1));
+      }
+      else if(fn.dist == NO_DIST)
+        throw std::runtime_error("[FlatForest::compile] Leaf node without label distribution!");
+
+      nodeStorage_[flat_idx] = fn;
+    }
+  }
+
+  useStorage();
+  validate();
+}
+
+inline const float* FlatForest::traverse(uint32_t node_idx, const float *point, int depth) const
+{
+  const FlatNode *node = &nodes_[node_idx];
+
+  if(depth < 0)
+  {
+    while(node->feature >= 0)
+      node = &nodes_[node->child + (point[node->feature] > node->threshold ? 1 : 0)];
+  }
+  else
+  {
+    for(int d=0; d <= depth && node->feature >= 0; ++d)
+      node = &nodes_[node->child + (point[node->feature] > node->threshold ? 1 : 0)];
+  }
+
+  return &dists_[node->dist];
+}
+
+Eigen::MatrixXf FlatForest::softClassify(const Eigen::MatrixXf &points, int depth, int useNTrees) const
+{
+  const int nLabels = labels_.size();
+  const int nPoints = points.rows();
+
+  CHECK( (size_t)points.cols() >= nFeatures_ ) << "Points have " << points.cols() << " feature dimensions, the forest needs " << nFeatures_ << "!";
+
+  if(useNTrees < 0 || (size_t)useNTrees > nTrees_)
+    useNTrees = nTrees_;
+
+  // split nodes do not contain label distributions, evaluate trees down to leaf nodes
+  if(depth >= 0 && !splitNodesStoreLabelDistribution_)
+    depth = -1;
+
+  Eigen::MatrixXf labelDist = Eigen::MatrixXf::Zero(nPoints, nLabels);
+
+  if(useNTrees == 0)
+    return labelDist;
+
+  const float norm = 1.f / useNTrees;
+  const int nBlocks = (nPoints + FLAT_FOREST_BLOCK_SIZE - 1) / FLAT_FOREST_BLOCK_SIZE;
+
+  #pragma omp parallel
+  {
+    // points of a block as contiguous rows
+    Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> block;
+    Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> blockDist;
+
+    #pragma omp for schedule(dynamic)
+    for(int b=0; b < nBlocks; ++b)
+    {
+      const int start = b * FLAT_FOREST_BLOCK_SIZE;
+      const int n = std::min(FLAT_FOREST_BLOCK_SIZE, nPoints - start);
+      block = points.middleRows(start, n);
+      blockDist = Eigen::MatrixXf::Zero(n, nLabels);
+
+      for(int t=0; t < useNTrees; ++t)
+      {
+        for(int i=0; i < n; ++i)
+        {
+          const float *dist = traverse(roots_[t], block.row(i).data(), depth);
+          float *out = blockDist.row(i).data();
+          for(int l=0; l < nLabels; ++l)
+            out[l] += dist[l];
+        }
+      }
+
+      labelDist.middleRows(start, n) = blockDist * norm;
+    }
+  }
+
+  return labelDist;
+}
+
+Eigen::VectorXi FlatForest::classify(const Eigen::MatrixXf &points, int depth, int useNTrees) const
+{
+  const Eigen::MatrixXf labelDist = softClassify(points, depth, useNTrees);
+  Eigen::VectorXi result(labelDist.rows());
+
+  for(int i=0; i < labelDist.rows(); ++i)
+    labelDist.row(i).maxCoeff(&result(i));
+
+  return result;
+}
+
+std::vector<float> FlatForest::SoftClassify(const std::vector<float>& point, int depth, int useNTrees) const
+{
+  const Eigen::Map<const Eigen::RowVectorXf> p(point.data(), point.size());
+  const Eigen::MatrixXf labelDist = softClassify(p, depth, useNTrees);
+  return std::vector<float>(labelDist.data(), labelDist.data() + labelDist.size());
+}
+
+int FlatForest::ClassifyPoint(const std::vector<float>& point, int depth, int useNTrees) const
+{
+  std::vector<float> labelDist = SoftClassify(point, depth, useNTrees);
+  return std::distance(labelDist.begin(), std::max_element(labelDist.begin(), labelDist.end()));
+}
+
+void FlatForest::save(const std::string &filename) const
+{
+  FlatForestFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, FLAT_FOREST_MAGIC, sizeof(header.magic));
+  header.version = FLAT_FOREST_VERSION;
+  header.endianness = FLAT_FOREST_ENDIANNESS;
+  header.flags = splitNodesStoreLabelDistribution_ ? FLAT_FOREST_SPLIT_NODE_DISTS : 0;
+  header.nLabels = labels_.size();
+  header.nFeatures = nFeatures_;
+  header.nTrees = nTrees_;
+  header.nNodes = nNodes_;
+  header.nDists = nDists_;
+  header.labelsOffset = alignOffset(sizeof(header));
+  header.rootsOffset = alignOffset(header.labelsOffset + labels_.size() * sizeof(int32_t));
+  header.nodesOffset = alignOffset(header.rootsOffset + nTrees_ * sizeof(uint32_t));
+  header.distsOffset = alignOffset(header.nodesOffset + nNodes_ * sizeof(FlatNode));
+
+  std::vector<int32_t> labels(labels_.begin(), labels_.end());
+
+  std::ofstream ofs(filename.c_str(), std::ios::binary | std::ios::trunc);
+  if(!ofs.is_open())
+    throw std::runtime_error("[FlatForest::save] Could not open file " + filename + " for writing!");
+
+  writeAt(ofs, 0, &header, sizeof(header));
+  writeAt(ofs, header.labelsOffset, labels.data(), labels.size() * sizeof(int32_t));
+  writeAt(ofs, header.rootsOffset, roots_, nTrees_ * sizeof(uint32_t));
+  writeAt(ofs, header.nodesOffset, nodes_, nNodes_ * sizeof(FlatNode));
+  writeAt(ofs, header.distsOffset, dists_, nDists_ * sizeof(float));
+
+  if(!ofs.good())
+    throw std::runtime_error("[FlatForest::save] Could not write file " + filename + "!");
+}
+
+void FlatForest::load(const std::string &filename, bool use_mmap)
+{
+  io::MappedFile::ConstPtr mapping( new io::MappedFile(filename) );
+  const char *data = mapping->data();
+  const size_t size = mapping->size();
+
+  FlatForestFileHeader header;
+  if(size < sizeof(header))
+    throw std::runtime_error("[FlatForest::load] File " + filename + " is too small to be a forest file!");
+  memcpy(&header, data, sizeof(header));
+
+  if(memcmp(header.magic, FLAT_FOREST_MAGIC, sizeof(header.magic)) != 0)
+    throw std::runtime_error("[FlatForest::load] File " + filename + " is not a forest file!");
+  if(header.version != FLAT_FOREST_VERSION)
+    throw std::runtime_error("[FlatForest::load] File " + filename + " has an unsupported version!");
+  if(header.endianness != FLAT_FOREST_ENDIANNESS)
+    throw std::runtime_error("[FlatForest::load] File " + filename + " was written on a machine with different byte order!");
+
+  if(!fitsInFile(header.labelsOffset, header.nLabels, sizeof(int32_t), size) ||
+     !fitsInFile(header.rootsOffset, header.nTrees, sizeof(uint32_t), size) ||
+     !fitsInFile(header.nodesOffset, header.nNodes, sizeof(FlatNode), size) ||
+     !fitsInFile(header.distsOffset, header.nDists, sizeof(float), size) ||
+     header.rootsOffset % sizeof(uint32_t) || header.nodesOffset % sizeof(uint32_t) || header.distsOffset % sizeof(float))
+    throw std::runtime_error("[FlatForest::load] File " + filename + " is truncated or corrupted!");
+
+  const int32_t *labels = reinterpret_cast<const int32_t*>(data + header.labelsOffset);
+  labels_.assign(labels, labels + header.nLabels);
+  nFeatures_ = header.nFeatures;
+  splitNodesStoreLabelDistribution_ = (header.flags & FLAT_FOREST_SPLIT_NODE_DISTS) != 0;
+
+  const uint32_t *roots = reinterpret_cast<const uint32_t*>(data + header.rootsOffset);
+  const FlatNode *nodes = reinterpret_cast<const FlatNode*>(data + header.nodesOffset);
+  const float *dists = reinterpret_cast<const float*>(data + header.distsOffset);
+
+  if(use_mmap)
+  {
+    nodeStorage_.clear();
+    rootStorage_.clear();
+    distStorage_.clear();
+    mapping_ = mapping;
+    roots_ = roots;
+    nodes_ = nodes;
+    dists_ = dists;
+    nTrees_ = header.nTrees;
+    nNodes_ = header.nNodes;
+    nDists_ = header.nDists;
+  }
+  else
+  {
+    rootStorage_.assign(roots, roots + header.nTrees);
+    nodeStorage_.assign(nodes, nodes + header.nNodes);
+    distStorage_.assign(dists, dists + header.nDists);
+    useStorage();
+  }
+
+  validate();
+}
+
+void FlatForest::validate() const
+{
+  const size_t nLabels = labels_.size();
+
+  for(size_t t=0; t < nTrees_; t++)
+  {
+    if(roots_[t] >= nNodes_)
+      throw std::runtime_error("[FlatForest::validate] Invalid root node index!");
+  }
+
+  for(size_t i=0; i < nNodes_; i++)
+  {
+    const FlatNode &node = nodes_[i];
+    if(node.feature >= 0 && (size_t)node.feature >= nFeatures_)
+      throw std::runtime_error("[FlatForest::validate] Invalid feature index!");
+    // children are always stored after their parent (see compile()), which rules out self-references and cycles
+    if(node.feature >= 0 && node.child <= i)
+      throw std::runtime_error("[FlatForest::validate] Child node index does not follow its parent (self-reference or cycle)!");
+    if(node.dist != NO_DIST && (size_t)node.dist + nLabels > nDists_)
+      throw std::runtime_error("[FlatForest::validate] Invalid label distribution offset!");
+    if(node.feature >= 0 && (size_t)node.child + 1 >= nNodes_)
+      throw std::runtime_error("[FlatForest::validate] Invalid child node index!");
+    if(node.feature < 0 && node.dist == NO_DIST)
+      throw std::runtime_error("[FlatForest::validate] Leaf node without label distribution!");
+    if(node.feature >= 0 && splitNodesStoreLabelDistribution_ && node.dist == NO_DIST)
+      throw std::runtime_error("[FlatForest::validate] Split node without label distribution!");
+  }
+}
+
+void FlatForest::convertArchive(const std::string &archive_filename, const std::string &filename)
+{
+  Forest forest(archive_filename);
+  FlatForest(forest).save(filename);
+}
@@ -49,14 +49,15 @@ class V4R_EXPORTS IMKRecognizerIO
 private:
   static void generateDir(const std::string &dir, const std::vector<std::string> &object_names, std::string &full_dir);
   static void generateName(const std::string &dir, const std::vector<std::string> &object_names, std::string &full_name);
+  static std::string generateIndexName(const std::string &full_name);
 
 public:
   IMKRecognizerIO() {};
 
-  /** write **/
+  /** write (the trained flann index of the codebook matcher is stored next to the model file) **/
   static void write(const std::string &dir, const std::vector<std::string> &object_names, const std::vector<IMKView> &object_models, const CodebookMatcher &cb, const std::string &codebookFilename="");
 
-  /** read **/
+  /** read (loads the stored flann index if it is not older than the model file, otherwise it is trained) **/
   static bool read(const std::string &dir, std::vector<std::string> &object_names, std::vector<IMKView> &object_models, CodebookMatcher &cb, const std::string &codebookFilename="");
 };
 
@@ -41,7 +41,7 @@ template<typename PointT>
 class V4R_EXPORTS GlobalRecognitionPipeline : public RecognitionPipeline<PointT>
 {
 private:
-    using RecognitionPipeline<PointT>::elapsed_time_;
+    using RecognitionPipeline<PointT>::trace_;
     using RecognitionPipeline<PointT>::scene_;
     using RecognitionPipeline<PointT>::scene_normals_;
     using RecognitionPipeline<PointT>::obj_hypotheses_;
@@ -151,6 +151,12 @@ public:
         visualize_clusters_ = visualize;
     }
 
+    bool
+    visualizationEnabled() const
+    {
+        return visualize_clusters_;
+    }
+
     typedef boost::shared_ptr< GlobalRecognitionPipeline<PointT> > Ptr;
     typedef boost::shared_ptr< GlobalRecognitionPipeline<PointT> const> ConstPtr;
 };
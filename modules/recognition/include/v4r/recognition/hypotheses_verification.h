@@ -27,10 +27,14 @@
 #include <v4r/core/macros.h>
 #include <v4r/common/camera.h>
 #include <v4r/common/color_comparison.h>
+#include <v4r/common/radius_search_grid.h>
 #include <v4r/common/rgb2cielab.h>
+#include <v4r/common/trace.h>
+#include <v4r/common/zbuffering.h>
 #include <v4r/recognition/ghv_opt.h>
 #include <v4r/recognition/hypotheses_verification_param.h>
 #include <v4r/recognition/hypotheses_verification_visualization.h>
+#include <v4r/recognition/lookup_table.h>
 #include <v4r/recognition/object_hypothesis.h>
 
 #include <glog/logging.h>
@@ -144,14 +148,21 @@ protected:
 
     Eigen::MatrixXf intersection_cost_; ///< represents the pairwise intersection cost
 
-    std::vector<std::vector<PtFitness> > scene_pts_explained_solution_;
+    std::vector<std::vector<PtFitness> > scene_pts_explained_solution_; ///< for each downsampled scene point the fitness of all active hypotheses explaining it (sorted ascending)
 
-    static std::vector<std::pair<std::string, float> > elapsed_time_; ///< measurements of computation times for various components
+    // ----- INCREMENTAL COST EVALUATION -----
+    boost::dynamic_bitset<> evaluated_solution_; ///< solution the incremental state (scene_pts_explained_solution_, scene_fitness_, duplicity_, num_explained_pts_per_smooth_label_) corresponds to
+    double duplicity_; ///< sum of the second best explanation of each scene point for evaluated_solution_
+    std::vector<size_t> num_pts_per_smooth_label_; ///< number of downsampled scene points for each smooth region label
+    std::vector<size_t> num_explained_pts_per_smooth_label_; ///< number of downsampled scene points explained by evaluated_solution_ for each smooth region label
+
+    TraceContext::Ptr trace_; ///< measurements of computation times and counters for various components of the current call
+    bool external_trace_;   ///< if true, trace_ has been set from outside and is not reset for each call
 
     float initial_temp_;
     boost::shared_ptr<GHVCostFunctionLogger<ModelT,SceneT> > cost_logger_;
     Eigen::MatrixXf scene_color_channels_; ///< converted color values where each point corresponds to a row entry
-    typename pcl::octree::OctreePointCloudSearch<SceneT>::Ptr octree_scene_downsampled_;
+    RadiusSearchGrid::Ptr scene_grid_downsampled_;   ///< fixed-radius search structure of the downsampled scene (used for model to scene correspondences)
     boost::function<void (const boost::dynamic_bitset<> &, float, int)> visualize_cues_during_logger_;
 
     Eigen::VectorXi scene_pt_smooth_label_id_;  ///< stores a label for each point of the (downsampled) scene. Points belonging to the same smooth clusters, have the same label
@@ -161,8 +172,6 @@ protected:
     std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > absolute_camera_poses_;
     std::vector<boost::dynamic_bitset<> > model_is_present_in_view_; ///< for each model this variable stores information in which view it is present (used to check for visible model points - default all true = static scene)
 
-    boost::function<float (const Eigen::VectorXf&, const Eigen::VectorXf&)> color_dist_f_;
-
     void refinePose(HVRecognitionModel<ModelT> &rm) const;
 
     cv::Mat img_boundary_distance_; ///< saves for each pixel how far it is away from the boundary (taking into account extrinsics of the camera)
@@ -172,8 +181,9 @@ protected:
      * for each model point if it is visible or self-occluded. The visible model cloud is then compared to the scene cloud for occlusion
      * caused by the input scene
      * @param rm recongition model
+     * @param zbuf z-buffer used for rendering (its memory is reused across calls)
      */
-    void computeModelOcclusionByScene(HVRecognitionModel<ModelT> &rm) const; ///< computes the visible points of the model in the given pose and the provided depth map(s) of the scene
+    void computeModelOcclusionByScene(HVRecognitionModel<ModelT> &rm, ZBuffering<ModelT> &zbuf) const; ///< computes the visible points of the model in the given pose and the provided depth map(s) of the scene
 
 
     /**
@@ -198,6 +208,14 @@ protected:
 
     void computeModelFitness (HVRecognitionModel<ModelT> &rm) const;
 
+    /**
+     * @brief computes the model to scene correspondences and the model fitness with the color metric given at compile time
+     * @param rm recognition model
+     * @param color_dist color distance functor (Eigen::Vector3f, Eigen::Vector3f) -> float
+     */
+    template<typename ColorDistance>
+    void computeModelFitness (HVRecognitionModel<ModelT> &rm, const ColorDistance &color_dist) const;
+
     void visualizeGOcues(const boost::dynamic_bitset<> & active_solution, float cost, int times_evaluated) const
     {
         vis_cues_->visualize( this, active_solution, cost, times_evaluated );
@@ -212,6 +230,25 @@ protected:
 
     mets::gol_type evaluateSolution (const boost::dynamic_bitset<> &solution);
 
+    /**
+     * @brief resetIncrementalEvaluation resets the incremental cost evaluation state to the solution where all hypotheses are inactive
+     */
+    void resetIncrementalEvaluation();
+
+    /**
+     * @brief toggleHypothesis updates the incremental cost evaluation state when hypothesis i gets (de-)activated. Only scene points explained by this hypothesis are touched.
+     * @param i hypothesis id
+     * @param activate new activation status of the hypothesis
+     */
+    void toggleHypothesis(size_t i, bool activate);
+
+    /**
+     * @brief violatesSmoothRegionCheck checks if any smooth region is only partially explained
+     * @param num_explained_pts_per_smooth_label number of explained scene points for each smooth region label
+     * @return true if the solution violates the smooth region check
+     */
+    bool violatesSmoothRegionCheck(const std::vector<size_t> &num_explained_pts_per_smooth_label) const;
+
     void optimize();
 
     /**
@@ -234,7 +271,7 @@ protected:
 
     void cleanUp ()
     {
-        octree_scene_downsampled_.reset();
+        scene_grid_downsampled_.reset();
         occlusion_clouds_.clear();
         absolute_camera_poses_.clear();
         scene_sampled_indices_.clear();
@@ -246,6 +283,9 @@ protected:
         scene_pt_smooth_label_id_.resize(0);
         scene_color_channels_.resize(0,0);
         scene_pts_explained_solution_.clear();
+        evaluated_solution_.clear();
+        num_pts_per_smooth_label_.clear();
+        num_explained_pts_per_smooth_label_.clear();
         kdtree_scene_.reset();
     }
 
@@ -263,21 +303,40 @@ protected:
     float
     getFitness( const ModelSceneCorrespondence& c ) const
     {
-        float fit_3d = scoreXYZNormalized (c);
-        float fit_color = scoreColorNormalized (c);
-        float fit_normal = modelSceneNormalsCostTerm(c);
-
-        if ( fit_3d < std::numeric_limits<float>::epsilon() ||
-             fit_color < std::numeric_limits<float>::epsilon() ||
-             fit_normal < std::numeric_limits<float>::epsilon()  )
-            return 0.f;
-
-        float sum_weights = param_.w_xyz_ + param_.w_color_ + param_.w_normals_;
-        float weighted_geometric_mean = exp( ( param_.w_xyz_      * log(fit_3d) +
-                                               param_.w_color_   * log(fit_color ) +
-                                               param_.w_normals_ * log(fit_normal)  )
-                                             / sum_weights );
-        return weighted_geometric_mean;
+        // weighted geometric mean of the individual terms, i.e. exp( sum_i w_i * log(fit_i) / sum_weights )
+        return exp( fitness_xyz_lut_( c.dist_3D_ ) + fitness_color_lut_( c.color_distance_ ) + fitness_normals_lut_( c.normals_dotp_ ) );
+    }
+
+    /**
+     * @brief initFitnessLUT tabulates the weighted logarithm of each term of the geometric mean used in getFitness.
+     * Terms below epsilon are set to a large negative value such that the fitness becomes zero.
+     */
+    void
+    initFitnessLUT()
+    {
+        const float sum_weights = param_.w_xyz_ + param_.w_color_ + param_.w_normals_;
+
+        fitness_xyz_lut_.init( [this, sum_weights](float d) {
+            return weightedLogFitness( scoreXYZ(d) * OneOver_distXYZ0_, param_.w_xyz_ / sum_weights );
+        }, 0.f, search_radius_ );
+
+        // beyond 20 sigma the color term is zero
+        fitness_color_lut_.init( [this, sum_weights](float d) {
+            return weightedLogFitness( scoreColor(d) * OneOver_distColor0_, param_.w_color_ / sum_weights );
+        }, 0.f, std::max( 0.f, param_.inlier_threshold_color_ ) + 20.f * std::abs( param_.sigma_color_ ) );
+
+        fitness_normals_lut_.init( [this, sum_weights](float dotp) {
+            return weightedLogFitness( scoreNormals(dotp) * OneOver_distNorm0_, param_.w_normals_ / sum_weights );
+        }, -1.f, 1.f );
+    }
+
+    static float
+    weightedLogFitness(float fit, float weight)
+    {
+        if( fit < std::numeric_limits<float>::epsilon() )
+            return -1e30f;
+
+        return weight * log(fit);
     }
 
     inline float
@@ -324,7 +383,7 @@ protected:
     inline float
     scoreNormals(float dotp) const
     {
-        return (1.f + tanh( (dotp - param_.inlier_threshold_normals_dotp_) / param_.sigma_normals_ ) );   ///TODO: Speed up with LUT
+        return (1.f + tanh( (dotp - param_.inlier_threshold_normals_dotp_) / param_.sigma_normals_ ) );
     }
 
     /**
@@ -342,17 +401,6 @@ protected:
 //    void
 //    computeLOffset( HVRecognitionModel<ModelT> &rm ) const;
 
-    float
-    customColorDistance(const Eigen::VectorXf &color_a, const Eigen::VectorXf &color_b)
-    {
-        float L_dist  = ( color_a(0) - color_b(0) )*( color_a(0) - color_b(0) );
-        CHECK(L_dist >= 0.f && L_dist <= 1.f);
-        L_dist /= param_.sigma_color_ ;
-        float AB_dist = ( color_a.tail(2) - color_b.tail(2) ).norm(); // ( param_.color_sigma_ab_ * param_.color_sigma_ab_ );
-        CHECK(AB_dist >= 0.f && AB_dist <= 1.f);
-        return L_dist + AB_dist ;
-    }
-
     /**
      * @brief customRegionGrowing constraint function which decides if two points are to be merged as one "smooth" cluster
      * @param seed_pt
@@ -373,30 +421,14 @@ protected:
         return solution_;
     }
 
-    class StopWatch
-    {
-        std::string desc_;
-        boost::posix_time::ptime start_time_;
-
-    public:
-        StopWatch(const std::string &desc)
-            :desc_ (desc), start_time_ (boost::posix_time::microsec_clock::local_time ())
-        {}
-
-        ~StopWatch()
-        {
-            boost::posix_time::ptime end_time = boost::posix_time::microsec_clock::local_time ();
-            float elapsed_time = static_cast<float> (((end_time - start_time_).total_milliseconds ()));
-            VLOG(1) << desc_ << " took " << elapsed_time << " ms.";
-            elapsed_time_.push_back( std::pair<std::string,float>(desc_, elapsed_time) );
-        }
-    };
-
     // pre-computed variables for speed-up
     float OneOver_distNorm0_;
     float OneOver_distColor0_;
     float OneOver_distXYZ0_;
     float search_radius_;
+    LookupTable fitness_xyz_lut_;   ///< weighted log fitness of the 3D distance (see getFitness)
+    LookupTable fitness_color_lut_; ///< weighted log fitness of the color distance (see getFitness)
+    LookupTable fitness_normals_lut_;   ///< weighted log fitness of the surface normals' dot product (see getFitness)
 
 
 public:
@@ -405,6 +437,8 @@ public:
         :
           param_(p),
           cam_(cam),
+          trace_ (new TraceContext),
+          external_trace_ (false),
           initial_temp_(1000),
           OneOver_distNorm0_ ( 1.f / scoreNormals(1.f) ),
           OneOver_distColor0_ (1.f / scoreColor(0.f) ),
@@ -416,20 +450,16 @@ public:
         switch (param_.color_comparison_method_)
         {
         case ColorComparisonMethod::cie76 :
-            color_dist_f_ = CIE76; break;
-
         case ColorComparisonMethod::cie94 :
-            color_dist_f_ = CIE94_DEFAULT; break;
-
         case ColorComparisonMethod::ciede2000 :
-            color_dist_f_ = CIEDE2000; break;
-
-        case 3:
-            color_dist_f_ = boost::bind( &HypothesisVerification::customColorDistance, this, _1, _2 ); break;
+        case 3: // L distance normalized by sigma_color_ plus AB distance
+            break;
 
         default:
             throw std::runtime_error("Color comparison method not defined!");
         }
+
+        initFitnessLUT();
     }
 
 //    /**
@@ -585,7 +615,29 @@ public:
     std::vector<std::pair<std::string, float> >
     getElapsedTimes() const
     {
-        return elapsed_time_;
+        return trace_->getElapsedTimes();
+    }
+
+    /**
+     * @brief sets the trace context into which timings and counters are recorded (e.g. to share it with the caller).
+     * If empty, a new context is created for each call of verify().
+     * @param trace trace context
+     */
+    void
+    setTraceContext(const TraceContext::Ptr &trace)
+    {
+        external_trace_ = static_cast<bool>(trace);
+        trace_ = external_trace_ ? trace : TraceContext::Ptr(new TraceContext);
+    }
+
+    /**
+     * @brief getTraceContext
+     * @return trace context of the last call
+     */
+    TraceContext::Ptr
+    getTraceContext() const
+    {
+        return trace_;
     }
 };
 
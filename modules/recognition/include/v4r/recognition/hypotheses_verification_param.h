@@ -98,6 +98,8 @@ public:
     float min_dotproduct_model_normal_to_viewray_; ///< surfaces which point are oriented away from the viewray will be discarded if the absolute dotproduct between the surface normal and the viewray is smaller than this threshold. This should ignore points for further fitness check which are very sensitive to small rotation changes.
     float min_px_distance_to_image_boundary_; ///< minimum distance in pixel a re-projected point needs to have to the image boundary
 
+    bool incremental_cost_evaluation_; ///< if true, the cost of a solution is evaluated incrementally by only updating the scene points explained by hypotheses that changed their activation status since the last evaluation. Otherwise, the scene explanation is recomputed from scratch for each evaluation.
+
     HV_Parameter () :
           resolution_mm_ (5),
           occlusion_thres_ (0.01f),  // 0.005f
@@ -137,7 +139,8 @@ public:
           min_pts_smooth_cluster_to_be_epxlained_ (50),
           min_fitness_ (0.2f),
           min_dotproduct_model_normal_to_viewray_ (0.2f),
-          min_px_distance_to_image_boundary_ (3.f)
+          min_px_distance_to_image_boundary_ (3.f),
+          incremental_cost_evaluation_ (true)
     {
         min_fitness_high_ = min_fitness_ * 2.f;
     }
@@ -187,6 +190,7 @@ public:
                 ("hv_cluster_tolerance", po::value<float>(&cluster_tolerance_)->default_value(cluster_tolerance_), "smooth clustering parameter for cluster_tolerance")
                 ("hv_curvature_threshold", po::value<float>(&curvature_threshold_)->default_value(curvature_threshold_), "smooth clustering parameter for curvate")
                 ("hv_check_smooth_clusters", po::value<bool>(&check_smooth_clusters_)->default_value(check_smooth_clusters_), "if true, checks for each hypotheses how well it explains occupied smooth surface patches. Hypotheses are rejected if they only partially explain smooth clusters.")
+                ("hv_incremental_cost_evaluation", po::value<bool>(&incremental_cost_evaluation_)->default_value(incremental_cost_evaluation_), "if true, the cost of a solution is evaluated incrementally by only updating the scene points explained by hypotheses that changed their activation status since the last evaluation.")
                 ;
         po::variables_map vm;
         po::parsed_options parsed = po::command_line_parser(command_line_arguments).options(desc).allow_unregistered().run();
@@ -242,6 +246,7 @@ public:
                 & BOOST_SERIALIZATION_NVP(z_adaptive_)
                 & BOOST_SERIALIZATION_NVP(min_pts_smooth_cluster_to_be_epxlained_)
                 & BOOST_SERIALIZATION_NVP(min_fitness_)
+                & BOOST_SERIALIZATION_NVP(incremental_cost_evaluation_)
                 ;
     }
 
@@ -33,10 +33,12 @@
 
 #include <v4r/common/normals.h>
 #include <v4r/common/pcl_visualization_utils.h>
+#include <v4r/common/quantized_descriptors.h>
 #include <v4r/features/local_estimator.h>
 #include <v4r/features/types.h>
 #include <v4r/keypoints/keypoint_extractor.h>
 #include <v4r/io/filesystem.h>
+#include <v4r/io/mapped_file.h>
 #include <v4r/recognition/local_rec_object_hypotheses.h>
 #include <v4r/recognition/source.h>
 
@@ -69,6 +71,13 @@ public:
 
     bool train_on_individual_views_; ///< if true, extracts features from each view of the object model. Otherwise will use the full 3d cloud
 
+    bool batch_feature_matching_; ///< if true, all scene signatures are packed into one query matrix and matched in a single (multi-threaded) FLANN search. Otherwise each signature is matched individually.
+    int feature_matching_threads_; ///< number of threads used for batched feature matching (0... use all available cores)
+
+    bool use_flann_cache_; ///< if true, the concatenated model signatures, their model/keypoint mapping and the built FLANN index are stored in the training directory and memory-mapped on the next start (as long as the trained model set did not change)
+
+    bool quantize_descriptors_; ///< if true, the model signatures are quantized to 8 bit per dimension (with individual offset and scale) for the FLANN index and the FLANN cache. This reduces memory (and bandwidth) by a factor of 4 at the cost of slightly less accurate distances. Query signatures are quantized the same way. Only available for the L1 and L2 norm.
+
     LocalRecognizerParameter( ) :
           kdtree_splits_ (512),
           kdtree_num_trees_ (4),
@@ -84,7 +93,11 @@ public:
           filter_border_pts_ (7),
           boundary_width_ (5),
           required_viewpoint_change_deg_ (10.f),
-          train_on_individual_views_(true)
+          train_on_individual_views_(true),
+          batch_feature_matching_ (true),
+          feature_matching_threads_ (0),
+          use_flann_cache_ (true),
+          quantize_descriptors_ (false)
     {}
 
     void
@@ -130,6 +143,10 @@ private:
                 & BOOST_SERIALIZATION_NVP(boundary_width_)
                 & BOOST_SERIALIZATION_NVP(required_viewpoint_change_deg_)
                 & BOOST_SERIALIZATION_NVP(train_on_individual_views_)
+                & BOOST_SERIALIZATION_NVP(batch_feature_matching_)
+                & BOOST_SERIALIZATION_NVP(feature_matching_threads_)
+                & BOOST_SERIALIZATION_NVP(use_flann_cache_)
+                & BOOST_SERIALIZATION_NVP(quantize_descriptors_)
                 ;
     }
 };
@@ -167,6 +184,14 @@ public:
     boost::shared_ptr<flann::Index<flann::ChiSquareDistance<float> > > flann_index_chisquare_;
     boost::shared_ptr<flann::Index<flann::HellingerDistance<float> > > flann_index_hellinger_;
     boost::shared_ptr<flann::Matrix<float> > flann_data_;
+    io::MappedFile::ConstPtr flann_data_mapping_; ///< if the signatures are loaded from the FLANN cache, flann_data_ (or flann_data_quantized_) points into this memory-mapped file
+
+    // only used if the signatures are quantized (flann_data_ is empty then)
+    boost::shared_ptr<flann::Index<QuantizedL1> > flann_index_l1_quantized_;
+    boost::shared_ptr<flann::Index<QuantizedL2> > flann_index_l2_quantized_;
+    boost::shared_ptr<flann::Matrix<unsigned char> > flann_data_quantized_;
+    std::vector<unsigned char> flann_data_quantized_storage_; ///< memory of flann_data_quantized_ if it is not memory-mapped
+    DescriptorQuantizer quantizer_;
 
     /**
      * @brief The flann_model class stores for each signature to which model and which keypoint it belongs to
@@ -263,6 +288,36 @@ private:
                      const LocalObjectModelDatabase::ConstPtr &model_keypoints_,
                      size_t model_keypoint_offset = 0);
 
+    /**
+     * @brief knnSearch runs the nearest neighbor search on the FLANN index corresponding to the selected distance metric
+     * @param lomdb search space
+     * @param query_desc query feature descriptors (one per row)
+     * @param indices nearest neighbor indices (one row per query)
+     * @param distances nearest neighbor distances (one row per query)
+     * @param search_param FLANN search parameters
+     */
+    void
+    knnSearch (const LocalObjectModelDatabase &lomdb,
+               const ::flann::Matrix<float> &query_desc,
+               ::flann::Matrix<int> &indices,
+               ::flann::Matrix<float> &distances,
+               const ::flann::SearchParams &search_param) const;
+
+    /**
+     * @brief addCorrespondences adds the k nearest neighbors of a single scene keypoint as model-scene correspondences
+     * @param s_idx scene keypoint index
+     * @param indices nearest neighbor indices of the query (knn elements)
+     * @param distances nearest neighbor distances of the query (knn elements)
+     * @param lomdb search space
+     * @param model_keypoint_offset offset added to the model keypoint index
+     */
+    void
+    addCorrespondences (KeypointIndex s_idx,
+                        const int *indices,
+                        const float *distances,
+                        const LocalObjectModelDatabase &lomdb,
+                        size_t model_keypoint_offset);
+
     /**
      * @brief featureEncoding describes each keypoint with corresponding feature descriptor
      * @param est feature estimator
@@ -286,6 +341,44 @@ private:
     std::vector<int>
     getInlier(const std::vector<KeypointIndex> &input_keypoints) const;
 
+    /**
+     * @brief useQuantizedDescriptors
+     * @return true if the model signatures are quantized (i.e. quantization is enabled and supported by the distance metric)
+     */
+    bool
+    useQuantizedDescriptors() const
+    {
+        return param_.quantize_descriptors_ && param_.distance_metric_ != 3 && param_.distance_metric_ != 4;
+    }
+
+    /**
+     * @brief buildFLANNIndex builds the FLANN index (for the selected distance metric) over the signatures stored in lomdb.flann_data_ (or lomdb.flann_data_quantized_)
+     * @param lomdb local object model database
+     */
+    void
+    buildFLANNIndex(LocalObjectModelDatabase &lomdb) const;
+
+    /**
+     * @brief loadFLANNCache memory-maps the signatures and loads the FLANN index stored by saveFLANNCache
+     * @param cache_path file containing the signatures and their model/keypoint mapping
+     * @param index_path file containing the FLANN index
+     * @param fingerprint hash of the trained model set - the cache is only used if it was created for the same fingerprint
+     * @param lomdb local object model database to be filled
+     * @return true if the cache is valid and has been loaded
+     */
+    bool
+    loadFLANNCache(const bf::path &cache_path, const bf::path &index_path, uint64_t fingerprint, LocalObjectModelDatabase &lomdb) const;
+
+    /**
+     * @brief saveFLANNCache stores the signatures, their model/keypoint mapping and the FLANN index of lomdb
+     * @param cache_path file containing the signatures and their model/keypoint mapping
+     * @param index_path file containing the FLANN index
+     * @param fingerprint hash of the trained model set
+     * @param lomdb local object model database
+     */
+    void
+    saveFLANNCache(const bf::path &cache_path, const bf::path &index_path, uint64_t fingerprint, const LocalObjectModelDatabase &lomdb) const;
+
     /**
      * @brief computeFeatures
      * @param est local feature descriptor
@@ -471,6 +564,12 @@ public:
         visualize_keypoints_ = vis;
     }
 
+    bool
+    getVisualizeKeypoints() const
+    {
+        return visualize_keypoints_;
+    }
+
     /**
      * @brief setVisualizationParameter sets the PCL visualization parameter (only used if some visualization is enabled)
      * @param vis_param
@@ -139,7 +139,7 @@ template<typename PointT>
 class V4R_EXPORTS LocalRecognitionPipeline : public RecognitionPipeline<PointT>
 {
 private:
-    using RecognitionPipeline<PointT>::elapsed_time_;
+    using RecognitionPipeline<PointT>::trace_;
     using RecognitionPipeline<PointT>::m_db_;
     using RecognitionPipeline<PointT>::normal_estimator_;
     using RecognitionPipeline<PointT>::obj_hypotheses_;
@@ -162,6 +162,28 @@ private:
     void
     correspondenceGrouping();
 
+    /**
+     * @brief creates an independent instance of the correspondence grouping algorithm which can be used concurrently to cg_algorithm_
+     * @return cloned grouping algorithm or an empty pointer if the type of cg_algorithm_ can not be cloned
+     */
+    typename boost::shared_ptr< pcl::CorrespondenceGrouping<pcl::PointXYZ, pcl::PointXYZ> >
+    cloneCGAlgorithm() const;
+
+    /**
+     * @brief clusters the correspondences of a single model and estimates a pose for each cluster
+     * @param model_id model identity
+     * @param loh local object hypothesis of this model (correspondences will be sorted in place)
+     * @param cg correspondence grouping algorithm used exclusively by the calling thread
+     * @param scene_cloud_xyz scene cloud shared (read-only) among all threads
+     * @param[out] ohgs generated object hypotheses
+     */
+    void
+    correspondenceGrouping(const std::string &model_id,
+                           const LocalObjectHypothesis<PointT> &loh,
+                           pcl::CorrespondenceGrouping<pcl::PointXYZ, pcl::PointXYZ> &cg,
+                           const pcl::PointCloud<pcl::PointXYZ>::ConstPtr &scene_cloud_xyz,
+                           std::vector<ObjectHypothesesGroup> &ohgs) const;
+
     /**
      * @brief recognize
      */
@@ -242,6 +264,17 @@ public:
         return false;
     }
 
+    bool
+    visualizationEnabled() const
+    {
+        for(size_t r_id=0; r_id < local_feature_matchers_.size(); r_id++)
+        {
+            if( local_feature_matchers_[r_id]->getVisualizeKeypoints() )
+                return true;
+        }
+        return false;
+    }
+
 
     /**
      * @brief getLocalObjectModelDatabase
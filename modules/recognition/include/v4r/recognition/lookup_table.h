@@ -0,0 +1,84 @@
+/******************************************************************************
+ * Copyright (c) 2017, Vision4Robotics group, TU Vienna
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+/**
+*
+*      @brief lookup table for smooth scalar functions (e.g. the fitness terms of the hypotheses verification)
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace v4r
+{
+
+/**
+ * @brief Samples a scalar function at equidistant points within [min, max] and evaluates it by linear interpolation.
+ * Arguments outside the range (and NaN) are clamped to the range.
+ */
+class LookupTable
+{
+private:
+    std::vector<float> values_;
+    float min_;
+    float inv_step_;
+
+public:
+    LookupTable() : min_ (0.f), inv_step_ (0.f) { }
+
+    /**
+     * @brief samples the function
+     * @param f function (float -> float)
+     * @param min lower bound of the argument
+     * @param max upper bound of the argument
+     * @param num_samples number of samples (at least 2)
+     */
+    template<typename Function>
+    void
+    init(const Function &f, float min, float max, size_t num_samples = 4096)
+    {
+        values_.resize( num_samples );
+        min_ = min;
+        const float step = (max - min) / (num_samples - 1);
+        inv_step_ = step > 0.f ? 1.f / step : 0.f;
+        for(size_t i=0; i<num_samples; i++)
+            values_[i] = f( min + i * step );
+
+        values_.push_back( values_.back() );    // allows interpolation at max without bounds check
+    }
+
+    float
+    operator()(float x) const
+    {
+        float pos = (x - min_) * inv_step_;
+        const float max_pos = values_.size() - 2;
+        pos = pos > 0.f ? ( pos < max_pos ? pos : max_pos ) : 0.f;
+        const size_t i = static_cast<size_t>(pos);
+        const float t = pos - i;
+        return values_[i] + t * ( values_[i+1] - values_[i] );
+    }
+};
+
+}
@@ -29,6 +29,7 @@
 #include <boost/mpl/at.hpp>
 #include <boost/mpl/map.hpp>
 #include <boost/serialization/vector.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <pcl/common/centroid.h>
 #include <pcl/features/normal_3d_omp.h>
@@ -37,6 +38,7 @@
 #include <pcl/visualization/pcl_visualizer.h>
 
 #include <v4r/core/macros.h>
+#include <v4r/recognition/point_cloud_cache.h>
 
 namespace v4r
 {
@@ -87,6 +89,26 @@ public:
     float self_occlusion_; ///< self-occlusion of respective view
     Eigen::Vector3f elongation_; ///< elongations in meter for each dimension
     Eigen::Matrix4f eigen_pose_alignment_;
+    typename PointCloudCache<PointT>::Ptr cache_; ///< cache used to load the point cloud on demand if it is not kept in memory (if not set, it is loaded from disk on each access)
+
+    /**
+     * @brief returns the point cloud of the view. If it is not kept in memory (cloud_), it is loaded from filename_ (through cache_ if set).
+     * Throws std::runtime_error if the file cannot be loaded.
+     */
+    typename pcl::PointCloud<PointT>::ConstPtr
+    getCloud() const
+    {
+        if( cloud_ )
+            return cloud_;
+
+        if( cache_ )
+            return cache_->get( filename_ );
+
+        typename pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
+        if( pcl::io::loadPCDFile( filename_, *cloud ) == -1 )
+            throw std::runtime_error("Could not load point cloud " + filename_ + "!");
+        return cloud;
+    }
 
     typedef boost::shared_ptr< TrainingView<PointT> > Ptr;
     typedef boost::shared_ptr< TrainingView<PointT> const> ConstPtr;
@@ -98,6 +120,10 @@ public:
 template<typename PointT>
 class V4R_EXPORTS Model
 {
+public:
+    typedef typename pcl::PointCloud<PointT>::Ptr PointTPtr;
+    typedef typename pcl::PointCloud<PointT>::ConstPtr PointTPtrConst;
+
 private:
     mutable pcl::visualization::PCLVisualizer::Ptr vis_;
     mutable int vp1_;
@@ -128,19 +154,31 @@ private:
 
     typedef typename boost::mpl::at<PointTypeAssociations, PointT>::type PointTWithNormal;
 
+    std::string model_filename_; ///< filename of the assembled model (voxelized models are stored next to it)
+    mutable boost::mutex voxelized_mtx_;    ///< guards voxelized_assembled_ and normals_voxelized_assembled_
+    mutable typename std::map<int, PointTPtrConst> voxelized_assembled_;
+    mutable typename std::map<int, pcl::PointCloud<pcl::Normal>::ConstPtr> normals_voxelized_assembled_;
+
+    /**
+     * @brief computes (or loads) the voxelized model cloud and normals for the given resolution. voxelized_mtx_ must be locked by the caller.
+     * @param resolution_mm voxel size in millimeter
+     * @param use_disk_cache if true and the model has been initialized from a file, the voxelized model is loaded from or saved to the model directory
+     */
+    void
+    voxelize(int resolution_mm, bool use_disk_cache) const;
+
+    std::string
+    voxelizedFilename(int resolution_mm) const;
+
 public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-    typedef typename pcl::PointCloud<PointT>::Ptr PointTPtr;
-    typedef typename pcl::PointCloud<PointT>::ConstPtr PointTPtrConst;
     std::vector<typename TrainingView<PointT>::ConstPtr> views_;
     std::string class_, id_;
     Eigen::Vector4f minPoint_; ///< defines the 3D bounding box of the object model
     Eigen::Vector4f maxPoint_; ///< defines the 3D bounding box of the object model
     PointTPtr assembled_;
     pcl::PointCloud<pcl::Normal>::Ptr normals_assembled_;
-    mutable typename std::map<int, PointTPtrConst> voxelized_assembled_;
-    mutable typename std::map<int, pcl::PointCloud<pcl::Normal>::ConstPtr> normals_voxelized_assembled_;
     Eigen::Vector4f centroid_;    ///< centre of gravity for the whole 3d model
     bool centroid_computed_;
 
@@ -185,6 +223,10 @@ public:
 
     pcl::PointCloud<pcl::PointXYZL>::Ptr getAssembledSmoothFaces (int resolution_mm);
 
+    /**
+     * @brief returns the model cloud voxelized at the given resolution (or the full model cloud if resolution_mm <= 0).
+     * Voxelized clouds not precomputed are computed on first request. Thread-safe.
+     */
     typename pcl::PointCloud<PointT>::ConstPtr getAssembled(int resolution_mm) const;
 
     /**
@@ -193,8 +235,21 @@ public:
     void
     initialize(const std::string &model_filename = "");
 
+    /**
+     * @brief returns the normals corresponding to getAssembled(resolution_mm). Thread-safe.
+     */
     pcl::PointCloud<pcl::Normal>::ConstPtr getNormalsAssembled (int resolution_mm) const;
 
+    /**
+     * @brief precomputes the voxelized model cloud and normals for each given resolution, so that getAssembled and
+     * getNormalsAssembled do not need to compute them on first request. Must be called after initialize.
+     * @param resolutions_mm voxel sizes in millimeter
+     * @param use_disk_cache if true and the model has been initialized from a file, voxelized models are loaded from
+     * the model directory if present (and not older than the model file) or saved there otherwise
+     */
+    void
+    precomputeVoxelized(const std::vector<int> &resolutions_mm, bool use_disk_cache = false) const;
+
     typedef boost::shared_ptr< Model<PointT> > Ptr;
     typedef boost::shared_ptr< Model<PointT> const> ConstPtr;
 };
@@ -24,7 +24,6 @@
 #pragma once
 
 #include <v4r/recognition/recognition_pipeline.h>
-#include <omp.h>
 
 namespace v4r
 {
@@ -32,7 +31,7 @@ template<typename PointT>
 class V4R_EXPORTS MultiRecognitionPipeline : public RecognitionPipeline<PointT>
 {
 private:
-    using RecognitionPipeline<PointT>::elapsed_time_;
+    using RecognitionPipeline<PointT>::trace_;
     using RecognitionPipeline<PointT>::scene_;
     using RecognitionPipeline<PointT>::scene_normals_;
     using RecognitionPipeline<PointT>::m_db_;
@@ -44,10 +43,9 @@ private:
 
     std::vector<typename RecognitionPipeline<PointT>::Ptr > recognition_pipelines_;
 
-    omp_lock_t rec_lock_;
-
     /**
-     * @brief recognize
+     * @brief runs all recognition pipelines in parallel (unless one of them visualizes) and merges their hypotheses in the order the pipelines were added
+     * @note the hypothesis order is deterministic, the unique ids assigned to the hypotheses depend on the thread scheduling
      */
     void
     do_recognize();
@@ -119,6 +117,21 @@ public:
         return ret_value;
     }
 
+    /**
+     * @brief visualizationEnabled
+     * @return true if any of the pipelines visualizes intermediate results (the pipelines are then run sequentially)
+     */
+    bool
+    visualizationEnabled() const
+    {
+        for(size_t r_id=0; r_id < recognition_pipelines_.size(); r_id++)
+        {
+            if( recognition_pipelines_[r_id]->visualizationEnabled() )
+                return true;
+        }
+        return false;
+    }
+
     std::vector<typename RecognitionPipeline<PointT>::Ptr >
     getRecognitionPipelines() const
     {
@@ -30,7 +30,9 @@
 
 #pragma once
 
+#include <deque>
 #include <vector>
+#include <boost/thread/thread.hpp>
 #include <pcl/point_cloud.h>
 #include <pcl/point_types.h>
 
@@ -46,7 +48,11 @@ class V4R_EXPORTS MultiviewRecognizerParameter
 {
 public:
     bool transfer_only_verified_hypotheses_;
-    size_t max_views_;  ///<
+    size_t max_views_;  ///< maximum number of views used for recognition (including the current one). Only the most recent max_views_-1 views are kept in memory.
+    bool compact_old_views_; ///< if true, views dropped from the view history are kept as a lightweight summary (camera pose and verified hypotheses)
+    size_t max_view_summaries_; ///< maximum number of view summaries kept in memory (oldest are dropped first)
+    std::string spill_dir_; ///< if not empty, views dropped from the view history are written into this directory (see MultiviewRecognizer::loadSpilledView). The files are removed again on clear() and destruction.
+    size_t max_spilled_views_; ///< maximum number of views kept in the spill directory (oldest are deleted first, 0... no limit)
 
     bool transfer_keypoint_correspondences_; ///< if true, transfers keypoint correspondences instead of full hypotheses (requires correspondence grouping)
     bool merge_close_hypotheses_; ///< if true, close correspondence clusters (object hypotheses) of the same object model are merged together and this big cluster is refined
@@ -61,6 +67,10 @@ public:
     MultiviewRecognizerParameter( ) :
         transfer_only_verified_hypotheses_ (true),
         max_views_(3),
+        compact_old_views_ (true),
+        max_view_summaries_ (1000),
+        spill_dir_ (""),
+        max_spilled_views_ (1000),
         transfer_keypoint_correspondences_ (false),
         merge_close_hypotheses_ (true),
         merge_close_hypotheses_dist_ (0.02f),
@@ -123,6 +133,10 @@ public:
                 ("mv_rec_min_dist_", po::value<float>(&min_dist_)->default_value(min_dist_), "")
                 ("mv_rec_max_dotp_", po::value<float>(&max_dotp_)->default_value(max_dotp_), "")
                 ("mv_visualize", po::value<bool>(&visualize_)->default_value(visualize_), "visualize keypoint correspondences")
+                ("mv_compact_old_views", po::value<bool>(&compact_old_views_)->default_value(compact_old_views_), "if true, keeps a summary (camera pose and verified hypotheses) of views dropped from the view history")
+                ("mv_max_view_summaries", po::value<size_t>(&max_view_summaries_)->default_value(max_view_summaries_), "maximum number of view summaries kept in memory")
+                ("mv_spill_dir", po::value<std::string>(&spill_dir_)->default_value(spill_dir_), "if set, views dropped from the view history are written into this directory")
+                ("mv_max_spilled_views", po::value<size_t>(&max_spilled_views_)->default_value(max_spilled_views_), "maximum number of views kept in the spill directory (oldest are deleted first, 0... no limit)")
                 ;
         po::variables_map vm;
         po::parsed_options parsed = po::command_line_parser(command_line_arguments).options(desc).allow_unregistered().run();
@@ -155,6 +169,7 @@ private:
     using RecognitionPipeline<PointT>::obj_hypotheses_;
     using RecognitionPipeline<PointT>::table_plane_;
     using RecognitionPipeline<PointT>::table_plane_set_;
+    using RecognitionPipeline<PointT>::trace_;
 
     typename RecognitionPipeline<PointT>::Ptr recognition_pipeline_;
 
@@ -164,6 +179,7 @@ private:
 
     struct View
     {
+        size_t id_; ///< running index of the view
         Eigen::Matrix4f camera_pose_;   ///< camera pose of the view which aligns cloud in registered cloud when multiplied
         std::vector< ObjectHypothesesGroup > obj_hypotheses_;   ///< generated object hypotheses
 
@@ -175,11 +191,41 @@ private:
         EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
         View() :
+              id_ (0),
               camera_pose_ (Eigen::Matrix4f::Identity())
         {}
     };
 
-    std::vector<View> views_;
+    std::deque<View, Eigen::aligned_allocator<View> > views_; ///< most recent views used for recognition (bounded by max_views_)
+    size_t view_counter_; ///< number of views processed so far
+
+    void
+    evictView(const View &v);
+
+    std::deque<size_t> spilled_view_ids_; ///< ids of the views currently stored in the spill directory (oldest first)
+    mutable boost::thread spill_thread_; ///< writes the most recently dropped view into the spill directory
+    std::string spill_prefix_; ///< file name prefix unique to this instance, so recognizers sharing the spill directory do not overwrite each other's views
+
+    static std::string
+    createSpillPrefix();
+
+    std::string
+    spilledViewPath(size_t view_id) const;  ///< path of the spilled view files (without suffix)
+
+    void
+    spillView(const View &v);
+
+    static void
+    writeSpilledView(const std::string &view_path, boost::shared_ptr<const View> v);
+
+    void
+    removeSpilledView(size_t view_id) const;
+
+    void
+    clearSpilledViews();
+
+    static size_t
+    memoryUsage(const View &v);
 
     // for keypoint correspondence transfer
     typename boost::shared_ptr< pcl::CorrespondenceGrouping<pcl::PointXYZ, pcl::PointXYZ> > cg_algorithm_;  ///< algorithm for correspondence grouping
@@ -191,11 +237,31 @@ private:
 
     void visualize();
 
+public:
+    /**
+     * @brief lightweight summary of a view that has been dropped from the view history
+     */
+    struct ViewSummary
+    {
+        size_t id_; ///< running index of the view
+        Eigen::Matrix4f camera_pose_;   ///< camera pose of the view
+        std::vector< ObjectHypothesesGroup > verified_hypotheses_;   ///< verified object hypotheses of the view (in the view's camera frame)
+
+        EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    };
+
+private:
+    std::deque<ViewSummary, Eigen::aligned_allocator<ViewSummary> > view_summaries_;    ///< summaries of views dropped from the view history (bounded by max_view_summaries_)
+
 public:
     MultiviewRecognizer(const MultiviewRecognizerParameter &p = MultiviewRecognizerParameter() )
-        : param_ (p)
+        : param_ (p),
+          view_counter_ (0),
+          spill_prefix_ (createSpillPrefix())
     { }
 
+    ~MultiviewRecognizer();
+
     void
     initialize(const std::string &trained_dir = "", bool retrain = false);
 
@@ -249,8 +315,50 @@ public:
     clear()
     {
         views_.clear();
+        view_summaries_.clear();
+        clearSpilledViews();
     }
 
+    /**
+     * @brief returns summaries of the views that have been dropped from the view history (oldest first)
+     */
+    const std::deque<ViewSummary, Eigen::aligned_allocator<ViewSummary> > &
+    getViewSummaries() const
+    {
+        return view_summaries_;
+    }
+
+    /**
+     * @brief getNumStoredViews
+     * @return number of views currently kept in the view history
+     */
+    size_t
+    getNumStoredViews() const
+    {
+        return views_.size();
+    }
+
+    /**
+     * @brief estimates the memory held by the view history and view summaries
+     * @return memory usage in bytes
+     */
+    size_t
+    getMemoryUsage() const;
+
+    /**
+     * @brief loads the camera pose and object hypotheses of a view that has been written to the spill directory
+     * @param view_id running index of the view
+     * @param[out] camera_pose camera pose of the view
+     * @param[out] obj_hypotheses object hypotheses of the view
+     * @param[out] scene_cloud_xyz scene cloud of the view (only available if keypoint correspondences are transferred)
+     * @param[out] scene_normals scene normals of the view (only available if keypoint correspondences are transferred)
+     * @return true if the view was found and could be read (unreadable views are logged and skipped)
+     */
+    bool
+    loadSpilledView(size_t view_id, Eigen::Matrix4f &camera_pose, std::vector<ObjectHypothesesGroup> &obj_hypotheses,
+                    pcl::PointCloud<pcl::PointXYZ>::Ptr scene_cloud_xyz = pcl::PointCloud<pcl::PointXYZ>::Ptr(),
+                    pcl::PointCloud<pcl::Normal>::Ptr scene_normals = pcl::PointCloud<pcl::Normal>::Ptr()) const;
+
 
     /**
      * @brief setCGAlgorithm
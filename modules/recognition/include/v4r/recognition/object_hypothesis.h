@@ -24,6 +24,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include <boost/serialization/serialization.hpp>
 #include <boost/serialization/shared_ptr.hpp>
 #include <boost/serialization/split_member.hpp>
@@ -35,6 +37,7 @@
 #include <v4r/core/macros.h>
 #include <v4r/common/pcl_serialization.h>
 #include <v4r/recognition/model.h>
+#include <v4r/recognition/silhouette.h>
 #include <v4r/recognition/source.h>
 
 namespace v4r
@@ -60,7 +63,7 @@ private:
          ;
     }
 
-    static size_t s_counter_; /// unique identifier to avoid transfering hypotheses multiple times when using multi-view recognition
+    static std::atomic<size_t> s_counter_; /// unique identifier to avoid transfering hypotheses multiple times when using multi-view recognition
 
 public:
     EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -93,7 +96,7 @@ public:
     Eigen::Matrix4f pose_refinement_; ///< pose refinement (to be multiplied by transform to get refined pose)
     float confidence_; ///< confidence score (coming from feature matching stage)
     bool is_verified_;
-    size_t unique_id_;
+    size_t unique_id_; ///< drawn from s_counter_, unique but not reproducible when hypotheses are created concurrently
 
     virtual ~ObjectHypothesis(){}
 };
@@ -144,6 +147,7 @@ public:
     typename pcl::PointCloud<PointT>::Ptr visible_cloud_;
     pcl::PointCloud<pcl::Normal>::Ptr visible_cloud_normals_;
     std::vector<boost::dynamic_bitset<> > image_mask_; ///< image mask per view (in single-view case, there will be only one element in outer vector). Used to compute pairwise intersection
+    std::vector<Silhouette> silhouettes_; ///< compact representation of the image mask per view (computed by processSilhouette)
 //    pcl::PointCloud<pcl::Normal>::Ptr complete_cloud_normals_;
     std::vector<int> visible_indices_;  ///< visible indices computed by z-Buffering (for model self-occlusion) and occlusion reasoning with scene cloud
     std::vector<int> visible_indices_by_octree_; ///< visible indices computed by creating an octree for the model and checking which leaf nodes are occupied by a visible point computed from the z-buffering approach
@@ -182,6 +186,7 @@ public:
         visible_cloud_normals_.reset();
         visible_indices_.clear();
         image_mask_.clear();
+        silhouettes_.clear();
         model_scene_c_.clear();
         pt_color_.resize(0,0);
         scene_indices_in_crop_box_.clear();
@@ -0,0 +1,169 @@
+/******************************************************************************
+ * Copyright (c) 2017, Vision4Robotics group, TU Vienna
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+/**
+*
+*      @brief cache for point clouds loaded from disk (e.g. training views of the object models)
+*/
+
+#pragma once
+
+#include <list>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_cloud.h>
+
+#include <v4r/core/macros.h>
+
+namespace v4r
+{
+
+/**
+ * @brief Loads point clouds from PCD files on first access and keeps the least recently used ones in memory as long as
+ * their total size does not exceed the given budget. Thread-safe. Clouds still referenced by the caller stay valid
+ * after being evicted from the cache.
+ */
+template<typename PointT>
+class PointCloudCache
+{
+private:
+    typedef typename pcl::PointCloud<PointT>::ConstPtr CloudConstPtr;
+
+    struct Entry
+    {
+        CloudConstPtr cloud_;
+        size_t size_;   ///< memory used by the cloud in bytes
+        typename std::list<std::string>::iterator lru_it_;
+    };
+
+    mutable boost::mutex mtx_;
+    size_t max_size_;   ///< budget in bytes
+    size_t size_;   ///< memory used by all cached clouds in bytes
+    std::map<std::string, Entry> entries_;
+    std::list<std::string> lru_;    ///< filenames of cached clouds, most recently used first
+
+    void
+    evict()
+    {
+        while( size_ > max_size_ && !lru_.empty() )
+        {
+            const auto it = entries_.find( lru_.back() );
+            size_ -= it->second.size_;
+            entries_.erase( it );
+            lru_.pop_back();
+        }
+    }
+
+public:
+    typedef boost::shared_ptr< PointCloudCache<PointT> > Ptr;
+    typedef boost::shared_ptr< PointCloudCache<PointT> const> ConstPtr;
+
+    /**
+     * @param max_size budget in bytes (0 disables caching, i.e. clouds are loaded from disk on each access)
+     */
+    explicit PointCloudCache(size_t max_size = 0)
+        : max_size_ (max_size), size_ (0)
+    { }
+
+    /**
+     * @brief returns the point cloud stored in the given PCD file (loads it from disk if it is not cached).
+     * Throws std::runtime_error if the file cannot be loaded (failed loads are not cached).
+     */
+    CloudConstPtr
+    get(const std::string &filename)
+    {
+        {
+            boost::mutex::scoped_lock lock(mtx_);
+            const auto it = entries_.find( filename );
+            if( it != entries_.end() )
+            {
+                lru_.splice( lru_.begin(), lru_, it->second.lru_it_ );
+                return it->second.cloud_;
+            }
+        }
+
+        // load without holding the lock so that several clouds can be loaded in parallel
+        typename pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
+        if( pcl::io::loadPCDFile(filename, *cloud) == -1 )
+            throw std::runtime_error("Could not load point cloud " + filename + "!");
+
+        const size_t size = cloud->points.size() * sizeof(PointT);
+
+        boost::mutex::scoped_lock lock(mtx_);
+        if( size > max_size_ || entries_.find( filename ) != entries_.end() )
+            return cloud;
+
+        lru_.push_front( filename );
+        Entry &e = entries_[ filename ];
+        e.cloud_ = cloud;
+        e.size_ = size;
+        e.lru_it_ = lru_.begin();
+        size_ += size;
+        evict();
+        return cloud;
+    }
+
+    /**
+     * @brief sets the budget in bytes and evicts clouds if necessary
+     */
+    void
+    setMaxSize(size_t max_size)
+    {
+        boost::mutex::scoped_lock lock(mtx_);
+        max_size_ = max_size;
+        evict();
+    }
+
+    size_t
+    getMaxSize() const
+    {
+        boost::mutex::scoped_lock lock(mtx_);
+        return max_size_;
+    }
+
+    /**
+     * @return memory used by all cached clouds in bytes
+     */
+    size_t
+    size() const
+    {
+        boost::mutex::scoped_lock lock(mtx_);
+        return size_;
+    }
+
+    void
+    clear()
+    {
+        boost::mutex::scoped_lock lock(mtx_);
+        entries_.clear();
+        lru_.clear();
+        size_ = 0;
+    }
+};
+
+}
@@ -29,6 +29,7 @@
 #include <v4r_config.h>
 #include <v4r/common/normals.h>
 #include <v4r/common/pcl_visualization_utils.h>
+#include <v4r/common/trace.h>
 #include <v4r/core/macros.h>
 #include <v4r/recognition/object_hypothesis.h>
 #include <v4r/recognition/source.h>
@@ -63,34 +64,17 @@ protected:
     Eigen::Vector4f table_plane_;
     bool table_plane_set_;
 
-    static std::vector< std::pair<std::string,float> > elapsed_time_;  ///< to measure performance
-
-    class StopWatch
-    {
-        std::string desc_;
-        boost::posix_time::ptime start_time_;
-
-    public:
-        StopWatch(const std::string &desc)
-            :desc_ (desc), start_time_ (boost::posix_time::microsec_clock::local_time ())
-        {}
-
-        ~StopWatch()
-        {
-            boost::posix_time::ptime end_time = boost::posix_time::microsec_clock::local_time ();
-            float elapsed_time = static_cast<float> (((end_time - start_time_).total_milliseconds ()));
-            VLOG(1) << desc_ << " took " << elapsed_time << " ms.";
-            elapsed_time_.push_back( std::pair<std::string,float>(desc_, elapsed_time) );
-        }
-    };
-
+    TraceContext::Ptr trace_;  ///< collects computation times of the current call (to measure performance)
+    bool external_trace_;   ///< if true, trace_ has been set from outside and is not reset for each call
 
     PCLVisualizationParams::ConstPtr vis_param_;
 
 public:
     RecognitionPipeline() :
         table_plane_(Eigen::Vector4f::Identity()),
-        table_plane_set_(false)
+        table_plane_set_(false),
+        trace_ (new TraceContext),
+        external_trace_ (false)
     {}
 
     virtual ~RecognitionPipeline(){}
@@ -200,7 +184,39 @@ public:
     std::vector<std::pair<std::string, float> >
     getElapsedTimes() const
     {
-        return elapsed_time_;
+        return trace_->getElapsedTimes();
+    }
+
+    /**
+     * @brief sets the trace context into which timings and counters are recorded (e.g. to share it with the caller).
+     * If empty, a new context is created for each call of recognize().
+     * @param trace trace context
+     */
+    void
+    setTraceContext(const TraceContext::Ptr &trace)
+    {
+        external_trace_ = static_cast<bool>(trace);
+        trace_ = external_trace_ ? trace : TraceContext::Ptr(new TraceContext);
+    }
+
+    /**
+     * @brief getTraceContext
+     * @return trace context of the last call
+     */
+    TraceContext::Ptr
+    getTraceContext() const
+    {
+        return trace_;
+    }
+
+    /**
+     * @brief visualizationEnabled
+     * @return true if recognize() opens visualization windows. Such pipelines are not run concurrently with other pipelines as PCL visualizers are not thread-safe
+     */
+    virtual bool
+    visualizationEnabled() const
+    {
+        return false;
     }
 
     virtual bool requiresSegmentation() const = 0;
@@ -209,7 +225,8 @@ public:
     void
     recognize ()
     {
-        elapsed_time_.clear();
+        if( !external_trace_ )
+            trace_.reset( new TraceContext );
         obj_hypotheses_.clear();
         CHECK ( scene_ ) << "Input scene is not set!";
 
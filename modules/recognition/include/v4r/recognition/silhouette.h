@@ -0,0 +1,96 @@
+/******************************************************************************
+ * Copyright (c) 2017, Vision4Robotics group, TU Vienna
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+/**
+*
+*      @brief compact 2D silhouette (binary image mask) of a rendered object hypothesis
+*/
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#include <boost/dynamic_bitset.hpp>
+#include <v4r/core/macros.h>
+
+namespace v4r
+{
+
+/**
+ * @brief Stores a binary image mask only within its bounding rectangle, packed into 64-bit words per image row.
+ * Words are aligned to the image columns (word w covers columns 64w ... 64w+63), so two silhouettes of the same
+ * image can be intersected word by word over their overlapping rectangle.
+ */
+class V4R_EXPORTS Silhouette
+{
+private:
+    int rows_begin_;    ///< first image row within the bounding rectangle
+    int rows_end_;  ///< one past the last image row within the bounding rectangle
+    int words_begin_;   ///< first word (column / 64) within the bounding rectangle
+    int words_end_; ///< one past the last word within the bounding rectangle
+    size_t num_pixels_; ///< number of set pixels
+    std::vector<uint64_t> words_;   ///< row-major, (rows_end_-rows_begin_) x (words_end_-words_begin_)
+
+public:
+    Silhouette();
+
+    /**
+     * @brief creates the silhouette from a row-major image mask
+     * @param mask image mask
+     * @param width image width
+     */
+    Silhouette(const boost::dynamic_bitset<> &mask, int width);
+
+    /**
+     * @return number of set pixels
+     */
+    size_t
+    size() const
+    {
+        return num_pixels_;
+    }
+
+    bool
+    empty() const
+    {
+        return num_pixels_ == 0;
+    }
+
+    /**
+     * @return number of pixels set in both silhouettes
+     */
+    size_t
+    intersection(const Silhouette &other) const;
+
+    /**
+     * @return number of pixels set in any of the two silhouettes
+     */
+    size_t
+    unification(const Silhouette &other) const
+    {
+        return num_pixels_ + other.num_pixels_ - intersection(other);
+    }
+};
+
+}
@@ -24,6 +24,8 @@
 
 #pragma once
 
+#include <exception>
+
 #include <v4r/core/macros.h>
 #include <v4r/recognition/model.h>
 
@@ -54,6 +56,7 @@ protected:
     std::string pose_prefix_;
     std::string indices_prefix_;
     std::string entropy_prefix_;
+    typename PointCloudCache<PointT>::Ptr view_cache_; ///< cache shared by all training views to load their point clouds on demand
 
 public:
     Source() :
@@ -64,7 +67,8 @@ public:
         view_prefix_("cloud_"),
         pose_prefix_ ("pose_"),
         indices_prefix_ ("object_indices_"),
-        entropy_prefix_ ("entropy_")
+        entropy_prefix_ ("entropy_"),
+        view_cache_ (new PointCloudCache<PointT>)
     { }
 
     /**
@@ -76,8 +80,12 @@ public:
      * each other which filename begins with the string in variable pose_prefix
      * @param has_categories if true, reads a model database used for classification, i.e. there is another top-level folders for each category and
      * inside each category folder there is the same structure as for instance recognition
+     * @param view_cache cache for the point clouds of the training views. These are only loaded from disk when first accessed
+     * and kept in memory as long as they fit into the budget of the cache. If not set, a cache without budget is used (i.e. views are loaded on each access).
+     * Models are loaded in parallel.
      */
-    Source(const std::string &model_database_path, bool has_categories = false);
+    Source(const std::string &model_database_path, bool has_categories = false,
+           const typename PointCloudCache<PointT>::Ptr &view_cache = typename PointCloudCache<PointT>::Ptr() );
 
     void
     setLoadIntoMemory(bool b)
@@ -149,6 +157,46 @@ public:
         models_.push_back(m);
     }
 
+    /**
+     * @brief precomputes the voxelized clouds and normals of all models at the given resolutions (see Model::precomputeVoxelized)
+     * @param resolutions_mm voxel sizes in millimeter
+     * @param use_disk_cache if true, voxelized models are loaded from or stored in the model directories
+     */
+    void
+    precomputeVoxelizedModels(const std::vector<int> &resolutions_mm, bool use_disk_cache = false) const
+    {
+        std::exception_ptr exception;   // exceptions must not leave the parallel region
+
+#pragma omp parallel for schedule(dynamic)
+        for(size_t i=0; i<models_.size(); i++)
+        {
+            try
+            {
+                models_[i]->precomputeVoxelized( resolutions_mm, use_disk_cache );
+            }
+            catch(...)
+            {
+#pragma omp critical
+                {
+                    if( !exception )
+                        exception = std::current_exception();
+                }
+            }
+        }
+
+        if( exception )
+            std::rethrow_exception( exception );
+    }
+
+    /**
+     * @brief returns the cache used to load the point clouds of the training views (e.g. to change its budget)
+     */
+    typename PointCloudCache<PointT>::Ptr
+    getTrainingViewCache() const
+    {
+        return view_cache_;
+    }
+
     void
     setLoadViews(bool load)
     {
@@ -81,6 +81,16 @@ void IMKRecognizerIO::generateName(const std::string &dir, const std::vector<std
   full_name+=std::string(".bin");
 }
 
+/**
+ * @brief IMKRecognizerIO::generateIndexName
+ * @param full_name model file
+ * @return file name of the flann index
+ */
+std::string IMKRecognizerIO::generateIndexName(const std::string &full_name)
+{
+  return boost::filesystem::path(full_name).replace_extension(".flann").string();
+}
+
 /************************ PUBLIC *****************************/
 
 /** 
@@ -102,13 +112,19 @@ void IMKRecognizerIO::write(const std::string &dir, const std::vector<std::strin
   cv::Mat cb_centers = cb.getDescriptors();
   std::vector< std::vector< std::pair<int,int> > > cb_entries = cb.getEntries();
 //  std::ofstream ofs((full_dir+std::string("/imk_recognizer_model.bin")).c_str());
-  std::ofstream ofs(full_name.c_str());
+  {
+    std::ofstream ofs(full_name.c_str());
+
+    boost::archive::binary_oarchive oa(ofs);
+    oa << object_names;
+    oa << object_models;
+    oa << cb_centers;
+    oa << cb_entries;
+  }
 
-  boost::archive::binary_oarchive oa(ofs);
-  oa << object_names;
-  oa << object_models;
-  oa << cb_centers;
-  oa << cb_entries;
+  // the index is written after the model file -> read() can detect outdated indices
+  if (!cb.saveIndex(generateIndexName(full_name)))
+    boost::filesystem::remove(generateIndexName(full_name));
 }
 
 /** 
@@ -137,7 +153,13 @@ bool IMKRecognizerIO::read(const std::string &dir, std::vector<std::string> &obj
     ia >> object_models;
     ia >> cb_centers;
     ia >> cb_entries;
-    cb.setCodebook( cb_centers, cb_entries );
+
+    std::string index_name = generateIndexName(full_name);
+    if ( !boost::filesystem::exists(index_name) ||
+         boost::filesystem::last_write_time(index_name) < boost::filesystem::last_write_time(full_name) )
+      index_name.clear();
+
+    cb.setCodebook( cb_centers, cb_entries, index_name );
     return true;
   }
   return false;
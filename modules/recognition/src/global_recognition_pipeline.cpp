@@ -34,7 +34,7 @@ GlobalRecognitionPipeline<PointT>::do_recognize()
     clusters_.clear();
 
     {
-        typename RecognitionPipeline<PointT>::StopWatch t("Segmentation");
+        TraceSpan t(trace_, "Segmentation");
         seg_->setInputCloud(scene_);
         seg_->setNormalsCloud(scene_normals_);
         seg_->segment();
@@ -49,7 +49,7 @@ GlobalRecognitionPipeline<PointT>::do_recognize()
         obj_hypotheses_wo_elongation_check_.resize(clusters_.size() );
     }
 
-    typename RecognitionPipeline<PointT>::StopWatch t("Global recognition");
+    TraceSpan t(trace_, "Global recognition");
     size_t kept=0;
     for(size_t i=0; i<clusters_.size(); i++)
     {
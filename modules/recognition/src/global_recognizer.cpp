@@ -114,9 +114,7 @@ GlobalRecognizer<PointT>::initialize(const std::string &trained_dir, bool retrai
                 }
                 else
                 {
-                    typename pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
-                    pcl::io::loadPCDFile(tv->filename_, *cloud);
-                    scene_ = cloud;
+                    scene_ = tv->getCloud();
 
                     // read pose from file (if exists)
                     try
@@ -67,7 +67,7 @@ HypothesisVerification<ModelT, SceneT>::customRegionGrowing (const SceneTWithNor
 
 template<typename ModelT, typename SceneT>
 void
-HypothesisVerification<ModelT, SceneT>::computeModelOcclusionByScene(HVRecognitionModel<ModelT> &rm) const
+HypothesisVerification<ModelT, SceneT>::computeModelOcclusionByScene(HVRecognitionModel<ModelT> &rm, ZBuffering<ModelT> &zbuf) const
 {
     bool found_model_foo;
     typename Model<ModelT>::ConstPtr m = m_db_->getModelById("", rm.oh_->model_id_, found_model_foo);
@@ -93,13 +93,6 @@ HypothesisVerification<ModelT, SceneT>::computeModelOcclusionByScene(HVRecogniti
         pcl::transformPointCloud(*model_cloud_aligned, *aligned_cloud, tf);
         v4r::transformNormals(*model_normals_aligned, *aligned_normals, tf);
 
-        ZBufferingParameter zBparam;
-        zBparam.do_noise_filtering_ = false;
-        zBparam.do_smoothing_ = false;
-//        zBparam.smoothing_radius_ = 5;
-        zBparam.inlier_threshold_ = 0.015f;
-        zBparam.use_normals_ = true;
-        ZBuffering<ModelT> zbuf (cam_, zBparam);
         zbuf.setCloudNormals( aligned_normals );
         typename pcl::PointCloud<ModelT>::Ptr organized_cloud_to_be_filtered (new pcl::PointCloud<ModelT>);
         zbuf.renderPointCloud( *aligned_cloud, *organized_cloud_to_be_filtered, 2 );
@@ -209,6 +202,7 @@ HypothesisVerification<ModelT, SceneT>::computeModelOcclusionByScene(HVRecogniti
 //        cv::imshow("reg_mask", registration_depth_mask);
 //        cv::waitKey();
     }
+    zbuf.setCloudNormals( pcl::PointCloud<pcl::Normal>::ConstPtr() );  // do not keep the normals of this hypothesis alive in the z-buffer
 
     std::vector<int> visible_indices_tmp_full = createIndicesFromMask<int>(image_mask_mv);
     typename pcl::PointCloud<ModelT>::Ptr visible_cloud_full ( new pcl::PointCloud<ModelT> );
@@ -452,62 +446,159 @@ HypothesisVerification<ModelT, SceneT>::removeSceneNans()
 
 
 template<typename ModelT, typename SceneT>
-mets::gol_type
-HypothesisVerification<ModelT, SceneT>::evaluateSolution (const boost::dynamic_bitset<> &solution)
+void
+HypothesisVerification<ModelT, SceneT>::resetIncrementalEvaluation()
 {
+    evaluated_solution_ = boost::dynamic_bitset<>( global_hypotheses_.size(), 0 );
     scene_pts_explained_solution_.clear();
     scene_pts_explained_solution_.resize( scene_cloud_downsampled_->points.size() );
-    double cost = std::numeric_limits<double>::max();
+    scene_fitness_ = duplicity_ = 0.;
 
-    for(size_t i=0; i<global_hypotheses_.size(); i++)
-    {
-        const typename HVRecognitionModel<ModelT>::Ptr rm = global_hypotheses_[i];
+    num_pts_per_smooth_label_.clear();
+    num_explained_pts_per_smooth_label_.clear();
 
-        if( !solution[i])
-            continue;
+    if (param_.check_smooth_clusters_)
+    {
+        num_pts_per_smooth_label_.resize( scene_pt_smooth_label_id_.maxCoeff() + 1, 0 );
+        for(int s_id=0; s_id < scene_pt_smooth_label_id_.rows(); s_id++)
+            num_pts_per_smooth_label_[ scene_pt_smooth_label_id_(s_id) ]++;
 
-        for (Eigen::SparseVector<float>::InnerIterator it(rm->scene_explained_weight_); it; ++it)
-            scene_pts_explained_solution_[ it.row() ].push_back( PtFitness(it.value(), i) );
+        num_explained_pts_per_smooth_label_.resize( num_pts_per_smooth_label_.size(), 0 );
     }
+}
 
-    for(auto spt_it = scene_pts_explained_solution_.begin(); spt_it!=scene_pts_explained_solution_.end(); ++spt_it)
-        std::sort(spt_it->begin(), spt_it->end());
-
-    double scene_fit = 0., duplicity = 0.;
-    Eigen::Array<bool, Eigen::Dynamic, 1> scene_pt_is_explained( scene_cloud_downsampled_->points.size() );
-    scene_pt_is_explained.setConstant( scene_cloud_downsampled_->points.size(), false);
+template<typename ModelT, typename SceneT>
+void
+HypothesisVerification<ModelT, SceneT>::toggleHypothesis(size_t i, bool activate)
+{
+    const HVRecognitionModel<ModelT> &rm = *global_hypotheses_[i];
 
-    for(size_t s_id=0; s_id < scene_cloud_downsampled_->points.size(); s_id++)
+    for (Eigen::SparseVector<float>::InnerIterator it(rm.scene_explained_weight_); it; ++it)
     {
-        const std::vector<PtFitness> &s_pt = scene_pts_explained_solution_[s_id];
-        if(  !s_pt.empty() )
+        std::vector<PtFitness> &s_pt = scene_pts_explained_solution_[ it.row() ];
+        const bool was_explained = !s_pt.empty();
+
+        // remove old contribution of this scene point
+        if( s_pt.size() > 0 )
+            scene_fitness_ -= s_pt.back().fit_;
+        if( s_pt.size() > 1 )
+            duplicity_ -= s_pt[ s_pt.size() - 2 ].fit_;
+
+        if( activate )
+        {
+            const PtFitness new_fit ( it.value(), i );
+            s_pt.insert( std::upper_bound( s_pt.begin(), s_pt.end(), new_fit ), new_fit );
+        }
+        else
+        {
+            for(auto pt_fit_it = s_pt.begin(); pt_fit_it != s_pt.end(); ++pt_fit_it)
+            {
+                if( pt_fit_it->rm_id_ == i )
+                {
+                    s_pt.erase( pt_fit_it );
+                    break;
+                }
+            }
+        }
+
+        // add new contribution of this scene point
+        if( s_pt.size() > 0 )
+            scene_fitness_ += s_pt.back().fit_; // uses the maximum value for scene explanation
+        if( s_pt.size() > 1 )
+            duplicity_ += s_pt[ s_pt.size() - 2 ].fit_; // uses the second best explanation
+
+        if( param_.check_smooth_clusters_ && was_explained != !s_pt.empty() )
         {
-            scene_fit += s_pt.back().fit_; // uses the maximum value for scene explanation
-            scene_pt_is_explained(s_id) = true;
+            size_t &num_explained = num_explained_pts_per_smooth_label_[ scene_pt_smooth_label_id_( it.row() ) ];
+            if( was_explained )
+                num_explained--;
+            else
+                num_explained++;
         }
+    }
+
+    evaluated_solution_[i] = activate;
+}
+
+template<typename ModelT, typename SceneT>
+bool
+HypothesisVerification<ModelT, SceneT>::violatesSmoothRegionCheck(const std::vector<size_t> &num_explained_pts_per_smooth_label) const
+{
+    int max_label = num_explained_pts_per_smooth_label.size() - 1;
+    for(int i=1; i<max_label; i++) // label "0" is for points not belonging to any smooth region
+    {
+        size_t num_explained_pts_in_region = num_explained_pts_per_smooth_label[i];
+        size_t num_pts_in_smooth_regions = num_pts_per_smooth_label_[i];
 
-        if ( s_pt.size() > 1 ) // two or more hypotheses explain the same scene point
-            duplicity += s_pt[ s_pt.size() - 2 ].fit_; // uses the second best explanation
+        if ( num_explained_pts_in_region > param_.min_pts_smooth_cluster_to_be_epxlained_ &&
+             (float)(num_explained_pts_in_region) / num_pts_in_smooth_regions < param_.min_ratio_cluster_explained_ )
+            return true;
     }
+    return false;
+}
 
+template<typename ModelT, typename SceneT>
+mets::gol_type
+HypothesisVerification<ModelT, SceneT>::evaluateSolution (const boost::dynamic_bitset<> &solution)
+{
+    double cost = std::numeric_limits<double>::max();
+    double scene_fit = 0., duplicity = 0.;
     bool violates_smooth_region_check = false;
-    if (param_.check_smooth_clusters_)
+
+    if( param_.incremental_cost_evaluation_ )
+    {
+        if( evaluated_solution_.size() != solution.size() )
+            resetIncrementalEvaluation();
+
+        // only hypotheses that changed their status since the last evaluation need to be updated (usually one or two per move)
+        const boost::dynamic_bitset<> changed = evaluated_solution_ ^ solution;
+        for(size_t i = changed.find_first(); i != boost::dynamic_bitset<>::npos; i = changed.find_next(i) )
+            toggleHypothesis( i, solution[i] );
+
+        scene_fit = scene_fitness_;
+        duplicity = duplicity_;
+
+        if (param_.check_smooth_clusters_)
+            violates_smooth_region_check = violatesSmoothRegionCheck( num_explained_pts_per_smooth_label_ );
+    }
+    else
     {
-        int max_label = scene_pt_smooth_label_id_.maxCoeff();
-        for(int i=1; i<max_label; i++) // label "0" is for points not belonging to any smooth region
+        scene_pts_explained_solution_.clear();
+        scene_pts_explained_solution_.resize( scene_cloud_downsampled_->points.size() );
+
+        for(size_t i=0; i<global_hypotheses_.size(); i++)
         {
-            Eigen::Array<bool, Eigen::Dynamic, 1> s_pt_in_region = (scene_pt_smooth_label_id_.array() == i );
-            Eigen::Array<bool, Eigen::Dynamic, 1> explained_pt_in_region = (s_pt_in_region.array() && scene_pt_is_explained.array());
-            size_t num_explained_pts_in_region = explained_pt_in_region.count();
-            size_t num_pts_in_smooth_regions = s_pt_in_region.count();
+            const typename HVRecognitionModel<ModelT>::Ptr rm = global_hypotheses_[i];
+
+            if( !solution[i])
+                continue;
+
+            for (Eigen::SparseVector<float>::InnerIterator it(rm->scene_explained_weight_); it; ++it)
+                scene_pts_explained_solution_[ it.row() ].push_back( PtFitness(it.value(), i) );
+        }
 
-            if ( num_explained_pts_in_region > param_.min_pts_smooth_cluster_to_be_epxlained_ &&
-                 (float)(num_explained_pts_in_region) / num_pts_in_smooth_regions < param_.min_ratio_cluster_explained_ )
+        for(auto spt_it = scene_pts_explained_solution_.begin(); spt_it!=scene_pts_explained_solution_.end(); ++spt_it)
+            std::sort(spt_it->begin(), spt_it->end());
+
+        std::vector<size_t> num_explained_pts_per_smooth_label ( num_pts_per_smooth_label_.size(), 0 );
+
+        for(size_t s_id=0; s_id < scene_cloud_downsampled_->points.size(); s_id++)
+        {
+            const std::vector<PtFitness> &s_pt = scene_pts_explained_solution_[s_id];
+            if(  !s_pt.empty() )
             {
-                violates_smooth_region_check = true;
-                break;
+                scene_fit += s_pt.back().fit_; // uses the maximum value for scene explanation
+
+                if (param_.check_smooth_clusters_)
+                    num_explained_pts_per_smooth_label[ scene_pt_smooth_label_id_(s_id) ]++;
             }
+
+            if ( s_pt.size() > 1 ) // two or more hypotheses explain the same scene point
+                duplicity += s_pt[ s_pt.size() - 2 ].fit_; // uses the second best explanation
         }
+
+        if (param_.check_smooth_clusters_)
+            violates_smooth_region_check = violatesSmoothRegionCheck( num_explained_pts_per_smooth_label );
     }
 
     if( !violates_smooth_region_check )
@@ -528,33 +619,35 @@ HypothesisVerification<ModelT, SceneT>::computePairwiseIntersection()
 {
     intersection_cost_ = Eigen::MatrixXf::Zero(global_hypotheses_.size(), global_hypotheses_.size());
 
+#pragma omp parallel for schedule(dynamic)
     for(size_t i=1; i<global_hypotheses_.size(); i++)
     {
-        HVRecognitionModel<ModelT> &rm_a = *global_hypotheses_[i];
+        const HVRecognitionModel<ModelT> &rm_a = *global_hypotheses_[i];
         for(size_t j=0; j<i; j++)
         {
             const HVRecognitionModel<ModelT> &rm_b = *global_hypotheses_[j];
 
             size_t num_intersections = 0, total_rendered_points = 0;
 
-            for(size_t view=0; view<rm_a.image_mask_.size(); view++)
+            for(size_t view=0; view<rm_a.silhouettes_.size(); view++)
             {
-                for(size_t px=0; px<rm_a.image_mask_[view].size(); px++)
-                {
-                    if( rm_a.image_mask_[view][px] && rm_b.image_mask_[view][px])
-                        num_intersections++;
-
-                    if ( rm_a.image_mask_[view][px] || rm_b.image_mask_[view][px] )
-                        total_rendered_points++;
-                }
+                const size_t num_intersections_view = rm_a.silhouettes_[view].intersection( rm_b.silhouettes_[view] );
+                num_intersections += num_intersections_view;
+                total_rendered_points += rm_a.silhouettes_[view].size() + rm_b.silhouettes_[view].size() - num_intersections_view;
             }
 
             float conflict_cost = static_cast<float> (num_intersections) / total_rendered_points;
             intersection_cost_(i,j) = intersection_cost_(j,i) = conflict_cost;
         }
+    }
 
-        if(!vis_pairwise_)
-            rm_a.image_mask_.clear();
+    if(!vis_pairwise_)
+    {
+        for(size_t i=0; i<global_hypotheses_.size(); i++)
+        {
+            global_hypotheses_[i]->image_mask_.clear();
+            global_hypotheses_[i]->silhouettes_.clear();
+        }
     }
 }
 
@@ -661,14 +754,14 @@ HypothesisVerification<ModelT, SceneT>::initialize()
     for(size_t i=0; i<obj_hypotheses_groups_.size(); i++)
         num_hypotheses += obj_hypotheses_groups_[i].size();
 
-    elapsed_time_.push_back( std::pair<std::string, float>( "number of hypotheses",  num_hypotheses)) ;
+    trace_->addCounter( "number of hypotheses", num_hypotheses );
 
     {
-        StopWatch t("Downsampling scene cloud");
+        TraceSpan t(trace_, "Downsampling scene cloud");
         downsampleSceneCloud();
     }
 
-    elapsed_time_.push_back( std::pair<std::string, float>( "number of downsampled scene points (HV)",  scene_cloud_downsampled_->points.size()));
+    trace_->addCounter( "number of downsampled scene points (HV)", scene_cloud_downsampled_->points.size() );
 
     if( img_boundary_distance_.empty() )
     {
@@ -691,22 +784,21 @@ HypothesisVerification<ModelT, SceneT>::initialize()
     {
 #pragma omp section
         {
-            StopWatch t("Computing octree");
-            octree_scene_downsampled_.reset(new pcl::octree::OctreePointCloudSearch<SceneT>( param_.resolution_mm_ / 1000.0));
-            octree_scene_downsampled_->setInputCloud(scene_cloud_downsampled_);
-            octree_scene_downsampled_->addPointsFromInputCloud();
+            TraceSpan t(trace_, "Computing fixed-radius search grid");
+            scene_grid_downsampled_.reset( new RadiusSearchGrid( search_radius_ ) );
+            scene_grid_downsampled_->setInputCloud( *scene_cloud_downsampled_ );
         }
 
 #pragma omp section
         {
-            StopWatch t("Computing kd-tree");
+            TraceSpan t(trace_, "Computing kd-tree");
             kdtree_scene_.reset( new pcl::search::KdTree<SceneT>);
             kdtree_scene_->setInputCloud (scene_cloud_downsampled_);
         }
 
 #pragma omp section
         {
-            StopWatch t("Computing octrees for model visibility computation");
+            TraceSpan t(trace_, "Computing octrees for model visibility computation");
             for(size_t i=0; i<obj_hypotheses_groups_.size(); i++)
             {
                 for(size_t jj=0; jj<obj_hypotheses_groups_[i].size(); jj++)
@@ -736,7 +828,7 @@ HypothesisVerification<ModelT, SceneT>::initialize()
             occlusion_clouds_.push_back(scene_cloud_);
         else
         {
-            StopWatch t("Input point cloud of scene is not organized. Doing depth-buffering to get organized point cloud");
+            TraceSpan t(trace_, "Input point cloud of scene is not organized. Doing depth-buffering to get organized point cloud");
             ZBuffering<SceneT> zbuf (cam_);
             typename pcl::PointCloud<SceneT>::Ptr organized_cloud (new pcl::PointCloud<SceneT>);
             zbuf.renderPointCloud( *scene_cloud_, *organized_cloud );
@@ -746,20 +838,29 @@ HypothesisVerification<ModelT, SceneT>::initialize()
         absolute_camera_poses_.push_back( Eigen::Matrix4f::Identity() );
     }
 
+    ZBufferingParameter zbuf_param; // for rendering the hypotheses (self-occlusion)
+    zbuf_param.do_noise_filtering_ = false;
+    zbuf_param.do_smoothing_ = false;
+    zbuf_param.inlier_threshold_ = 0.015f;
+    zbuf_param.use_normals_ = true;
 
 #pragma omp parallel sections
     {
 #pragma omp section
         {
             {
-                StopWatch t("Computing visible model points (1st run)");
-#pragma omp parallel for schedule(dynamic)
-                for(size_t i=0; i<obj_hypotheses_groups_.size(); i++)
+                TraceSpan t(trace_, "Computing visible model points (1st run)");
+#pragma omp parallel
                 {
-                    for(size_t jj=0; jj<obj_hypotheses_groups_[i].size(); jj++)
+                    ZBuffering<ModelT> zbuf (cam_, zbuf_param); // one z-buffer per thread, reused for all hypotheses rendered by it
+#pragma omp for schedule(dynamic)
+                    for(size_t i=0; i<obj_hypotheses_groups_.size(); i++)
                     {
-                        HVRecognitionModel<ModelT> &rm = *obj_hypotheses_groups_[i][jj];
-                        computeModelOcclusionByScene(rm);  //occlusion reasoning based on self-occlusion and occlusion from scene cloud(s)
+                        for(size_t jj=0; jj<obj_hypotheses_groups_[i].size(); jj++)
+                        {
+                            HVRecognitionModel<ModelT> &rm = *obj_hypotheses_groups_[i][jj];
+                            computeModelOcclusionByScene(rm, zbuf);  //occlusion reasoning based on self-occlusion and occlusion from scene cloud(s)
+                        }
                     }
                 }
             }
@@ -768,7 +869,7 @@ HypothesisVerification<ModelT, SceneT>::initialize()
             {
                 {
                     std::stringstream desc; desc << "Pose refinement with " << param_.icp_iterations_ << " ICP iterations";
-                    StopWatch t(desc.str());
+                    TraceSpan t(trace_, desc.str());
 #pragma omp parallel for schedule(dynamic)
                     for(size_t i=0; i<obj_hypotheses_groups_.size(); i++)
                     {
@@ -781,14 +882,18 @@ HypothesisVerification<ModelT, SceneT>::initialize()
                 }
 
                 {
-                    StopWatch t("Computing visible model points (2nd run)");
-#pragma omp parallel for schedule(dynamic)
-                    for(size_t i=0; i<obj_hypotheses_groups_.size(); i++)
+                    TraceSpan t(trace_, "Computing visible model points (2nd run)");
+#pragma omp parallel
                     {
-                        for(size_t jj=0; jj<obj_hypotheses_groups_[i].size(); jj++)
+                        ZBuffering<ModelT> zbuf (cam_, zbuf_param); // one z-buffer per thread, reused for all hypotheses rendered by it
+#pragma omp for schedule(dynamic)
+                        for(size_t i=0; i<obj_hypotheses_groups_.size(); i++)
                         {
-                            HVRecognitionModel<ModelT> &rm = *obj_hypotheses_groups_[i][jj];
-                            computeModelOcclusionByScene(rm);  //occlusion reasoning based on self-occlusion and occlusion from scene cloud(s)
+                            for(size_t jj=0; jj<obj_hypotheses_groups_[i].size(); jj++)
+                            {
+                                HVRecognitionModel<ModelT> &rm = *obj_hypotheses_groups_[i][jj];
+                                computeModelOcclusionByScene(rm, zbuf);  //occlusion reasoning based on self-occlusion and occlusion from scene cloud(s)
+                            }
                         }
                     }
 
@@ -801,7 +906,7 @@ HypothesisVerification<ModelT, SceneT>::initialize()
                             num_visible_object_points+=rm.visible_cloud_->points.size();
                         }
                     }
-                    elapsed_time_.push_back( std::pair<std::string, float>( "visible object points",  num_visible_object_points));
+                    trace_->addCounter( "visible object points", num_visible_object_points );
                 }
             }
 //            {
@@ -818,7 +923,7 @@ HypothesisVerification<ModelT, SceneT>::initialize()
 //            }
 
             { //used for checking pairwise intersection of objects (relate amount of overlapping pixel of their 2D silhouette)
-                StopWatch t("Computing 2D silhouette of visible object model");
+                TraceSpan t(trace_, "Computing 2D silhouette of visible object model");
 #pragma omp parallel for schedule(dynamic)
                 for(size_t i=0; i<obj_hypotheses_groups_.size(); i++)
                 {
@@ -831,7 +936,7 @@ HypothesisVerification<ModelT, SceneT>::initialize()
             }
 
             {
-                StopWatch t("Computing visible octree nodes");
+                TraceSpan t(trace_, "Computing visible octree nodes");
 #pragma omp parallel for schedule(dynamic)
                 for(size_t i=0; i<obj_hypotheses_groups_.size(); i++)
                 {
@@ -850,7 +955,7 @@ HypothesisVerification<ModelT, SceneT>::initialize()
         {
             if(param_.check_smooth_clusters_)
             {
-                StopWatch t("Extracting smooth clusters");
+                TraceSpan t(trace_, "Extracting smooth clusters");
                 extractEuclideanClustersSmooth();
             }
         }
@@ -858,7 +963,7 @@ HypothesisVerification<ModelT, SceneT>::initialize()
 #pragma omp section
         if(!param_.ignore_color_even_if_exists_)
         {
-            StopWatch t("Converting scene color values");
+            TraceSpan t(trace_, "Converting scene color values");
             colorTransf_->convert(*scene_cloud_downsampled_, scene_color_channels_);
 //            scene_color_channels_.col(0) = (scene_color_channels_.col(0) - Eigen::VectorXf::Ones(scene_color_channels_.rows())*50.f) / 50.f;
 //            scene_color_channels_.col(1) = scene_color_channels_.col(1) / 150.f;
@@ -868,7 +973,7 @@ HypothesisVerification<ModelT, SceneT>::initialize()
 
 
     {
-        StopWatch t("Converting model color values");
+        TraceSpan t(trace_, "Converting model color values");
         for(size_t i=0; i<obj_hypotheses_groups_.size(); i++)
         {
             for(size_t jj=0; jj<obj_hypotheses_groups_[i].size(); jj++)
@@ -893,7 +998,7 @@ HypothesisVerification<ModelT, SceneT>::initialize()
     }
 
     {
-        StopWatch t("Computing model to scene fitness");
+        TraceSpan t(trace_, "Computing model to scene fitness");
 #pragma omp parallel for schedule(dynamic)
         for(size_t i=0; i<obj_hypotheses_groups_.size(); i++)
         {
@@ -964,14 +1069,14 @@ HypothesisVerification<ModelT, SceneT>::initialize()
 
     global_hypotheses_.resize( kept_hypotheses );
 
-    elapsed_time_.push_back( std::pair<std::string, float>( "hypotheses left for global optimization",  kept_hypotheses));
+    trace_->addCounter( "hypotheses left for global optimization", kept_hypotheses );
 
 
     if( !kept_hypotheses )
         return;
 
     {
-        StopWatch t("Computing pairwise intersection");
+        TraceSpan t(trace_, "Computing pairwise intersection");
         computePairwiseIntersection();
     }
 
@@ -991,6 +1096,7 @@ HypothesisVerification<ModelT, SceneT>::optimize ()
     }
 
     solution_ = boost::dynamic_bitset<>(global_hypotheses_.size(), 0);
+    resetIncrementalEvaluation();
 
     if(param_.initial_status_)
         solution_.set();
@@ -1016,7 +1122,7 @@ HypothesisVerification<ModelT, SceneT>::optimize ()
     {
     case HV_OptimizationType::LocalSearch:
     {
-        StopWatch t ("local search");
+        TraceSpan t(trace_, "local search");
         neigh.UseReplaceMoves(false);
         mets::local_search<GHVmove_manager<ModelT, SceneT> > local ( model, *(cost_logger_.get()), neigh, 0, false);
         local.search ();
@@ -1025,7 +1131,7 @@ HypothesisVerification<ModelT, SceneT>::optimize ()
     }
     case HV_OptimizationType::TabuSearch:
     {
-        StopWatch t ("TABU search");
+        TraceSpan t(trace_, "TABU search");
         mets::simple_tabu_list tabu_list ( 5 * global_hypotheses_.size()) ;  // ( initial_solution.size() * sqrt ( 1.0*initial_solution.size() ) ) ;
         mets::best_ever_criteria aspiration_criteria ;
 
@@ -1039,7 +1145,7 @@ HypothesisVerification<ModelT, SceneT>::optimize ()
     }
     case HV_OptimizationType::TabuSearchWithLSRM:
     {
-        StopWatch t("TABU search + LS (RM)");
+        TraceSpan t(trace_, "TABU search + LS (RM)");
         GHVmove_manager<ModelT, SceneT> neigh4 ( false);
         neigh4.setIntersectionCost(intersection_cost_);
 
@@ -1062,7 +1168,7 @@ HypothesisVerification<ModelT, SceneT>::optimize ()
     }
     case HV_OptimizationType::SimulatedAnnealing:
     {
-        StopWatch t ("SA search");
+        TraceSpan t(trace_, "SA search");
         //Simulated Annealing
         //mets::linear_cooling linear_cooling;
         mets::exponential_cooling linear_cooling;
@@ -1100,10 +1206,11 @@ template<typename ModelT, typename SceneT>
 void
 HypothesisVerification<ModelT, SceneT>::verify()
 {
-    elapsed_time_.clear();
+    if( !external_trace_ )
+        trace_.reset( new TraceContext );
 
     {
-        StopWatch t("Verification of object hypotheses");
+        TraceSpan t(trace_, "Initialization of object hypotheses verification");
         initialize();
     }
 
@@ -1111,7 +1218,7 @@ HypothesisVerification<ModelT, SceneT>::verify()
         visualize_cues_during_logger_ = boost::bind(&HypothesisVerification<ModelT, SceneT>::visualizeGOcues, this, _1, _2, _3);
 
     {
-        StopWatch t("Optimizing object hypotheses verification cost function");
+        TraceSpan t(trace_, "Optimizing object hypotheses verification cost function");
         optimize ();
     }
 
@@ -1150,86 +1257,120 @@ HypothesisVerification<ModelT, SceneT>::removeNanNormals (HVRecognitionModel<Mod
     return !rm.visible_cloud_->points.empty();
 }
 
+namespace
+{
+struct CIE76Distance
+{
+    float operator()(const Eigen::Vector3f &a, const Eigen::Vector3f &b) const { return CIE76(a, b); }
+};
+
+struct CIE94Distance
+{
+    float operator()(const Eigen::Vector3f &a, const Eigen::Vector3f &b) const { return CIE94_DEFAULT(a, b); }
+};
+
+struct CIEDE2000Distance
+{
+    float operator()(const Eigen::Vector3f &a, const Eigen::Vector3f &b) const { return CIEDE2000(a, b); }
+};
+
+struct CustomColorDistance
+{
+    float sigma_color_;
+    explicit CustomColorDistance(float sigma_color) : sigma_color_ (sigma_color) { }
+
+    float operator()(const Eigen::Vector3f &color_a, const Eigen::Vector3f &color_b) const
+    {
+        float L_dist  = ( color_a(0) - color_b(0) )*( color_a(0) - color_b(0) );
+        CHECK(L_dist >= 0.f && L_dist <= 1.f);
+        L_dist /= sigma_color_ ;
+        float AB_dist = ( color_a.tail(2) - color_b.tail(2) ).norm(); // ( param_.color_sigma_ab_ * param_.color_sigma_ab_ );
+        CHECK(AB_dist >= 0.f && AB_dist <= 1.f);
+        return L_dist + AB_dist ;
+    }
+};
+
+/// used if color is ignored
+struct NoColorDistance
+{
+    float operator()(const Eigen::Vector3f &, const Eigen::Vector3f &) const { return 0.f; }
+};
+}
+
 template<typename ModelT, typename SceneT>
 void
 HypothesisVerification<ModelT, SceneT>::computeModelFitness(HVRecognitionModel<ModelT> &rm) const
 {
-//    rm.model_scene_c_.reserve( rm.visible_cloud_->points.size () * param_.knn_inliers_ );
-//    size_t kept=0;
+    if( param_.ignore_color_even_if_exists_ || rm.pt_color_.cols() != 3 || scene_color_channels_.cols() != 3 )
+    {
+        computeModelFitness( rm, NoColorDistance() );
+        return;
+    }
 
-//    pcl::visualization::PCLVisualizer vis;
-//    int vp1, vp2;
-//    vis.createViewPort(0,0,0.5,1,vp1);
-//    vis.createViewPort(0.5,0,1,1,vp2);
-//    vis.addPointCloud(rm.visible_cloud_, "vis_cloud", vp1);
-//    pcl::visualization::PointCloudColorHandlerCustom<SceneT> gray (scene_cloud_downsampled_, 128, 128, 128);
-//    vis.addPointCloud(scene_cloud_downsampled_, gray, "scene1", vp1);
-//    vis.setPointCloudRenderingProperties( pcl::visualization::PCL_VISUALIZER_OPACITY, 0.2, "scene1");
+    switch (param_.color_comparison_method_)
+    {
+    case ColorComparisonMethod::cie76 :
+        computeModelFitness( rm, CIE76Distance() ); break;
 
+    case ColorComparisonMethod::cie94 :
+        computeModelFitness( rm, CIE94Distance() ); break;
 
-//    rm.visible_pt_is_outlier_.resize( rm.visible_cloud_->points.size (), 0);
-    for (size_t midx = 0; midx < rm.visible_cloud_->points.size (); midx++)
-    {
-        std::vector<int> nn_indices;
-        std::vector<float> nn_sqrd_distances;
+    case ColorComparisonMethod::ciede2000 :
+        computeModelFitness( rm, CIEDE2000Distance() ); break;
+
+    default:
+        computeModelFitness( rm, CustomColorDistance( param_.sigma_color_ ) ); break;
+    }
+}
+
+template<typename ModelT, typename SceneT>
+template<typename ColorDistance>
+void
+HypothesisVerification<ModelT, SceneT>::computeModelFitness(HVRecognitionModel<ModelT> &rm, const ColorDistance &color_dist) const
+{
+    const bool use_color = rm.pt_color_.cols() == 3 && scene_color_channels_.cols() == 3;
+    Eigen::Vector3f color_m = Eigen::Vector3f::Zero(), color_s = Eigen::Vector3f::Zero();
+
+    // memory reused for all model points
+    std::vector<int> nn_indices;
+    std::vector<float> nn_sqrd_distances;
 
-//        bool is_outlier = true;
-        double radius = search_radius_;
-        octree_scene_downsampled_->radiusSearch(rm.visible_cloud_->points[midx], radius, nn_indices, nn_sqrd_distances);
+    rm.model_scene_c_.clear();
+    rm.model_scene_c_.reserve( rm.visible_cloud_->points.size() * 2 );
 
-//        vis.addSphere(rm.visible_cloud_->points[midx], 0.005, 0., 1., 0., "queryPoint", vp1 );
+    for (size_t midx = 0; midx < rm.visible_cloud_->points.size (); midx++)
+    {
+        scene_grid_downsampled_->radiusSearch( rm.visible_cloud_->points[midx].getVector3fMap(), nn_indices, nn_sqrd_distances);
 
         const auto normal_m = rm.visible_cloud_normals_->points[midx].getNormalVector3fMap();
-//        normal_m.normalize();
+
+        if( use_color )
+            color_m = rm.pt_color_.row( midx ).transpose();
 
         for (size_t k = 0; k < nn_indices.size(); k++)
         {
             int sidx = nn_indices[ k ];
-            float sqrd_3D_dist = nn_sqrd_distances[k];
-
-//            std::stringstream pt_id; pt_id << "searched_pt_" << k;
-//            vis.addSphere(scene_cloud_downsampled_->points[sidx], 0.005, 1., 0., 0., pt_id.str(), vp2 );
-//            vis.addPointCloud(rm.visible_cloud_, "vis_cloud2", vp2);
-//            vis.addPointCloud(scene_cloud_downsampled_, gray, "scene2", vp2);
-//            vis.setPointCloudRenderingProperties( pcl::visualization::PCL_VISUALIZER_OPACITY, 0.2, "scene2");
-
-//            if (sqr_3D_dist > ( 1.5f * 1.5f * param_.inliers_threshold_ * param_.inliers_threshold_ ) ) ///TODO: consider camera's noise level
-//                continue;
 
             ModelSceneCorrespondence c;
             c.model_id_ = midx;
             c.scene_id_ = sidx;
-            c.dist_3D_ = sqrt(sqrd_3D_dist);
+            c.dist_3D_ = sqrt( nn_sqrd_distances[k] );
 
             const auto normal_s = scene_normals_downsampled_->points[sidx].getNormalVector3fMap();
-//            normal_s.normalize();
-
-            float dotp = std::min( 0.99999f, std::max(-0.99999f, normal_m.dot(normal_s) ) );
-            c.normals_dotp_ = dotp;
+            c.normals_dotp_ = std::min( 0.99999f, std::max(-0.99999f, normal_m.dot(normal_s) ) );
 
-//            CHECK (c.angle_surface_normals_rad_ <= M_PI) << "invalid normals: " << std::endl << normal_m << std::endl << std::endl << normal_s << std::endl << std::endl << "dotp: " << dotp << std::endl << "acos: " << c.angle_surface_normals_rad_ << std::endl;
-//            CHECK (c.angle_surface_normals_rad_ >= 0.f ) << "invalid normals: " << std::endl << normal_m << std::endl << std::endl << normal_s << std::endl << std::endl << "dotp: " << dotp << std::endl << "acos: " << c.angle_surface_normals_rad_ << std::endl;
-
-            const Eigen::VectorXf &color_m = rm.pt_color_.row( midx );
-            const Eigen::VectorXf &color_s = scene_color_channels_.row( sidx );
-            c.color_distance_ = color_dist_f_(color_s, color_m);
+            if( use_color )
+                color_s = scene_color_channels_.row( sidx ).transpose();
+            c.color_distance_ = color_dist(color_s, color_m);
 
             c.fitness_ = getFitness( c );
             rm.model_scene_c_.push_back( c );
-
-//            if(c.fitness_ > param_.min_fitness_)
-//                is_outlier=false;
         }
-//        vis.removeAllShapes(vp1);
-//        rm.visible_pt_is_outlier_[ midx ] = is_outlier;
     }
 
-//    vis.spin();
-//    rm.model_scene_c_.resize(kept);
-
     std::sort( rm.model_scene_c_.begin(), rm.model_scene_c_.end() );
 
-    if(param_.use_histogram_specification_)
+    if(param_.use_histogram_specification_ && use_color)
     {
         boost::dynamic_bitset<> scene_pt_is_taken(scene_cloud_downsampled_->points.size(), 0);
         Eigen::VectorXf scene_color_for_model ( scene_cloud_downsampled_->points.size() );
@@ -1261,9 +1402,9 @@ HypothesisVerification<ModelT, SceneT>::computeModelFitness(HVRecognitionModel<M
                 int sidx = c.scene_id_;
                 int midx = c.model_id_;
 
-                const Eigen::VectorXf &color_m = rm.pt_color_.row( midx );
-                const Eigen::VectorXf &color_s = scene_color_channels_.row( sidx );
-                c.color_distance_ = color_dist_f_(color_s, color_m);
+                color_m = rm.pt_color_.row( midx ).transpose();
+                color_s = scene_color_channels_.row( sidx ).transpose();
+                c.color_distance_ = color_dist(color_s, color_m);
                 c.fitness_ = getFitness( c );
             }
         }
@@ -1299,9 +1440,6 @@ HypothesisVerification<ModelT, SceneT>::computeModelFitness(HVRecognitionModel<M
     VLOG(1) << "model fit of " << rm.oh_->model_id_ << ": " << rm.model_fit_ << " (normalized: " << rm.model_fit_/rm.visible_cloud_->points.size() << ").";
 }
 
-template<typename ModelT, typename SceneT>
-std::vector<std::pair<std::string,float> > HypothesisVerification<ModelT, SceneT>::elapsed_time_;
-
 #define PCL_INSTANTIATE_HypothesisVerification(ModelT, SceneT) template class V4R_EXPORTS HypothesisVerification<ModelT, SceneT>;
 PCL_INSTANTIATE_PRODUCT(HypothesisVerification, ((pcl::PointXYZRGB))((pcl::PointXYZRGB)) )
 
@@ -17,12 +17,85 @@
 
 #include <opencv2/opencv.hpp>
 
+#include <fstream>
 #include <sstream>
 #include <omp.h>
+#include <sys/stat.h>
 
 namespace v4r
 {
 
+namespace
+{
+const char FLANN_CACHE_MAGIC[8] = {'V','4','R','F','L','A','N','N'};
+const uint32_t FLANN_CACHE_VERSION = 3;
+const size_t FLANN_CACHE_ALIGNMENT = 64;   ///< byte alignment of the signature matrix inside the cache file
+
+/**
+ * @brief The FLANNCacheHeader struct is written at the beginning of the FLANN cache file. It is followed by the model ids
+ * (length + characters), one (model index, keypoint id) pair per signature, the offset and scale of each dimension
+ * (only for quantized signatures) and the signature matrix at data_offset_.
+ */
+struct FLANNCacheHeader
+{
+    char magic_[8];
+    uint32_t version_;
+    int32_t distance_metric_;
+    int32_t kdtree_num_trees_;
+    int32_t quantized_; ///< 1 if the signatures are stored with 8 bit per dimension, 0 if stored as float
+    uint32_t num_models_;
+    uint64_t fingerprint_;  ///< hash of the trained model set the cache was created for
+    uint64_t rows_; ///< number of signatures
+    uint64_t cols_; ///< dimensionality of signatures
+    uint64_t data_offset_;  ///< byte offset of the signature matrix
+};
+
+/**
+ * @brief hashCombine updates an FNV-1a hash with the given bytes
+ */
+void
+hashCombine(uint64_t &hash, const void *data, size_t bytes)
+{
+    const unsigned char *p = static_cast<const unsigned char*>(data);
+    for(size_t i=0; i<bytes; i++)
+    {
+        hash ^= p[i];
+        hash *= 1099511628211ULL;
+    }
+}
+
+/**
+ * @brief hashFileStatus updates an FNV-1a hash with path, size and modification time (nanosecond resolution) of the given file
+ */
+void
+hashFileStatus(uint64_t &hash, const bf::path &path)
+{
+    struct stat st;
+    CHECK( stat( path.string().c_str(), &st ) == 0 ) << "Could not stat " << path.string();
+
+    const std::string path_str = path.string();
+    const int64_t status[3] = { static_cast<int64_t>(st.st_size), static_cast<int64_t>(st.st_mtim.tv_sec), static_cast<int64_t>(st.st_mtim.tv_nsec) };
+    hashCombine( hash, path_str.data(), path_str.size() + 1 );
+    hashCombine( hash, status, sizeof(status) );
+}
+
+template<typename Distance>
+void
+saveFLANNIndex(const boost::shared_ptr<flann::Index<Distance> > &index, const bf::path &index_path)
+{
+    CHECK( index );
+    index->save( index_path.string() );
+}
+
+template<typename Distance>
+void
+loadFLANNIndex(boost::shared_ptr<flann::Index<Distance> > &index, const flann::Matrix<typename Distance::ElementType> &data,
+               const bf::path &index_path, const Distance &distance = Distance())
+{
+    index.reset( new ::flann::Index<Distance> (data, ::flann::SavedIndexParams( index_path.string() ), distance ) );
+}
+}
+
 template<typename PointT>
 void
 LocalFeatureMatcher<PointT>::visualizeKeypoints(const std::vector<KeypointIndex> &kp_indices,
@@ -250,12 +323,15 @@ LocalFeatureMatcher<PointT>::initialize (const std::string &trained_dir, bool re
     validate();
     lomdbs_.resize( estimators_.size() );
 
+    if( param_.quantize_descriptors_ && !useQuantizedDescriptors() )
+        LOG(WARNING) << "Quantized descriptors are only supported for the L1 and L2 norm. Using float descriptors.";
+
     std::vector<typename Model<PointT>::ConstPtr> models = m_db_->getModels ();
 
     for (size_t est_id=0; est_id < estimators_.size(); est_id++)
     {
         LocalObjectModelDatabase::Ptr lomdb( new LocalObjectModelDatabase );
-        std::vector<FeatureDescriptor> all_signatures; ///< all signatures extracted from all objects in the model database
+        std::vector<std::pair<std::string, bf::path> > model_signature_files; ///< signature file for each trained object model (model id, path)
 
         typename LocalEstimator<PointT>::Ptr &est = estimators_[est_id];
 
@@ -278,12 +354,9 @@ LocalFeatureMatcher<PointT>::initialize (const std::string &trained_dir, bool re
 
             if( !retrain && io::existsFile( kp_path) && io::existsFile( kp_normals_path ) && io::existsFile( signatures_path ) )
             {
+                // signatures are only read from disk if the FLANN cache can not be used (see below)
                 pcl::io::loadPCDFile( kp_path.string(), *model_keypoints );
                 pcl::io::loadPCDFile( kp_normals_path.string(), *model_kp_normals );
-                ifstream is(signatures_path.string(), ios::binary);
-                boost::archive::binary_iarchive iar(is);
-                iar >> model_signatures;
-                is.close();
             }
             else
             {
@@ -309,8 +382,7 @@ LocalFeatureMatcher<PointT>::initialize (const std::string &trained_dir, bool re
                         }
                         else
                         {
-                            typename pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT>);
-                            pcl::io::loadPCDFile(tv->filename_, *cloud);
+                            typename pcl::PointCloud<PointT>::Ptr cloud (new pcl::PointCloud<PointT> ( *tv->getCloud() ) );   // copy as points outside the object mask get removed
 
                             try
                             {
@@ -475,15 +547,7 @@ LocalFeatureMatcher<PointT>::initialize (const std::string &trained_dir, bool re
 
     //        assert(lom->keypoints_->points.size() == model_signatures.size());
 
-            all_signatures.insert( all_signatures.end(), model_signatures.begin(), model_signatures.end() );
-
-            std::vector<LocalObjectModelDatabase::flann_model> flann_models_tmp ( model_signatures.size() );
-            for (size_t f=0; f<model_signatures.size(); f++)
-            {
-                flann_models_tmp[f].model_id_ = m->id_;
-                flann_models_tmp[f].keypoint_id_ = f;
-            }
-            lomdb->flann_models_.insert ( lomdb->flann_models_.end(), flann_models_tmp.begin(), flann_models_tmp.end() );
+            model_signature_files.push_back( std::make_pair(m->id_, signatures_path) );
 
             LocalObjectModel::Ptr lom (new LocalObjectModel );
             lom->keypoints_ = model_keypoints;
@@ -491,45 +555,340 @@ LocalFeatureMatcher<PointT>::initialize (const std::string &trained_dir, bool re
             lomdb->l_obj_models_[m->id_] = lom;
         }
 
-        CHECK( lomdb->flann_models_.size() == all_signatures.size() );
+        // the FLANN cache is only valid for the very same signatures (index parameters are checked from the cache header).
+        // Signature files are identified by path, size and modification time, so a warm start does not need to read them.
+        const std::string descr_id = est->getFeatureDescriptorName() + est->getUniqueId();
+        uint64_t fingerprint = 14695981039346656037ULL;
+        hashCombine( fingerprint, descr_id.data(), descr_id.size() );
+        for(const auto &msf : model_signature_files)
+        {
+            hashCombine( fingerprint, msf.first.data(), msf.first.size() + 1 );
+            hashFileStatus( fingerprint, msf.second );
+        }
+
+        bf::path cache_path = trained_dir;
+        cache_path /= descr_id + "_flann_cache.dat";
+        bf::path index_path = trained_dir;
+        index_path /= descr_id + "_flann_index.dat";
+
+        if( !param_.use_flann_cache_ || retrain || !loadFLANNCache( cache_path, index_path, fingerprint, *lomdb ) )
+        {
+            std::vector<float> all_signatures; ///< all signatures extracted from all objects in the model database (row-major)
+            size_t size_feat = 0;
+
+            for(const auto &msf : model_signature_files)
+            {
+                std::vector<FeatureDescriptor> model_signatures;
+                ifstream is(msf.second.string(), ios::binary);
+                boost::archive::binary_iarchive iar(is);
+                iar >> model_signatures;
+                is.close();
 
-        lomdb->flann_data_.reset ( new flann::Matrix<float> (
-                                new float[ all_signatures.size() * all_signatures[0].size()],
-                all_signatures.size(), all_signatures[0].size()));
+                for (size_t f=0; f<model_signatures.size(); f++)
+                {
+                    if( !size_feat )
+                        size_feat = model_signatures[f].size();
 
-        for (size_t i = 0; i < lomdb->flann_data_->rows; i++)
-            for (size_t j = 0; j < lomdb->flann_data_->cols; j++)
-                lomdb->flann_data_->ptr()[i * lomdb->flann_data_->cols + j] = all_signatures[i][j];
+                    CHECK( model_signatures[f].size() == size_feat );
+                    all_signatures.insert( all_signatures.end(), model_signatures[f].begin(), model_signatures[f].end() );
 
-        LOG(INFO) << "Building the kdtree index for " << lomdb->flann_data_->rows << " elements.";
+                    LocalObjectModelDatabase::flann_model fm;
+                    fm.model_id_ = msf.first;
+                    fm.keypoint_id_ = f;
+                    lomdb->flann_models_.push_back( fm );
+                }
+            }
+
+            CHECK( !lomdb->flann_models_.empty() ) << "No " << descr_id << " signatures found in the model database!";
+            CHECK( lomdb->flann_models_.size() * size_feat == all_signatures.size() );
+
+            if( useQuantizedDescriptors() )
+            {
+                lomdb->quantizer_.compute( all_signatures.data(), lomdb->flann_models_.size(), size_feat );
+                lomdb->flann_data_quantized_storage_.resize( all_signatures.size() );
+                lomdb->quantizer_.quantize( all_signatures.data(), lomdb->flann_models_.size(), lomdb->flann_data_quantized_storage_.data() );
+                lomdb->flann_data_quantized_.reset ( new flann::Matrix<unsigned char> ( lomdb->flann_data_quantized_storage_.data(), lomdb->flann_models_.size(), size_feat ) );
+            }
+            else
+            {
+                lomdb->flann_data_.reset ( new flann::Matrix<float> ( new float[ all_signatures.size() ], lomdb->flann_models_.size(), size_feat ) );
+                std::copy( all_signatures.begin(), all_signatures.end(), lomdb->flann_data_->ptr() );
+            }
+
+            buildFLANNIndex( *lomdb );
+
+            if( param_.use_flann_cache_ )
+                saveFLANNCache( cache_path, index_path, fingerprint, *lomdb );
+        }
+        lomdbs_[est_id] = lomdb;
+    }
+
+    mergeKeypointsFromMultipleEstimators();
+    indices_.clear();
+}
+
+template<typename PointT>
+void
+LocalFeatureMatcher<PointT>::buildFLANNIndex(LocalObjectModelDatabase &lomdb) const
+{
+    if( lomdb.flann_data_quantized_ )
+    {
+        LOG(INFO) << "Building the kdtree index for " << lomdb.flann_data_quantized_->rows << " quantized elements.";
 
         if(param_.distance_metric_==2)
         {
-            lomdb->flann_index_l2_.reset( new ::flann::Index<::flann::L2<float> > (*(lomdb->flann_data_), ::flann::KDTreeIndexParams (param_.kdtree_num_trees_)));
-    //        lomdb_->flann_index_l2_.reset( new flann::Index<flann::L2<float> > (*(lomdb_->flann_data_), flann::LinearIndexParams()));
-            lomdb->flann_index_l2_->buildIndex();
+            lomdb.flann_index_l2_quantized_.reset( new ::flann::Index<QuantizedL2> (*(lomdb.flann_data_quantized_), ::flann::KDTreeIndexParams (param_.kdtree_num_trees_), QuantizedL2( lomdb.quantizer_ )));
+            lomdb.flann_index_l2_quantized_->buildIndex();
         }
-        else if(param_.distance_metric_==3)
+        else
         {
-            lomdb->flann_index_chisquare_.reset( new ::flann::Index<::flann::ChiSquareDistance<float> > (*(lomdb->flann_data_), ::flann::KDTreeIndexParams (param_.kdtree_num_trees_)));
-            lomdb->flann_index_chisquare_->buildIndex();
+            lomdb.flann_index_l1_quantized_.reset( new ::flann::Index<QuantizedL1> (*(lomdb.flann_data_quantized_), ::flann::KDTreeIndexParams (param_.kdtree_num_trees_), QuantizedL1( lomdb.quantizer_ )));
+            lomdb.flann_index_l1_quantized_->buildIndex();
         }
-        else if(param_.distance_metric_==4)
+        return;
+    }
+
+    LOG(INFO) << "Building the kdtree index for " << lomdb.flann_data_->rows << " elements.";
+
+    if(param_.distance_metric_==2)
+    {
+        lomdb.flann_index_l2_.reset( new ::flann::Index<::flann::L2<float> > (*(lomdb.flann_data_), ::flann::KDTreeIndexParams (param_.kdtree_num_trees_)));
+//        lomdb_->flann_index_l2_.reset( new flann::Index<flann::L2<float> > (*(lomdb_->flann_data_), flann::LinearIndexParams()));
+        lomdb.flann_index_l2_->buildIndex();
+    }
+    else if(param_.distance_metric_==3)
+    {
+        lomdb.flann_index_chisquare_.reset( new ::flann::Index<::flann::ChiSquareDistance<float> > (*(lomdb.flann_data_), ::flann::KDTreeIndexParams (param_.kdtree_num_trees_)));
+        lomdb.flann_index_chisquare_->buildIndex();
+    }
+    else if(param_.distance_metric_==4)
+    {
+        lomdb.flann_index_hellinger_.reset( new ::flann::Index<::flann::HellingerDistance<float> > (*(lomdb.flann_data_), ::flann::KDTreeIndexParams (param_.kdtree_num_trees_)));
+        lomdb.flann_index_hellinger_->buildIndex();
+    }
+    else
+    {
+        lomdb.flann_index_l1_.reset( new ::flann::Index<::flann::L1<float> > (*(lomdb.flann_data_), ::flann::KDTreeIndexParams (param_.kdtree_num_trees_)));
+//        lomdb_->flann_index_l1_.reset( new flann::Index<flann::L1<float> > (*(lomdb_->flann_data_), flann::LinearIndexParams()));
+        lomdb.flann_index_l1_->buildIndex();
+    }
+}
+
+template<typename PointT>
+void
+LocalFeatureMatcher<PointT>::saveFLANNCache(const bf::path &cache_path,
+                                            const bf::path &index_path,
+                                            uint64_t fingerprint,
+                                            const LocalObjectModelDatabase &lomdb) const
+{
+    LOG(INFO) << "Writing FLANN cache to " << cache_path.string() << ".";
+
+    // the index is written first - the cache file (written last) marks the pair as complete
+    io::createDirForFileIfNotExist( index_path );
+    if( lomdb.flann_data_quantized_ )
+    {
+        if(param_.distance_metric_==2)
+            saveFLANNIndex( lomdb.flann_index_l2_quantized_, index_path );
+        else
+            saveFLANNIndex( lomdb.flann_index_l1_quantized_, index_path );
+    }
+    else if(param_.distance_metric_==2)
+        saveFLANNIndex( lomdb.flann_index_l2_, index_path );
+    else if(param_.distance_metric_==3)
+        saveFLANNIndex( lomdb.flann_index_chisquare_, index_path );
+    else if(param_.distance_metric_==4)
+        saveFLANNIndex( lomdb.flann_index_hellinger_, index_path );
+    else
+        saveFLANNIndex( lomdb.flann_index_l1_, index_path );
+
+    std::vector<std::string> model_ids;
+    std::map<std::string, uint32_t> model_id2idx;
+    for(const auto &fm : lomdb.flann_models_)
+    {
+        if( model_id2idx.find( fm.model_id_ ) == model_id2idx.end() )
         {
-            lomdb->flann_index_hellinger_.reset( new ::flann::Index<::flann::HellingerDistance<float> > (*(lomdb->flann_data_), ::flann::KDTreeIndexParams (param_.kdtree_num_trees_)));
-            lomdb->flann_index_hellinger_->buildIndex();
+            model_id2idx[ fm.model_id_ ] = model_ids.size();
+            model_ids.push_back( fm.model_id_ );
         }
-        else
+    }
+
+    const bf::path tmp_path = cache_path.string() + ".tmp";
+    std::ofstream os( tmp_path.string(), std::ios::binary | std::ios::trunc );
+
+    FLANNCacheHeader h;
+    memcpy( h.magic_, FLANN_CACHE_MAGIC, sizeof(h.magic_) );
+    h.version_ = FLANN_CACHE_VERSION;
+    h.distance_metric_ = param_.distance_metric_;
+    h.kdtree_num_trees_ = param_.kdtree_num_trees_;
+    h.quantized_ = lomdb.flann_data_quantized_ ? 1 : 0;
+    h.num_models_ = model_ids.size();
+    h.fingerprint_ = fingerprint;
+    h.rows_ = h.quantized_ ? lomdb.flann_data_quantized_->rows : lomdb.flann_data_->rows;
+    h.cols_ = h.quantized_ ? lomdb.flann_data_quantized_->cols : lomdb.flann_data_->cols;
+    const size_t element_size = h.quantized_ ? sizeof(unsigned char) : sizeof(float);
+
+    uint64_t offset = sizeof(h);
+    for(const std::string &id : model_ids)
+        offset += sizeof(uint32_t) + id.size();
+    offset += lomdb.flann_models_.size() * 2 * sizeof(uint32_t);
+    if( h.quantized_ )
+        offset += 2 * h.cols_ * sizeof(float);
+    h.data_offset_ = (offset + FLANN_CACHE_ALIGNMENT - 1) / FLANN_CACHE_ALIGNMENT * FLANN_CACHE_ALIGNMENT;
+
+    os.write( reinterpret_cast<const char*>(&h), sizeof(h) );
+    for(const std::string &id : model_ids)
+    {
+        const uint32_t len = id.size();
+        os.write( reinterpret_cast<const char*>(&len), sizeof(len) );
+        os.write( id.data(), len );
+    }
+    for(const auto &fm : lomdb.flann_models_)
+    {
+        const uint32_t entry[2] = { model_id2idx[ fm.model_id_ ], static_cast<uint32_t>(fm.keypoint_id_) };
+        os.write( reinterpret_cast<const char*>(entry), sizeof(entry) );
+    }
+    if( h.quantized_ )
+    {
+        os.write( reinterpret_cast<const char*>( lomdb.quantizer_.getOffset().data() ), h.cols_ * sizeof(float) );
+        os.write( reinterpret_cast<const char*>( lomdb.quantizer_.getScale().data() ), h.cols_ * sizeof(float) );
+    }
+    const std::vector<char> padding( h.data_offset_ - offset, 0 );
+    os.write( padding.data(), padding.size() );
+    if( h.quantized_ )
+        os.write( reinterpret_cast<const char*>( lomdb.flann_data_quantized_->ptr() ), h.rows_ * h.cols_ * element_size );
+    else
+        os.write( reinterpret_cast<const char*>( lomdb.flann_data_->ptr() ), h.rows_ * h.cols_ * element_size );
+    os.close();
+
+    if( !os )
+    {
+        LOG(ERROR) << "Could not write FLANN cache " << tmp_path.string() << "!";
+        bf::remove( tmp_path );
+        return;
+    }
+    bf::rename( tmp_path, cache_path );
+}
+
+template<typename PointT>
+bool
+LocalFeatureMatcher<PointT>::loadFLANNCache(const bf::path &cache_path,
+                                            const bf::path &index_path,
+                                            uint64_t fingerprint,
+                                            LocalObjectModelDatabase &lomdb) const
+{
+    if( !io::existsFile( cache_path ) || !io::existsFile( index_path ) )
+        return false;
+
+    try
+    {
+        io::MappedFile::Ptr mapping ( new io::MappedFile( cache_path.string() ) );
+        const char *p = mapping->data();
+        const char *end = mapping->data() + mapping->size();
+
+        FLANNCacheHeader h;
+        if( mapping->size() < sizeof(h) )
+            return false;
+        memcpy( &h, p, sizeof(h) );
+        p += sizeof(h);
+
+        if( memcmp( h.magic_, FLANN_CACHE_MAGIC, sizeof(h.magic_) ) || h.version_ != FLANN_CACHE_VERSION ||
+                h.distance_metric_ != param_.distance_metric_ || h.kdtree_num_trees_ != param_.kdtree_num_trees_ ||
+                h.quantized_ != (useQuantizedDescriptors() ? 1 : 0) || h.fingerprint_ != fingerprint )
         {
-            lomdb->flann_index_l1_.reset( new ::flann::Index<::flann::L1<float> > (*(lomdb->flann_data_), ::flann::KDTreeIndexParams (param_.kdtree_num_trees_)));
-    //        lomdb_->flann_index_l1_.reset( new flann::Index<flann::L1<float> > (*(lomdb_->flann_data_), flann::LinearIndexParams()));
-            lomdb->flann_index_l1_->buildIndex();
+            LOG(INFO) << "FLANN cache " << cache_path.string() << " is outdated. Rebuilding it.";
+            return false;
         }
-        lomdbs_[est_id] = lomdb;
+
+        const size_t element_size = h.quantized_ ? sizeof(unsigned char) : sizeof(float);
+        if( !h.rows_ || !h.cols_ || h.data_offset_ > mapping->size() ||
+                h.rows_ > (mapping->size() - h.data_offset_) / element_size / h.cols_ )
+            throw std::runtime_error("signature matrix exceeds file size");
+
+        std::vector<std::string> model_ids( h.num_models_ );
+        for(std::string &id : model_ids)
+        {
+            uint32_t len;
+            if( end - p < (ptrdiff_t) sizeof(len) )
+                throw std::runtime_error("truncated model table");
+            memcpy( &len, p, sizeof(len) );
+            p += sizeof(len);
+            if( end - p < (ptrdiff_t) len )
+                throw std::runtime_error("truncated model table");
+            id.assign( p, len );
+            p += len;
+        }
+
+        if( h.rows_ > (uint64_t)(end - p) / (2 * sizeof(uint32_t)) )
+            throw std::runtime_error("truncated keypoint table");
+
+        lomdb.flann_models_.resize( h.rows_ );
+        for(auto &fm : lomdb.flann_models_)
+        {
+            uint32_t entry[2];
+            memcpy( entry, p, sizeof(entry) );
+            p += sizeof(entry);
+            if( entry[0] >= model_ids.size() )
+                throw std::runtime_error("invalid model index");
+            fm.model_id_ = model_ids[ entry[0] ];
+            fm.keypoint_id_ = entry[1];
+        }
+
+        if( h.quantized_ )
+        {
+            if( h.cols_ > (uint64_t)(end - p) / (2 * sizeof(float)) )
+                throw std::runtime_error("truncated quantization table");
+
+            std::vector<float> offset( h.cols_ ), scale( h.cols_ );
+            memcpy( offset.data(), p, h.cols_ * sizeof(float) );
+            p += h.cols_ * sizeof(float);
+            memcpy( scale.data(), p, h.cols_ * sizeof(float) );
+            p += h.cols_ * sizeof(float);
+            lomdb.quantizer_.set( offset, scale );
+
+            unsigned char *data = reinterpret_cast<unsigned char*>( const_cast<char*>( mapping->data() + h.data_offset_ ) ); // FLANN never writes to the data set
+            lomdb.flann_data_quantized_.reset( new flann::Matrix<unsigned char>( data, h.rows_, h.cols_ ) );
+            lomdb.flann_data_mapping_ = mapping;
+
+            if(param_.distance_metric_==2)
+                loadFLANNIndex( lomdb.flann_index_l2_quantized_, *lomdb.flann_data_quantized_, index_path, QuantizedL2( lomdb.quantizer_ ) );
+            else
+                loadFLANNIndex( lomdb.flann_index_l1_quantized_, *lomdb.flann_data_quantized_, index_path, QuantizedL1( lomdb.quantizer_ ) );
+
+            LOG(INFO) << "Loaded FLANN cache with " << h.rows_ << " quantized signatures from " << cache_path.string() << ".";
+            return true;
+        }
+
+        float *data = reinterpret_cast<float*>( const_cast<char*>( mapping->data() + h.data_offset_ ) ); // FLANN never writes to the data set
+        lomdb.flann_data_.reset( new flann::Matrix<float>( data, h.rows_, h.cols_ ) );
+        lomdb.flann_data_mapping_ = mapping;
+
+        if(param_.distance_metric_==2)
+            loadFLANNIndex( lomdb.flann_index_l2_, *lomdb.flann_data_, index_path );
+        else if(param_.distance_metric_==3)
+            loadFLANNIndex( lomdb.flann_index_chisquare_, *lomdb.flann_data_, index_path );
+        else if(param_.distance_metric_==4)
+            loadFLANNIndex( lomdb.flann_index_hellinger_, *lomdb.flann_data_, index_path );
+        else
+            loadFLANNIndex( lomdb.flann_index_l1_, *lomdb.flann_data_, index_path );
+    }
+    catch (const std::exception &e)
+    {
+        LOG(WARNING) << "Could not load FLANN cache " << cache_path.string() << " (" << e.what() << "). Rebuilding it.";
+        lomdb.flann_models_.clear();
+        lomdb.flann_data_.reset();
+        lomdb.flann_data_mapping_.reset();
+        lomdb.flann_index_l1_.reset();
+        lomdb.flann_index_l2_.reset();
+        lomdb.flann_index_chisquare_.reset();
+        lomdb.flann_index_hellinger_.reset();
+        lomdb.flann_data_quantized_.reset();
+        lomdb.flann_index_l1_quantized_.reset();
+        lomdb.flann_index_l2_quantized_.reset();
+        return false;
     }
 
-    mergeKeypointsFromMultipleEstimators();
-    indices_.clear();
+    LOG(INFO) << "Loaded FLANN cache with " << lomdb.flann_data_->rows << " signatures from " << cache_path.string() << ".";
+    return true;
 }
 
 template<typename PointT>
@@ -570,6 +929,77 @@ LocalFeatureMatcher<PointT>::mergeKeypointsFromMultipleEstimators()
 }
 
 
+template<typename PointT>
+void
+LocalFeatureMatcher<PointT>::knnSearch(const LocalObjectModelDatabase &lomdb,
+                                       const ::flann::Matrix<float> &query_desc,
+                                       ::flann::Matrix<int> &indices,
+                                       ::flann::Matrix<float> &distances,
+                                       const ::flann::SearchParams &search_param) const
+{
+    if( lomdb.flann_data_quantized_ )
+    {
+        CHECK( query_desc.cols == lomdb.quantizer_.dimensions() );
+        std::vector<unsigned char> query_quantized( query_desc.rows * query_desc.cols );
+        for(size_t row=0; row<query_desc.rows; row++)
+            lomdb.quantizer_.quantize( query_desc[row], 1, &query_quantized[ row * query_desc.cols ] );
+
+        const ::flann::Matrix<unsigned char> query_desc_quantized ( query_quantized.data(), query_desc.rows, query_desc.cols );
+
+        if(param_.distance_metric_==2)
+            lomdb.flann_index_l2_quantized_->knnSearch (query_desc_quantized, indices, distances, param_.knn_, search_param);
+        else
+            lomdb.flann_index_l1_quantized_->knnSearch (query_desc_quantized, indices, distances, param_.knn_, search_param);
+        return;
+    }
+
+    if(param_.distance_metric_==2)
+        lomdb.flann_index_l2_->knnSearch (query_desc, indices, distances, param_.knn_, search_param);
+    else if(param_.distance_metric_==3)
+        lomdb.flann_index_chisquare_->knnSearch (query_desc, indices, distances, param_.knn_, search_param);
+    else if(param_.distance_metric_==4)
+        lomdb.flann_index_hellinger_->knnSearch (query_desc, indices, distances, param_.knn_, search_param);
+    else
+        lomdb.flann_index_l1_->knnSearch (query_desc, indices, distances, param_.knn_, search_param);
+}
+
+template<typename PointT>
+void
+LocalFeatureMatcher<PointT>::addCorrespondences(KeypointIndex s_idx,
+                                                const int *indices,
+                                                const float *distances,
+                                                const LocalObjectModelDatabase &lomdb,
+                                                size_t model_keypoint_offset)
+{
+    if(distances[0] > param_.max_descriptor_distance_)
+        return;
+
+    for (size_t i = 0; i < param_.knn_; i++)
+    {
+        const typename LocalObjectModelDatabase::flann_model &f = lomdb.flann_models_[ indices[i] ];
+        float m_dist = param_.correspondence_distance_weight_ * distances[i];
+
+        KeypointIndex m_idx = f.keypoint_id_ + model_keypoint_offset;
+//            CHECK ( m_idx < m_kps.keypoints_->points.size() );
+//            CHECK ( s_idx < scene_->points.size() );
+
+        typename std::map<std::string, LocalObjectHypothesis<PointT> >::iterator it_c = corrs_.find ( f.model_id_ );
+        if ( it_c != corrs_.end () )
+        { // append correspondences to existing ones
+            pcl::CorrespondencesPtr &corrs = it_c->second.model_scene_corresp_;
+            corrs->push_back( pcl::Correspondence ( m_idx, s_idx, m_dist ) );
+        }
+        else //create object hypothesis
+        {
+            LocalObjectHypothesis<PointT> new_loh;
+            new_loh.model_scene_corresp_.reset (new pcl::Correspondences);
+            new_loh.model_scene_corresp_->push_back( pcl::Correspondence ( m_idx, s_idx, m_dist ) );
+            new_loh.model_id_ = f.model_id_;
+            corrs_[ f.model_id_ ] = new_loh;
+        }
+    }
+}
+
 template<typename PointT>
 void
 LocalFeatureMatcher<PointT>::featureMatching(const std::vector<KeypointIndex> &kp_indices,
@@ -581,55 +1011,42 @@ LocalFeatureMatcher<PointT>::featureMatching(const std::vector<KeypointIndex> &k
 
     LOG(INFO) << "computing " << signatures.size () << " matches.";
 
-    int size_feat = signatures[0].size();
+    if( signatures.empty() )
+        return;
 
-    ::flann::Matrix<float> distances (new float[param_.knn_], 1, param_.knn_);
-    ::flann::Matrix<int> indices (new int[param_.knn_], 1, param_.knn_);
-    ::flann::Matrix<float> query_desc (new float[size_feat], 1, size_feat);
+    const size_t size_feat = signatures[0].size();
 
-    for (size_t idx = 0; idx < signatures.size (); idx++)
-    {
-        memcpy (&query_desc.ptr()[0], &signatures[idx][0], size_feat * sizeof(float));
+    // in batch mode, all signatures are matched in one call - otherwise one row is reused for each signature
+    const size_t num_query_rows = param_.batch_feature_matching_ ? signatures.size() : 1;
 
-        if(param_.distance_metric_==2)
-            lomdb->flann_index_l2_->knnSearch (query_desc, indices, distances, param_.knn_, ::flann::SearchParams (param_.kdtree_splits_));
-        else if(param_.distance_metric_==3)
-            lomdb->flann_index_chisquare_->knnSearch (query_desc, indices, distances, param_.knn_, ::flann::SearchParams (param_.kdtree_splits_));
-        else if(param_.distance_metric_==4)
-            lomdb->flann_index_hellinger_->knnSearch (query_desc, indices, distances, param_.knn_, ::flann::SearchParams (param_.kdtree_splits_));
-        else
-            lomdb->flann_index_l1_->knnSearch (query_desc, indices, distances, param_.knn_, ::flann::SearchParams (param_.kdtree_splits_));
+    ::flann::Matrix<float> distances (new float[num_query_rows * param_.knn_], num_query_rows, param_.knn_);
+    ::flann::Matrix<int> indices (new int[num_query_rows * param_.knn_], num_query_rows, param_.knn_);
+    ::flann::Matrix<float> query_desc (new float[num_query_rows * size_feat], num_query_rows, size_feat);
 
-        if(distances[0][0] > param_.max_descriptor_distance_)
-            continue;
+    ::flann::SearchParams search_param (param_.kdtree_splits_);
 
-        for (size_t i = 0; i < param_.knn_; i++)
+    if( param_.batch_feature_matching_ )
+    {
+        for (size_t idx = 0; idx < signatures.size (); idx++)
         {
-            const typename LocalObjectModelDatabase::flann_model &f = lomdb->flann_models_[ indices[0][i] ];
-            float m_dist = param_.correspondence_distance_weight_ * distances[0][i];
-
-            typename std::map<std::string, LocalObjectModel::ConstPtr >::const_iterator it = model_keypoints_.find( f.model_id_);
-//            const LocalObjectModel &m_kps = *(it->second);
+            CHECK ( signatures[idx].size() == size_feat );
+            memcpy (query_desc[idx], &signatures[idx][0], size_feat * sizeof(float));
+        }
 
-            KeypointIndex m_idx = f.keypoint_id_ + model_keypoint_offset;
-            KeypointIndex s_idx = kp_indices[idx];
-//            CHECK ( m_idx < m_kps.keypoints_->points.size() );
-//            CHECK ( kp_indices[idx] < scene_->points.size() );
+        search_param.cores = param_.feature_matching_threads_;  // 0... FLANN uses all available cores
+        knnSearch(*lomdb, query_desc, indices, distances, search_param);
 
-            typename std::map<std::string, LocalObjectHypothesis<PointT> >::iterator it_c = corrs_.find ( f.model_id_ );
-            if ( it_c != corrs_.end () )
-            { // append correspondences to existing ones
-                pcl::CorrespondencesPtr &corrs = it_c->second.model_scene_corresp_;
-                corrs->push_back( pcl::Correspondence ( m_idx, s_idx, m_dist ) );
-            }
-            else //create object hypothesis
-            {
-                LocalObjectHypothesis<PointT> new_loh;
-                new_loh.model_scene_corresp_.reset (new pcl::Correspondences);
-                new_loh.model_scene_corresp_->push_back( pcl::Correspondence ( m_idx, s_idx, m_dist ) );
-                new_loh.model_id_ = f.model_id_;
-                corrs_[ f.model_id_ ] = new_loh;
-            }
+        // correspondences are added in the order of the query signatures to get the same result as the sequential version
+        for (size_t idx = 0; idx < signatures.size (); idx++)
+            addCorrespondences(kp_indices[idx], indices[idx], distances[idx], *lomdb, model_keypoint_offset);
+    }
+    else
+    {
+        for (size_t idx = 0; idx < signatures.size (); idx++)
+        {
+            memcpy (query_desc[0], &signatures[idx][0], size_feat * sizeof(float));
+            knnSearch(*lomdb, query_desc, indices, distances, search_param);
+            addCorrespondences(kp_indices[idx], indices[0], distances[0], *lomdb, model_keypoint_offset);
         }
     }
 
@@ -3,11 +3,136 @@
 #include <v4r/features/types.h>
 
 #include <pcl/common/time.h>
+#include <pcl/recognition/cg/geometric_consistency.h>
 #include <pcl/registration/transformation_estimation_svd.h>
 
+#include <boost/unordered_map.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace v4r
 {
 
+namespace
+{
+/**
+ * @brief Voxel grid hash over the scene keypoint position of correspondences. Two correspondences can only be redundant
+ * if their scene keypoints are closer than the minimum distance, i.e. if they lie in the same or in neighboring cells.
+ * The grid is therefore used to collect candidates on which the exact redundancy check is done.
+ */
+class CorrespondenceVoxelHash
+{
+private:
+    float cell_size_inv_;
+    boost::unordered_map<int64_t, std::vector<size_t> > cells_;
+
+    int64_t
+    key(int x, int y, int z) const
+    {
+        return ( (int64_t)(x & 0x1FFFFF) << 42 ) | ( (int64_t)(y & 0x1FFFFF) << 21 ) | (int64_t)(z & 0x1FFFFF);
+    }
+
+    static int
+    clampedFloor(float v)
+    {
+        const float max_cell = 1e6f;   // keeps cell coordinates within the 21 bits used for hashing
+        return (int) std::floor( std::min( max_cell, std::max( -max_cell, v ) ) );
+    }
+
+    void
+    cell(const Eigen::Vector3f &p, int &x, int &y, int &z) const
+    {
+        x = clampedFloor( p(0) * cell_size_inv_ );
+        y = clampedFloor( p(1) * cell_size_inv_ );
+        z = clampedFloor( p(2) * cell_size_inv_ );
+    }
+
+public:
+    static const size_t npos = std::numeric_limits<size_t>::max();
+
+    /**
+     * @param min_dist distance below which two points are considered close. Cells are made slightly larger to be robust against rounding.
+     */
+    explicit CorrespondenceVoxelHash(float min_dist)
+        : cell_size_inv_ ( 1.f / (min_dist * 1.01f) )
+    { }
+
+    /**
+     * @return true if the point can be stored (points with non-finite coordinates are never close to anything)
+     */
+    static bool
+    isValid(const Eigen::Vector3f &p)
+    {
+        return pcl_isfinite(p(0)) && pcl_isfinite(p(1)) && pcl_isfinite(p(2));
+    }
+
+    void
+    insert(const Eigen::Vector3f &p, size_t id)
+    {
+        if( !isValid(p) )
+            return;
+
+        int x, y, z;
+        cell(p, x, y, z);
+        cells_[ key(x, y, z) ].push_back( id );
+    }
+
+    void
+    remove(const Eigen::Vector3f &p, size_t id)
+    {
+        if( !isValid(p) )
+            return;
+
+        int x, y, z;
+        cell(p, x, y, z);
+        boost::unordered_map<int64_t, std::vector<size_t> >::iterator it = cells_.find( key(x, y, z) );
+        if( it == cells_.end() )
+            return;
+
+        std::vector<size_t> &ids = it->second;
+        ids.erase( std::remove(ids.begin(), ids.end(), id), ids.end() );
+    }
+
+    /**
+     * @brief returns the smallest id stored close to p for which the predicate is true
+     * @return id or npos if there is none
+     */
+    template<typename Predicate>
+    size_t
+    findFirst(const Eigen::Vector3f &p, Predicate pred) const
+    {
+        if( !isValid(p) )
+            return npos;
+
+        int x, y, z;
+        cell(p, x, y, z);
+
+        size_t first = npos;
+        for(int dx=-1; dx<=1; dx++)
+        {
+            for(int dy=-1; dy<=1; dy++)
+            {
+                for(int dz=-1; dz<=1; dz++)
+                {
+                    boost::unordered_map<int64_t, std::vector<size_t> >::const_iterator it = cells_.find( key(x+dx, y+dy, z+dz) );
+                    if( it == cells_.end() )
+                        continue;
+
+                    for(size_t id : it->second)
+                    {
+                        if( id < first && pred(id) )
+                            first = id;
+                    }
+                }
+            }
+        }
+        return first;
+    }
+};
+}
+
 template<typename PointT>
 void
 LocalRecognitionPipeline<PointT>::initialize(const std::string &trained_dir, bool force_retrain)
@@ -53,40 +178,67 @@ LocalRecognitionPipeline<PointT>::initialize(const std::string &trained_dir, boo
 }
 
 template<typename PointT>
-void
-LocalRecognitionPipeline<PointT>::correspondenceGrouping ()
+typename boost::shared_ptr< pcl::CorrespondenceGrouping<pcl::PointXYZ, pcl::PointXYZ> >
+LocalRecognitionPipeline<PointT>::cloneCGAlgorithm () const
 {
-    pcl::PointCloud<pcl::PointXYZ>::Ptr scene_cloud_xyz (new pcl::PointCloud<pcl::PointXYZ>);
-    pcl::copyPointCloud( *scene_, *scene_cloud_xyz );
+    typedef pcl::CorrespondenceGrouping<pcl::PointXYZ, pcl::PointXYZ> CGBase;
 
-//#pragma omp parallel for schedule(dynamic)
-    typename std::map<std::string, LocalObjectHypothesis<PointT> >::const_iterator it;
-    for ( it = local_obj_hypotheses_.begin (); it != local_obj_hypotheses_.end (); ++it )
+    typename GraphGeometricConsistencyGrouping<pcl::PointXYZ, pcl::PointXYZ>::ConstPtr gcg_algorithm =
+            boost::dynamic_pointer_cast< const GraphGeometricConsistencyGrouping<pcl::PointXYZ, pcl::PointXYZ> > (cg_algorithm_);
+    if( gcg_algorithm )
+        return gcg_algorithm->clone();
+
+    boost::shared_ptr< const pcl::GeometricConsistencyGrouping<pcl::PointXYZ, pcl::PointXYZ> > gc_algorithm =
+            boost::dynamic_pointer_cast< const pcl::GeometricConsistencyGrouping<pcl::PointXYZ, pcl::PointXYZ> > (cg_algorithm_);
+    if( gc_algorithm )
     {
-        const std::string &model_id = it->first;
-        const LocalObjectHypothesis<PointT> &loh = it->second;
+        boost::shared_ptr< pcl::GeometricConsistencyGrouping<pcl::PointXYZ, pcl::PointXYZ> > gc_clone (new pcl::GeometricConsistencyGrouping<pcl::PointXYZ, pcl::PointXYZ>);
+        gc_clone->setGCSize( gc_algorithm->getGCSize() );
+        gc_clone->setGCThreshold( gc_algorithm->getGCThreshold() );
+        return gc_clone;
+    }
+
+    return boost::shared_ptr<CGBase>();
+}
+
+template<typename PointT>
+void
+LocalRecognitionPipeline<PointT>::correspondenceGrouping (const std::string &model_id,
+                                                          const LocalObjectHypothesis<PointT> &loh,
+                                                          pcl::CorrespondenceGrouping<pcl::PointXYZ, pcl::PointXYZ> &cg,
+                                                          const pcl::PointCloud<pcl::PointXYZ>::ConstPtr &scene_cloud_xyz,
+                                                          std::vector<ObjectHypothesesGroup> &ohgs) const
+{
+    ohgs.clear();
+
+    std::stringstream desc; desc << "Correspondence grouping for " << model_id << " ( " << loh.model_scene_corresp_->size() << ")" ;
+    TraceSpan t(trace_, desc.str());
 
-        std::stringstream desc; desc << "Correspondence grouping for " << model_id << " ( " << loh.model_scene_corresp_->size() << ")" ;
-        typename RecognitionPipeline<PointT>::StopWatch t(desc.str());
+    if( loh.model_scene_corresp_->size() < 3 )
+        return;
 
-        pcl::PointCloud<pcl::PointXYZ>::Ptr model_keypoints = model_keypoints_[model_id]->keypoints_;
-        pcl::PointCloud<pcl::Normal>::Ptr model_kp_normals = model_keypoints_[model_id]->kp_normals_;
+    typename std::map<std::string, typename LocalObjectModel::ConstPtr>::const_iterator it_mkp = model_keypoints_.find(model_id);
+    if( it_mkp == model_keypoints_.end() )
+    {
+        LOG(ERROR) << "No keypoints found for model " << model_id << "!";
+        return;
+    }
 
-        if( loh.model_scene_corresp_->size() < 3 )
-            continue;
+    pcl::PointCloud<pcl::PointXYZ>::Ptr model_keypoints = it_mkp->second->keypoints_;
+    pcl::PointCloud<pcl::Normal>::Ptr model_kp_normals = it_mkp->second->kp_normals_;
 
-        std::sort( loh.model_scene_corresp_->begin(), loh.model_scene_corresp_->end(), LocalObjectHypothesis<PointT>::gcGraphCorrespSorter);
-        std::vector < pcl::Correspondences > corresp_clusters;
-        cg_algorithm_->setSceneCloud ( scene_cloud_xyz );
-        cg_algorithm_->setInputCloud ( model_keypoints );
+    std::sort( loh.model_scene_corresp_->begin(), loh.model_scene_corresp_->end(), LocalObjectHypothesis<PointT>::gcGraphCorrespSorter);
+    std::vector < pcl::Correspondences > corresp_clusters;
+    cg.setSceneCloud ( scene_cloud_xyz );
+    cg.setInputCloud ( model_keypoints );
 
 //        oh.visualize(*scene_, *scene_keypoints_);
 
-        // Graph-based correspondence grouping requires normals but interface does not exist in base class - so need to try pointer casting
-        typename GraphGeometricConsistencyGrouping<pcl::PointXYZ, pcl::PointXYZ>::Ptr gcg_algorithm =
-                boost::dynamic_pointer_cast<  GraphGeometricConsistencyGrouping<pcl::PointXYZ, pcl::PointXYZ> > (cg_algorithm_);
-        if( gcg_algorithm )
-            gcg_algorithm->setInputAndSceneNormals(model_kp_normals, scene_normals_);
+    // Graph-based correspondence grouping requires normals but interface does not exist in base class - so need to try pointer casting
+    GraphGeometricConsistencyGrouping<pcl::PointXYZ, pcl::PointXYZ> *gcg_algorithm =
+            dynamic_cast<  GraphGeometricConsistencyGrouping<pcl::PointXYZ, pcl::PointXYZ> * > (&cg);
+    if( gcg_algorithm )
+        gcg_algorithm->setInputAndSceneNormals(model_kp_normals, scene_normals_);
 
 //        for ( const auto c : *(loh.model_scene_corresp_) )
 //        {
@@ -96,93 +248,113 @@ LocalRecognitionPipeline<PointT>::correspondenceGrouping ()
 //            CHECK( c.index_query < (int) model_kp_normals->points.size() && c.index_query >= 0 );
 //        }
 
-        //we need to pass the keypoints_pointcloud and the specific object hypothesis
-        cg_algorithm_->setModelSceneCorrespondences ( loh.model_scene_corresp_ );
-        cg_algorithm_->cluster (corresp_clusters);
+    //we need to pass the keypoints_pointcloud and the specific object hypothesis
+    cg.setModelSceneCorrespondences ( loh.model_scene_corresp_ );
+    cg.cluster (corresp_clusters);
 
-        std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > new_transforms (corresp_clusters.size());
-        typename pcl::registration::TransformationEstimationSVD < pcl::PointXYZ, pcl::PointXYZ > t_est;
+    std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > new_transforms (corresp_clusters.size());
+    typename pcl::registration::TransformationEstimationSVD < pcl::PointXYZ, pcl::PointXYZ > t_est;
 
-        for (size_t cluster_id = 0; cluster_id < corresp_clusters.size(); cluster_id++)
-            t_est.estimateRigidTransformation (*model_keypoints, *scene_cloud_xyz, corresp_clusters[cluster_id], new_transforms[cluster_id]);
+    for (size_t cluster_id = 0; cluster_id < corresp_clusters.size(); cluster_id++)
+        t_est.estimateRigidTransformation (*model_keypoints, *scene_cloud_xyz, corresp_clusters[cluster_id], new_transforms[cluster_id]);
 
-        if(param_.merge_close_hypotheses_) {
-            std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > merged_transforms (corresp_clusters.size());
-            std::vector<bool> cluster_has_been_taken(corresp_clusters.size(), false);
-            const double angle_thresh_rad = param_.merge_close_hypotheses_angle_ * M_PI / 180.f ;
+    if(param_.merge_close_hypotheses_) {
+        std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > merged_transforms (corresp_clusters.size());
+        std::vector<bool> cluster_has_been_taken(corresp_clusters.size(), false);
+        const double angle_thresh_rad = param_.merge_close_hypotheses_angle_ * M_PI / 180.f ;
 
-            size_t kept=0;
-            for (size_t tf_id = 0; tf_id < new_transforms.size(); tf_id++) {
+        size_t kept=0;
+        for (size_t tf_id = 0; tf_id < new_transforms.size(); tf_id++) {
 
-                if (cluster_has_been_taken[tf_id])
-                    continue;
+            if (cluster_has_been_taken[tf_id])
+                continue;
 
-                cluster_has_been_taken[tf_id] = true;
-                const Eigen::Vector3f centroid1 = new_transforms[tf_id].block<3, 1> (0, 3);
-                const Eigen::Matrix3f rot1 = new_transforms[tf_id].block<3, 3> (0, 0);
+            cluster_has_been_taken[tf_id] = true;
+            const Eigen::Vector3f centroid1 = new_transforms[tf_id].block<3, 1> (0, 3);
+            const Eigen::Matrix3f rot1 = new_transforms[tf_id].block<3, 3> (0, 0);
 
-                pcl::Correspondences merged_corrs = corresp_clusters[tf_id];
+            pcl::Correspondences merged_corrs = corresp_clusters[tf_id];
 
-                for(size_t j=tf_id+1; j < new_transforms.size(); j++) {
-                    const Eigen::Vector3f centroid2 = new_transforms[j].block<3, 1> (0, 3);
-                    const Eigen::Matrix3f rot2 = new_transforms[j].block<3, 3> (0, 0);
-                    const Eigen::Matrix3f rot_diff = rot2 * rot1.transpose();
+            for(size_t j=tf_id+1; j < new_transforms.size(); j++) {
+                const Eigen::Vector3f centroid2 = new_transforms[j].block<3, 1> (0, 3);
+                const Eigen::Matrix3f rot2 = new_transforms[j].block<3, 3> (0, 0);
+                const Eigen::Matrix3f rot_diff = rot2 * rot1.transpose();
 
-                    double rotx = std::abs( atan2(rot_diff(2,1), rot_diff(2,2)));
-                    double roty = std::abs( atan2(-rot_diff(2,0), sqrt(rot_diff(2,1) * rot_diff(2,1) + rot_diff(2,2) * rot_diff(2,2))) );
-                    double rotz = std::abs( atan2(rot_diff(1,0), rot_diff(0,0)) );
-                    double dist = (centroid1 - centroid2).norm();
+                double rotx = std::abs( atan2(rot_diff(2,1), rot_diff(2,2)));
+                double roty = std::abs( atan2(-rot_diff(2,0), sqrt(rot_diff(2,1) * rot_diff(2,1) + rot_diff(2,2) * rot_diff(2,2))) );
+                double rotz = std::abs( atan2(rot_diff(1,0), rot_diff(0,0)) );
+                double dist = (centroid1 - centroid2).norm();
 
-                    if ( (dist < param_.merge_close_hypotheses_dist_) && (rotx < angle_thresh_rad) && (roty < angle_thresh_rad) && (rotz < angle_thresh_rad) ) {
-                        merged_corrs.insert( merged_corrs.end(), corresp_clusters[j].begin(), corresp_clusters[j].end() );
-                        cluster_has_been_taken[j] = true;
-                    }
+                if ( (dist < param_.merge_close_hypotheses_dist_) && (rotx < angle_thresh_rad) && (roty < angle_thresh_rad) && (rotz < angle_thresh_rad) ) {
+                    merged_corrs.insert( merged_corrs.end(), corresp_clusters[j].begin(), corresp_clusters[j].end() );
+                    cluster_has_been_taken[j] = true;
                 }
-
-                t_est.estimateRigidTransformation ( *model_keypoints, *scene_cloud_xyz, merged_corrs, merged_transforms[kept] );
-                kept++;
             }
-            merged_transforms.resize(kept);
 
-            #pragma omp critical
-            {
-                for(size_t jj=0; jj<merged_transforms.size(); jj++)
-                {
-                    typename ObjectHypothesis::Ptr new_oh (new ObjectHypothesis);
-                    new_oh->model_id_ = model_id;
-                    new_oh->class_id_ = "";
-                    new_oh->transform_ = merged_transforms[jj];
-                    new_oh->confidence_ = corresp_clusters.size();
-                    new_oh->corr_ = corresp_clusters[jj];
-
-                    ObjectHypothesesGroup new_ohg;
-                    new_ohg.global_hypotheses_ = false;
-                    new_ohg.ohs_.push_back( new_oh );
-                    obj_hypotheses_.push_back( new_ohg );
-                }
-                LOG(INFO) << "Merged " << corresp_clusters.size() << " clusters into " << kept << " clusters. Total correspondences: " << loh.model_scene_corresp_->size () << " " << loh.model_id_;
-            }
+            t_est.estimateRigidTransformation ( *model_keypoints, *scene_cloud_xyz, merged_corrs, merged_transforms[kept] );
+            kept++;
         }
-        else {
-            #pragma omp critical
-            {
-                for(size_t jj=0; jj<new_transforms.size(); jj++)
-                {
-                    typename ObjectHypothesis::Ptr new_oh (new ObjectHypothesis);
-                    new_oh->model_id_ = model_id;
-                    new_oh->class_id_ = "";
-                    new_oh->transform_ = new_transforms[jj];
-                    new_oh->confidence_ = corresp_clusters.size();
-                    new_oh->corr_ = corresp_clusters[jj];
-
-                    ObjectHypothesesGroup new_ohg;
-                    new_ohg.global_hypotheses_ = false;
-                    new_ohg.ohs_.push_back( new_oh );
-                    obj_hypotheses_.push_back( new_ohg );
-                }
-            }
+        merged_transforms.resize(kept);
+        new_transforms.swap(merged_transforms);
+        LOG(INFO) << "Merged " << corresp_clusters.size() << " clusters into " << kept << " clusters. Total correspondences: " << loh.model_scene_corresp_->size () << " " << loh.model_id_;
+    }
+
+    ohgs.resize( new_transforms.size() );
+    for(size_t jj=0; jj<new_transforms.size(); jj++)
+    {
+        typename ObjectHypothesis::Ptr new_oh (new ObjectHypothesis);
+        new_oh->model_id_ = model_id;
+        new_oh->class_id_ = "";
+        new_oh->transform_ = new_transforms[jj];
+        new_oh->confidence_ = corresp_clusters.size();
+        new_oh->corr_ = corresp_clusters[jj];
+
+        ObjectHypothesesGroup &new_ohg = ohgs[jj];
+        new_ohg.global_hypotheses_ = false;
+        new_ohg.ohs_.push_back( new_oh );
+    }
+}
+
+template<typename PointT>
+void
+LocalRecognitionPipeline<PointT>::correspondenceGrouping ()
+{
+    pcl::PointCloud<pcl::PointXYZ>::Ptr scene_cloud_xyz (new pcl::PointCloud<pcl::PointXYZ>);
+    pcl::copyPointCloud( *scene_, *scene_cloud_xyz );
+    pcl::PointCloud<pcl::PointXYZ>::ConstPtr scene_cloud_xyz_const = scene_cloud_xyz;
+
+    // random access to the hypotheses (std::map iterators can not be used by omp parallel for)
+    std::vector<typename std::map<std::string, LocalObjectHypothesis<PointT> >::const_iterator> lohs;
+    lohs.reserve( local_obj_hypotheses_.size() );
+    typename std::map<std::string, LocalObjectHypothesis<PointT> >::const_iterator it;
+    for ( it = local_obj_hypotheses_.begin (); it != local_obj_hypotheses_.end (); ++it )
+        lohs.push_back(it);
+
+    std::vector< std::vector<ObjectHypothesesGroup> > ohgs_per_model ( lohs.size() );
+
+    // grouping mutates the state of the algorithm, so each thread needs its own instance. If the given algorithm can not be cloned, we fall back to serial processing.
+    bool can_clone = lohs.size() > 1 && cloneCGAlgorithm();
+
+    if ( can_clone )
+    {
+#pragma omp parallel
+        {
+            typename boost::shared_ptr< pcl::CorrespondenceGrouping<pcl::PointXYZ, pcl::PointXYZ> > cg = cloneCGAlgorithm();
+
+#pragma omp for schedule(dynamic)
+            for ( size_t i = 0; i < lohs.size(); i++ )
+                correspondenceGrouping( lohs[i]->first, lohs[i]->second, *cg, scene_cloud_xyz_const, ohgs_per_model[i] );
         }
     }
+    else
+    {
+        for ( size_t i = 0; i < lohs.size(); i++ )
+            correspondenceGrouping( lohs[i]->first, lohs[i]->second, *cg_algorithm_, scene_cloud_xyz_const, ohgs_per_model[i] );
+    }
+
+    // merge in model order so that the result does not depend on thread scheduling
+    for ( size_t i = 0; i < ohgs_per_model.size(); i++ )
+        obj_hypotheses_.insert( obj_hypotheses_.end(), ohgs_per_model[i].begin(), ohgs_per_model[i].end() );
 }
 
 template<typename PointT>
@@ -220,50 +392,34 @@ LocalRecognitionPipeline<PointT>::do_recognize()
             for (pcl::Correspondence &c : new_corrs) // add appropriate offset to correspondence index of the model keypoints
                 c.index_query += model_kp_idx_range_start_[ r_id ][ model_id ];
 
-            if( rec->getNumEstimators()>1 ) // check for redundancy (e.g. multi-scale feature matching)
+            // two correspondences are redundant if both their scene and model keypoints are close and have similar surface normals
+            const float min_dist = param_.min_dist_;
+            const float max_dotp = param_.max_dotp_;
+            auto isRedundant = [&](const pcl::Correspondence &a, const pcl::Correspondence &b)
+            {
+                return (scene_->points[a.index_match].getVector3fMap() - scene_->points[b.index_match].getVector3fMap()).norm() < min_dist &&
+                       (model_keypoints->points[a.index_query].getVector3fMap() - model_keypoints->points[b.index_query].getVector3fMap()).norm() < min_dist &&
+                        scene_normals_->points[a.index_match].getNormalVector3fMap().dot( scene_normals_->points[b.index_match].getNormalVector3fMap() ) > max_dotp &&
+                        model_kp_normals->points[a.index_query].getNormalVector3fMap().dot( model_kp_normals->points[b.index_query].getNormalVector3fMap() ) > max_dotp;
+            };
+
+            // if the distance threshold is not positive, no correspondence can be redundant
+            const bool check_redundancy = min_dist > 0.f;
+
+            if( check_redundancy && rec->getNumEstimators()>1 ) // check for redundancy (e.g. multi-scale feature matching)
             {
+                CorrespondenceVoxelHash kept_hash (min_dist);
                 size_t kept = 0;
                 for(size_t new_corr_id=0; new_corr_id<new_corrs.size(); new_corr_id++) // add appropriate offset to correspondence index of the model keypoints
                 {
-                    pcl::Correspondence &new_c = new_corrs[new_corr_id];
-
-//                    CHECK( new_c.index_match < (int) scene_->points.size() && new_c.index_match >= 0 );
-//                    CHECK( new_c.index_match < (int) scene_normals_->points.size() && new_c.index_match >= 0 );
-//                    CHECK( new_c.index_query < (int) model_keypoints->points.size() && new_c.index_query >= 0 );
-//                    CHECK( new_c.index_query < (int) model_kp_normals->points.size() && new_c.index_query >= 0 );
-
+                    const pcl::Correspondence new_c = new_corrs[new_corr_id];
                     const Eigen::Vector3f &new_scene_xyz = scene_->points[new_c.index_match].getVector3fMap();
-                    const Eigen::Vector3f &new_scene_normal = scene_normals_->points[new_c.index_match].getNormalVector3fMap();
-                    const Eigen::Vector3f &new_model_xyz = model_keypoints->points[new_c.index_query].getVector3fMap();
-                    const Eigen::Vector3f &new_model_normal = model_kp_normals->points[new_c.index_query].getNormalVector3fMap();
-
-                    bool is_redundant = false;
-                    for(size_t old_corr_id=0; old_corr_id<kept; old_corr_id++)
-                    {
-                        pcl::Correspondence &exist_c = new_corrs[old_corr_id];
-
 
-//                        CHECK( exist_c.index_match < (int) scene_->points.size() && exist_c.index_match >= 0 );
-//                        CHECK( exist_c.index_match < (int) scene_normals_->points.size() && exist_c.index_match >= 0 );
-//                        CHECK( exist_c.index_query < (int) model_keypoints->points.size() && exist_c.index_query >= 0 );
-//                        CHECK( exist_c.index_query < (int) model_kp_normals->points.size() && exist_c.index_query >= 0 );
+                    size_t exist_corr_id = kept_hash.findFirst( new_scene_xyz, [&](size_t id) { return isRedundant(new_corrs[id], new_c); } );
 
-                        const Eigen::Vector3f &exist_scene_xyz = scene_->points[exist_c.index_match].getVector3fMap();
-                        const Eigen::Vector3f &exist_scene_normal = scene_normals_->points[exist_c.index_match].getNormalVector3fMap();
-                        const Eigen::Vector3f &exist_model_xyz = model_keypoints->points[exist_c.index_query].getVector3fMap();
-                        const Eigen::Vector3f &exist_model_normal = model_kp_normals->points[exist_c.index_query].getNormalVector3fMap();
-
-                        if ( (exist_scene_xyz-new_scene_xyz).norm() < param_.min_dist_ &&
-                             (exist_model_xyz-new_model_xyz).norm() < param_.min_dist_ &&
-                              exist_scene_normal.dot(new_scene_normal) > param_.max_dotp_ &&
-                              exist_model_normal.dot(new_model_normal) > param_.max_dotp_ )
-                        {
-                            is_redundant = true;
-                            break;
-                        }
-                    }
-                    if(!is_redundant)
+                    if( exist_corr_id == CorrespondenceVoxelHash::npos )
                     {
+                        kept_hash.insert( new_scene_xyz, kept );
                         new_corrs[kept++] = new_c;
                     }
                 }
@@ -278,40 +434,39 @@ LocalRecognitionPipeline<PointT>::do_recognize()
                 pcl::Correspondences &old_corrs = *it_mp_oh->second.model_scene_corresp_;
 
                 size_t kept=0; // check for redundancy
-                for(size_t new_corr_id=0; new_corr_id<new_corrs.size(); new_corr_id++)
+                if( check_redundancy )
                 {
-                    const pcl::Correspondence &new_c = new_corrs[new_corr_id];
-                    const Eigen::Vector3f &new_scene_xyz = scene_->points[new_c.index_match].getVector3fMap();
-                    const Eigen::Vector3f &new_scene_normal = scene_normals_->points[new_c.index_match].getNormalVector3fMap();
-                    const Eigen::Vector3f &new_model_xyz = model_keypoints->points[new_c.index_query].getVector3fMap();
-                    const Eigen::Vector3f &new_model_normal = model_kp_normals->points[new_c.index_query].getNormalVector3fMap();
-
-                    size_t is_redundant = false;
+                    CorrespondenceVoxelHash old_hash (min_dist);
                     for(size_t old_corr_id=0; old_corr_id<old_corrs.size(); old_corr_id++)
+                        old_hash.insert( scene_->points[old_corrs[old_corr_id].index_match].getVector3fMap(), old_corr_id );
+
+                    for(size_t new_corr_id=0; new_corr_id<new_corrs.size(); new_corr_id++)
                     {
-                        pcl::Correspondence &old_c = old_corrs[old_corr_id];
-                        const Eigen::Vector3f &old_scene_xyz = scene_->points[old_c.index_match].getVector3fMap();
-                        const Eigen::Vector3f &old_scene_normal = scene_normals_->points[old_c.index_match].getNormalVector3fMap();
-                        const Eigen::Vector3f &old_model_xyz = model_keypoints->points[old_c.index_query].getVector3fMap();
-                        const Eigen::Vector3f &old_model_normal = model_kp_normals->points[old_c.index_query].getNormalVector3fMap();
-
-                        if ( (old_scene_xyz-new_scene_xyz).norm() < param_.min_dist_ &&
-                             (old_model_xyz-new_model_xyz).norm() < param_.min_dist_ &&
-                              old_scene_normal.dot(new_scene_normal) > param_.max_dotp_ &&
-                              old_model_normal.dot(new_model_normal) > param_.max_dotp_ )
+                        const pcl::Correspondence new_c = new_corrs[new_corr_id];
+                        const Eigen::Vector3f &new_scene_xyz = scene_->points[new_c.index_match].getVector3fMap();
+
+                        // the first (lowest index) redundant existing correspondence is the one that gets compared
+                        size_t old_corr_id = old_hash.findFirst( new_scene_xyz, [&](size_t id) { return isRedundant(old_corrs[id], new_c); } );
+
+                        if( old_corr_id != CorrespondenceVoxelHash::npos )
                         {
-                            is_redundant = true;
+                            pcl::Correspondence &old_c = old_corrs[old_corr_id];
 
                             // take the correspondence with the smaller distance
                             if( new_c.distance < old_c.distance )
+                            {
+                                old_hash.remove( scene_->points[old_c.index_match].getVector3fMap(), old_corr_id );
                                 old_c = new_c;
-
-                            break;
+                                old_hash.insert( new_scene_xyz, old_corr_id );
+                            }
                         }
+                        else
+                            new_corrs[kept++] = new_c;
                     }
-                    if(!is_redundant)
-                        new_corrs[kept++] = new_c;
                 }
+                else
+                    kept = new_corrs.size();
+
                 LOG(INFO) << "Kept " << kept << " out of " << initial_corrs << " correspondences.";
                 new_corrs.resize(kept);
 
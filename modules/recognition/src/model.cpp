@@ -5,6 +5,7 @@
 
 #include <sstream>
 
+#include <glog/logging.h>
 #include <pcl/common/time.h>
 #include <pcl/common/transforms.h>
 #include <pcl/features/integral_image_normal.h>
@@ -17,14 +18,27 @@ namespace v4r
 {
 
 template<typename PointT>
-typename pcl::PointCloud<PointT>::ConstPtr
-Model<PointT>::getAssembled (int resolution_mm) const
+std::string
+Model<PointT>::voxelizedFilename(int resolution_mm) const
 {
-    if(resolution_mm <= 0)
-        return assembled_;
+    bf::path path = model_filename_;
+    std::stringstream filename;
+    filename << path.stem().string() << "_voxelized_" << resolution_mm << "mm.pcd";
+    return ( path.parent_path() / filename.str() ).string();
+}
 
-    const auto it = voxelized_assembled_.find (resolution_mm);
-    if (it == voxelized_assembled_.end ())
+template<typename PointT>
+void
+Model<PointT>::voxelize(int resolution_mm, bool use_disk_cache) const
+{
+    if( voxelized_assembled_.find(resolution_mm) != voxelized_assembled_.end() )
+        return;
+
+    const bool has_normals = normals_assembled_ && normals_assembled_->points.size() == assembled_->points.size();
+    const bool use_file = use_disk_cache && has_normals && !model_filename_.empty() && io::existsFile( model_filename_ );
+    const std::string voxelized_filename = use_file ? voxelizedFilename( resolution_mm ) : "";
+
+    if( !has_normals )  // voxelize only the point cloud
     {
         double resolution = (double)resolution_mm / 1000.;
         PointTPtr voxelized (new pcl::PointCloud<PointT>);
@@ -33,59 +47,89 @@ Model<PointT>::getAssembled (int resolution_mm) const
         grid.setLeafSize (resolution, resolution, resolution);
         grid.setDownsampleAllData(true);
         grid.filter (*voxelized);
-
-        PointTPtrConst voxelized_const (new pcl::PointCloud<PointT> (*voxelized));
-        voxelized_assembled_[resolution_mm] = voxelized_const;
-        return voxelized_const;
+        voxelized_assembled_[resolution_mm] = voxelized;
+        return;
     }
 
-    return it->second;
-}
-
-template<typename PointT>
-pcl::PointCloud<pcl::Normal>::ConstPtr
-Model<PointT>::getNormalsAssembled (int resolution_mm) const
-{
-    if(resolution_mm <= 0)
-        return normals_assembled_;
+    // voxelize points and normals together so that both clouds correspond to each other
+    typename pcl::PointCloud<PointTWithNormal>::Ptr voxelized (new pcl::PointCloud<PointTWithNormal>);
 
+    bool loaded = false;
+    if( use_file && io::existsFile( voxelized_filename ) &&
+            bf::last_write_time( voxelized_filename ) >= bf::last_write_time( model_filename_ ) )
+        loaded = pcl::io::loadPCDFile(voxelized_filename, *voxelized) != -1;
 
-    const auto it = normals_voxelized_assembled_.find (resolution_mm);
-    if (it == normals_voxelized_assembled_.end ())
+    if( !loaded )
     {
-        double resolution = resolution_mm / 1000.f;
-        pcl::PointCloud<pcl::PointNormal>::Ptr voxelized (new pcl::PointCloud<pcl::PointNormal>);
-        pcl::PointCloud<pcl::PointNormal>::Ptr assembled_with_normals (new pcl::PointCloud<pcl::PointNormal>);
-        assembled_with_normals->points.resize(assembled_->points.size());
-        assembled_with_normals->width = assembled_->width;
-        assembled_with_normals->height = assembled_->height;
-
-        for(size_t i=0; i < assembled_->points.size(); i++)
-        {
-            assembled_with_normals->points[i].getVector4fMap() = assembled_->points[i].getVector4fMap();
-            assembled_with_normals->points[i].getNormalVector4fMap() = normals_assembled_->points[i].getNormalVector4fMap();
-        }
+        typename pcl::PointCloud<PointTWithNormal>::Ptr assembled_with_normals (new pcl::PointCloud<PointTWithNormal>);
+        pcl::concatenateFields (*assembled_, *normals_assembled_, *assembled_with_normals);
 
-        pcl::VoxelGrid<pcl::PointNormal> grid;
+        double resolution = (double)resolution_mm / 1000.;
+        pcl::VoxelGrid<PointTWithNormal> grid;
         grid.setInputCloud (assembled_with_normals);
         grid.setLeafSize (resolution, resolution, resolution);
         grid.setDownsampleAllData(true);
         grid.filter (*voxelized);
 
-        pcl::PointCloud<pcl::Normal>::Ptr voxelized_const (new pcl::PointCloud<pcl::Normal> ());
-        voxelized_const->points.resize(voxelized->points.size());
-        voxelized_const->width = voxelized->width;
-        voxelized_const->height = voxelized->height;
+        if( use_file && !voxelized->points.empty() )
+        {
+            try
+            {
+                pcl::io::savePCDFileBinaryCompressed ( voxelized_filename, *voxelized);
+            }
+            catch(const std::exception &e)
+            {
+                LOG(WARNING) << "Could not save voxelized model to " << voxelized_filename << ": " << e.what();
+            }
+        }
+    }
 
-        for(size_t i=0; i < voxelized_const->points.size(); i++)
-            voxelized_const->points[i].getNormalVector4fMap() = voxelized->points[i].getNormalVector4fMap();
+    PointTPtr voxelized_cloud (new pcl::PointCloud<PointT>);
+    pcl::PointCloud<pcl::Normal>::Ptr voxelized_normals (new pcl::PointCloud<pcl::Normal>);
+    pcl::copyPointCloud( *voxelized, *voxelized_cloud );
+    pcl::copyPointCloud( *voxelized, *voxelized_normals );
+    voxelized_assembled_[resolution_mm] = voxelized_cloud;
+    normals_voxelized_assembled_[resolution_mm] = voxelized_normals;
+}
 
+template<typename PointT>
+void
+Model<PointT>::precomputeVoxelized(const std::vector<int> &resolutions_mm, bool use_disk_cache) const
+{
+    if( !assembled_ )   // not initialized
+        return;
 
-        normals_voxelized_assembled_[resolution_mm] = voxelized_const;
-        return voxelized_const;
+    boost::mutex::scoped_lock lock(voxelized_mtx_);
+    for(int resolution_mm : resolutions_mm)
+    {
+        if( resolution_mm > 0 )
+            voxelize( resolution_mm, use_disk_cache );
     }
+}
 
-    return it->second;
+template<typename PointT>
+typename pcl::PointCloud<PointT>::ConstPtr
+Model<PointT>::getAssembled (int resolution_mm) const
+{
+    if(resolution_mm <= 0)
+        return assembled_;
+
+    boost::mutex::scoped_lock lock(voxelized_mtx_);
+    voxelize( resolution_mm, false );
+    return voxelized_assembled_[resolution_mm];
+}
+
+template<typename PointT>
+pcl::PointCloud<pcl::Normal>::ConstPtr
+Model<PointT>::getNormalsAssembled (int resolution_mm) const
+{
+    if(resolution_mm <= 0)
+        return normals_assembled_;
+
+    boost::mutex::scoped_lock lock(voxelized_mtx_);
+    voxelize( resolution_mm, false );
+    const auto it = normals_voxelized_assembled_.find (resolution_mm);
+    return it != normals_voxelized_assembled_.end() ? it->second : pcl::PointCloud<pcl::Normal>::ConstPtr();
 }
 
 template<typename PointT>
@@ -118,6 +162,7 @@ void
 Model<PointT>::initialize(const std::string &model_filename)
 {
     typename pcl::PointCloud<PointTWithNormal>::Ptr all_assembled (new pcl::PointCloud<PointTWithNormal>);
+    model_filename_ = model_filename;
     if ( !io::existsFile(model_filename) || pcl::io::loadPCDFile(model_filename, *all_assembled) == -1 )
     {
         pcl::ScopeTime t("Creating 3D model");
@@ -141,11 +186,7 @@ Model<PointT>::initialize(const std::string &model_filename)
                 pcl::copyPointCloud( *v->cloud_, indices, *obj_cloud_tmp );
             }
             else
-            {
-                typename pcl::PointCloud<PointT>::Ptr cloud_tmp (new pcl::PointCloud<PointT>);
-                pcl::io::loadPCDFile(v->filename_, *cloud_tmp);
-                cloud = cloud_tmp;
-            }
+                cloud = v->getCloud();
 
 
             if(v->normals_)
@@ -236,6 +277,10 @@ Model<PointT>::initialize(const std::string &model_filename)
     pcl::copyPointCloud( * all_assembled, *normals_assembled_);
     pcl::getMinMax3D(*assembled_, minPoint_, maxPoint_);
     pcl::compute3DCentroid(*assembled_, centroid_);
+
+    boost::mutex::scoped_lock lock(voxelized_mtx_);
+    voxelized_assembled_.clear();
+    normals_voxelized_assembled_.clear();
 }
 
 //template<typename PointT>
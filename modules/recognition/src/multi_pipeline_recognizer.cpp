@@ -1,8 +1,13 @@
+#include <algorithm>
+#include <exception>
 #include <glog/logging.h>
-#include <omp.h>
 
 #include <v4r/recognition/multi_pipeline_recognizer.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 namespace v4r
 {
 
@@ -24,30 +29,70 @@ template<typename PointT>
 void
 MultiRecognitionPipeline<PointT>::do_recognize()
 {
-    omp_init_lock(&rec_lock_);
+    // pipelines only share the (read-only) scene, normals and model database. Each one writes its hypotheses into
+    // its own slot, so the order of the merged hypotheses does not depend on the thread scheduling. Their unique ids
+    // however are drawn from a global atomic counter (see ObjectHypothesis) and do depend on it
+    std::vector<std::vector<ObjectHypothesesGroup> > oh_per_pipeline ( recognition_pipelines_.size() );
+    const bool run_parallel = !visualizationEnabled();
+
+    // the pipelines parallelize internally as well (e.g. feature matching). Nested parallelism is enabled for this
+    // call and the available threads are split among the pipelines, otherwise the inner loops run single-threaded
+    int num_outer_threads = 1, num_inner_threads = 1;
+#ifdef _OPENMP
+    const int max_threads = omp_get_max_threads();
+    const int prev_max_active_levels = omp_get_max_active_levels();
+    num_outer_threads = std::max(1, std::min<int>(recognition_pipelines_.size(), max_threads));
+    num_inner_threads = std::max(1, max_threads / num_outer_threads);
+    if( run_parallel )
+        omp_set_max_active_levels( std::max(prev_max_active_levels, 2) );
+#endif
+
+    // exceptions must not leave the parallel region, so the first one is rethrown after the loop
+    std::exception_ptr recognition_exception;
 
-//#pragma omp parallel for schedule(dynamic)
+#pragma omp parallel for schedule(dynamic) num_threads(num_outer_threads) if(run_parallel)
     for(size_t r_id=0; r_id < recognition_pipelines_.size(); r_id++)
     {
-        typename RecognitionPipeline<PointT>::Ptr r = recognition_pipelines_[r_id];
-        r->setInputCloud( scene_ );
-        r->setSceneNormals( scene_normals_ );
+        try
+        {
+#ifdef _OPENMP
+            if( run_parallel )
+                omp_set_num_threads( num_inner_threads );   // only affects parallel regions started by this thread
+#endif
+            typename RecognitionPipeline<PointT>::Ptr r = recognition_pipelines_[r_id];
+            r->setInputCloud( scene_ );
+            r->setSceneNormals( scene_normals_ );
 
-        if( table_plane_set_ )
-            r->setTablePlane( table_plane_ );
+            if( table_plane_set_ )
+                r->setTablePlane( table_plane_ );
 
-        r->recognize();
+            r->setTraceContext( trace_ );
+            r->recognize();
 
-        std::vector<ObjectHypothesesGroup> oh_tmp = r->getObjectHypothesis();
-        omp_set_lock(&rec_lock_);
-        obj_hypotheses_.insert( obj_hypotheses_.end(), oh_tmp.begin(), oh_tmp.end() );
-        omp_unset_lock(&rec_lock_);
+            oh_per_pipeline[r_id] = r->getObjectHypothesis();
+        }
+        catch(...)
+        {
+#pragma omp critical
+            {
+                if( !recognition_exception )
+                    recognition_exception = std::current_exception();
+            }
+        }
+    }
+
+#ifdef _OPENMP
+    omp_set_max_active_levels( prev_max_active_levels );
+#endif
 
-        std::vector< std::pair<std::string,float> > elapsed_times_tmp = r->getElapsedTimes();
-        elapsed_time_.insert( elapsed_time_.end(), elapsed_times_tmp.begin(), elapsed_times_tmp.end() );
+    if( recognition_exception )
+    {
+        table_plane_set_ = false;
+        std::rethrow_exception( recognition_exception );
     }
 
-    omp_destroy_lock(&rec_lock_);
+    for(const std::vector<ObjectHypothesesGroup> &oh_tmp : oh_per_pipeline)
+        obj_hypotheses_.insert( obj_hypotheses_.end(), oh_tmp.begin(), oh_tmp.end() );
 
     table_plane_set_ = false;
 }
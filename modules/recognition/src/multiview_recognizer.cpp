@@ -6,14 +6,27 @@
 #include <v4r/common/miscellaneous.h>
 #include <v4r/recognition/multiview_recognizer.h>
 
+#include <v4r/io/filesystem.h>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/serialization/shared_ptr.hpp>
+#include <boost/serialization/vector.hpp>
 #include <glog/logging.h>
 #include <omp.h>
 #include <pcl/common/time.h>
+#include <pcl/io/pcd_io.h>
 #include <pcl/recognition/cg/correspondence_grouping.h>
 #include <pcl/registration/transformation_estimation_svd.h>
 #include <pcl/visualization/pcl_visualizer.h>
 #include <pcl/visualization/point_cloud_color_handlers.h>
 
+#include <atomic>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
 namespace v4r
 {
 
@@ -32,6 +45,7 @@ MultiviewRecognizer<PointT>::do_recognize()
     if( table_plane_set_ )
         recognition_pipeline_->setTablePlane( table_plane_ );
 
+    recognition_pipeline_->setTraceContext( trace_ );
     recognition_pipeline_->recognize();
     v.obj_hypotheses_ = recognition_pipeline_->getObjectHypothesis();
 
@@ -240,8 +254,257 @@ MultiviewRecognizer<PointT>::do_recognize()
     }
 
     v.obj_hypotheses_ = obj_hypotheses_;
+    v.id_ = view_counter_++;
     views_.push_back(v);
 
+    // only the most recent max_views_-1 views are used when recognizing the next view
+    const size_t max_history = param_.max_views_ > 1 ? param_.max_views_ - 1 : 0;
+    while( views_.size() > max_history )
+    {
+        evictView( views_.front() );
+        views_.pop_front();
+    }
+}
+
+
+template<typename PointT>
+void
+MultiviewRecognizer<PointT>::evictView(const View &v)
+{
+    if( !param_.spill_dir_.empty() )
+        spillView(v);
+
+    if( !param_.compact_old_views_ || param_.max_view_summaries_ == 0 )
+        return;
+
+    ViewSummary s;
+    s.id_ = v.id_;
+    s.camera_pose_ = v.camera_pose_;
+
+    for(const ObjectHypothesesGroup &ohg : v.obj_hypotheses_)
+    {
+        ObjectHypothesesGroup ohg_verified;
+        ohg_verified.global_hypotheses_ = ohg.global_hypotheses_;
+
+        for( const typename ObjectHypothesis::Ptr &oh : ohg.ohs_)
+        {
+            if( oh->is_verified_ )
+                ohg_verified.ohs_.push_back( oh );
+        }
+
+        if( !ohg_verified.ohs_.empty() )
+            s.verified_hypotheses_.push_back( ohg_verified );
+    }
+
+    view_summaries_.push_back(s);
+
+    while( view_summaries_.size() > param_.max_view_summaries_ )
+        view_summaries_.pop_front();
+}
+
+
+template<typename PointT>
+MultiviewRecognizer<PointT>::~MultiviewRecognizer()
+{
+    clearSpilledViews();
+}
+
+
+template<typename PointT>
+std::string
+MultiviewRecognizer<PointT>::createSpillPrefix()
+{
+    static std::atomic<size_t> instance_counter (0);
+    std::stringstream prefix;
+    prefix << "mv_" << getpid() << "_" << instance_counter++ << "_";
+    return prefix.str();
+}
+
+
+template<typename PointT>
+std::string
+MultiviewRecognizer<PointT>::spilledViewPath(size_t view_id) const
+{
+    const bf::path view_path = bf::path(param_.spill_dir_) / ( spill_prefix_ + "view_" + std::to_string(view_id) );
+    return view_path.string();
+}
+
+
+template<typename PointT>
+void
+MultiviewRecognizer<PointT>::spillView(const View &v)
+{
+    // only one view is written at a time, so at most one dropped view is held in memory by the writer
+    if( spill_thread_.joinable() )
+        spill_thread_.join();
+
+    io::createDirIfNotExist( param_.spill_dir_ );
+
+    spilled_view_ids_.push_back( v.id_ );
+    while( param_.max_spilled_views_ > 0 && spilled_view_ids_.size() > param_.max_spilled_views_ )
+    {
+        removeSpilledView( spilled_view_ids_.front() );
+        spilled_view_ids_.pop_front();
+    }
+
+    // the hypotheses are deep-copied as they might still be changed (e.g. verified) while the view is written;
+    // local hypotheses and model keypoints are not written, so they are not copied at all
+    boost::shared_ptr<View> v_copy (new View);
+    v_copy->id_ = v.id_;
+    v_copy->camera_pose_ = v.camera_pose_;
+    v_copy->obj_hypotheses_ = v.obj_hypotheses_;
+    for(ObjectHypothesesGroup &ohg : v_copy->obj_hypotheses_)
+    {
+        for( typename ObjectHypothesis::Ptr &oh : ohg.ohs_)
+            oh.reset( new ObjectHypothesis(*oh) );
+    }
+    v_copy->scene_cloud_xyz_ = v.scene_cloud_xyz_;
+    v_copy->scene_cloud_normals_ = v.scene_cloud_normals_;
+
+    spill_thread_ = boost::thread( &MultiviewRecognizer<PointT>::writeSpilledView, spilledViewPath(v.id_), boost::shared_ptr<const View>(v_copy) );
+}
+
+
+template<typename PointT>
+void
+MultiviewRecognizer<PointT>::writeSpilledView(const std::string &view_path, boost::shared_ptr<const View> v)
+{
+    std::ofstream ofs( view_path + ".bin", std::ios::binary );
+    if( !ofs.is_open() )
+    {
+        LOG(ERROR) << "Could not write view " << v->id_ << " to " << view_path << ".bin!";
+        return;
+    }
+
+    Eigen::Matrix4f camera_pose = v->camera_pose_;
+    boost::archive::binary_oarchive oa(ofs);
+    oa << camera_pose << v->obj_hypotheses_;
+    ofs.close();
+
+    if( v->scene_cloud_xyz_ && !v->scene_cloud_xyz_->points.empty() )
+        pcl::io::savePCDFileBinaryCompressed( view_path + "_cloud.pcd", *v->scene_cloud_xyz_ );
+
+    if( v->scene_cloud_normals_ && !v->scene_cloud_normals_->points.empty() )
+        pcl::io::savePCDFileBinaryCompressed( view_path + "_normals.pcd", *v->scene_cloud_normals_ );
+}
+
+
+template<typename PointT>
+void
+MultiviewRecognizer<PointT>::removeSpilledView(size_t view_id) const
+{
+    const std::string view_path = spilledViewPath(view_id);
+
+    boost::system::error_code ec;
+    bf::remove( view_path + ".bin", ec );
+    bf::remove( view_path + "_cloud.pcd", ec );
+    bf::remove( view_path + "_normals.pcd", ec );
+}
+
+
+template<typename PointT>
+void
+MultiviewRecognizer<PointT>::clearSpilledViews()
+{
+    if( spill_thread_.joinable() )
+        spill_thread_.join();
+
+    for(size_t view_id : spilled_view_ids_)
+        removeSpilledView( view_id );
+
+    spilled_view_ids_.clear();
+}
+
+
+template<typename PointT>
+bool
+MultiviewRecognizer<PointT>::loadSpilledView(size_t view_id, Eigen::Matrix4f &camera_pose, std::vector<ObjectHypothesesGroup> &obj_hypotheses,
+                                             pcl::PointCloud<pcl::PointXYZ>::Ptr scene_cloud_xyz,
+                                             pcl::PointCloud<pcl::Normal>::Ptr scene_normals) const
+{
+    const std::string view_path = spilledViewPath(view_id);
+
+    // the most recently dropped view might still be written
+    if( spill_thread_.joinable() )
+        spill_thread_.join();
+
+    if( param_.spill_dir_.empty() || !io::existsFile( view_path + ".bin" ) )
+        return false;
+
+    // a truncated or foreign spill file must not abort recognition - the view is skipped instead
+    try
+    {
+        std::ifstream ifs( view_path + ".bin", std::ios::binary );
+        boost::archive::binary_iarchive ia(ifs);
+        ia >> camera_pose >> obj_hypotheses;
+        ifs.close();
+
+        if( scene_cloud_xyz && io::existsFile( view_path + "_cloud.pcd" ) && pcl::io::loadPCDFile( view_path + "_cloud.pcd", *scene_cloud_xyz ) < 0 )
+            throw std::runtime_error("could not read " + view_path + "_cloud.pcd");
+
+        if( scene_normals && io::existsFile( view_path + "_normals.pcd" ) && pcl::io::loadPCDFile( view_path + "_normals.pcd", *scene_normals ) < 0 )
+            throw std::runtime_error("could not read " + view_path + "_normals.pcd");
+    }
+    catch (const std::exception &e)
+    {
+        LOG(WARNING) << "Could not load spilled view " << view_id << " from " << view_path << " (" << e.what() << "). Skipping it.";
+        obj_hypotheses.clear();
+        return false;
+    }
+
+    return true;
+}
+
+
+template<typename PointT>
+size_t
+MultiviewRecognizer<PointT>::memoryUsage(const View &v)
+{
+    size_t bytes = sizeof(View);
+
+    for(const ObjectHypothesesGroup &ohg : v.obj_hypotheses_)
+    {
+        bytes += sizeof(ObjectHypothesesGroup);
+        for( const typename ObjectHypothesis::Ptr &oh : ohg.ohs_)
+            bytes += sizeof(ObjectHypothesis) + oh->corr_.capacity() * sizeof(pcl::Correspondence);
+    }
+
+    for(const auto &loh : v.local_obj_hypotheses_)
+    {
+        bytes += sizeof(loh) + loh.first.capacity();
+        if( loh.second.model_scene_corresp_ )
+            bytes += loh.second.model_scene_corresp_->capacity() * sizeof(pcl::Correspondence);
+    }
+
+    // model keypoints are shared with the local recognition pipeline and are therefore not counted
+
+    if( v.scene_cloud_xyz_ )
+        bytes += v.scene_cloud_xyz_->points.capacity() * sizeof(pcl::PointXYZ);
+
+    if( v.scene_cloud_normals_ )
+        bytes += v.scene_cloud_normals_->points.capacity() * sizeof(pcl::Normal);
+
+    return bytes;
+}
+
+
+template<typename PointT>
+size_t
+MultiviewRecognizer<PointT>::getMemoryUsage() const
+{
+    size_t bytes = 0;
+
+    for(const View &v : views_)
+        bytes += memoryUsage(v);
+
+    for(const ViewSummary &s : view_summaries_)
+    {
+        bytes += sizeof(ViewSummary);
+        for(const ObjectHypothesesGroup &ohg : s.verified_hypotheses_)
+            bytes += sizeof(ObjectHypothesesGroup) + ohg.ohs_.size() * sizeof(ObjectHypothesis); // hypotheses might be shared with other views
+    }
+
+    return bytes;
 }
 
 
@@ -502,7 +765,7 @@ MultiviewRecognizer<PointT>::correspondenceGrouping ()
         const LocalObjectHypothesis<PointT> &loh = it->second;
 
         std::stringstream desc; desc << "Correspondence grouping for " << model_id << " ( " << loh.model_scene_corresp_->size() << ")" ;
-        typename RecognitionPipeline<PointT>::StopWatch t(desc.str());
+        TraceSpan t(trace_, desc.str());
 
         pcl::PointCloud<pcl::PointXYZ>::Ptr model_keypoints = model_keypoints_[model_id]->keypoints_;
         pcl::PointCloud<pcl::Normal>::Ptr model_kp_normals = model_keypoints_[model_id]->kp_normals_;
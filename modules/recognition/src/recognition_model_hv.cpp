@@ -90,6 +90,10 @@ HVRecognitionModel<ModelT>::processSilhouette(bool do_smoothing,
 //                        f.close();
     }
     }
+
+    silhouettes_.resize( image_mask_.size() );
+    for(size_t view=0; view<image_mask_.size(); view++)
+        silhouettes_[view] = Silhouette( image_mask_[view], img_width );
 }
 
 
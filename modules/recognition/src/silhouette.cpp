@@ -0,0 +1,84 @@
+#include <v4r/recognition/silhouette.h>
+
+#include <algorithm>
+#include <bitset>
+
+namespace v4r
+{
+
+namespace
+{
+inline size_t
+popcount(uint64_t word)
+{
+    return std::bitset<64>(word).count();
+}
+}
+
+Silhouette::Silhouette()
+    : rows_begin_ (0), rows_end_ (0), words_begin_ (0), words_end_ (0), num_pixels_ (0)
+{ }
+
+Silhouette::Silhouette(const boost::dynamic_bitset<> &mask, int width)
+    : rows_begin_ (0), rows_end_ (0), words_begin_ (0), words_end_ (0), num_pixels_ (0)
+{
+    if( mask.none() || width <= 0 )
+        return;
+
+    // bounding rectangle
+    int u_min = width, u_max = -1, v_min = -1, v_max = -1;
+    for(size_t px = mask.find_first(); px != boost::dynamic_bitset<>::npos; px = mask.find_next(px))
+    {
+        const int u = px % width;
+        const int v = px / width;
+        if( v_min < 0 )
+            v_min = v;
+        v_max = v;
+        u_min = std::min(u_min, u);
+        u_max = std::max(u_max, u);
+    }
+
+    rows_begin_ = v_min;
+    rows_end_ = v_max + 1;
+    words_begin_ = u_min / 64;
+    words_end_ = u_max / 64 + 1;
+
+    const int words_per_row = words_end_ - words_begin_;
+    words_.resize( (rows_end_ - rows_begin_) * words_per_row, 0 );
+
+    for(size_t px = mask.find_first(); px != boost::dynamic_bitset<>::npos; px = mask.find_next(px))
+    {
+        const int u = px % width;
+        const int v = px / width;
+        words_[ (v - rows_begin_) * words_per_row + u / 64 - words_begin_ ] |= uint64_t(1) << (u % 64);
+        num_pixels_++;
+    }
+}
+
+size_t
+Silhouette::intersection(const Silhouette &other) const
+{
+    const int rows_begin = std::max(rows_begin_, other.rows_begin_);
+    const int rows_end = std::min(rows_end_, other.rows_end_);
+    const int words_begin = std::max(words_begin_, other.words_begin_);
+    const int words_end = std::min(words_end_, other.words_end_);
+
+    if( rows_begin >= rows_end || words_begin >= words_end )
+        return 0;
+
+    const int words_per_row = words_end_ - words_begin_;
+    const int other_words_per_row = other.words_end_ - other.words_begin_;
+
+    size_t num_intersections = 0;
+    for(int v = rows_begin; v < rows_end; v++)
+    {
+        const uint64_t *a = &words_[ (v - rows_begin_) * words_per_row + words_begin - words_begin_ ];
+        const uint64_t *b = &other.words_[ (v - other.rows_begin_) * other_words_per_row + words_begin - other.words_begin_ ];
+
+        for(int w = 0; w < words_end - words_begin; w++)
+            num_intersections += popcount( a[w] & b[w] );
+    }
+    return num_intersections;
+}
+
+}
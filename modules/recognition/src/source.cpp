@@ -4,11 +4,13 @@
 #include <v4r/recognition/source.h>
 #include <glog/logging.h>
 
+#include <exception>
+
 namespace v4r
 {
 
 template <typename PointT>
-Source<PointT>::Source(const std::string &model_database_path, bool has_categories) :
+Source<PointT>::Source(const std::string &model_database_path, bool has_categories, const typename PointCloudCache<PointT>::Ptr &view_cache) :
     model_scale_ ( 1.f ),
     load_views_(true),
     compute_normals_(false),
@@ -16,14 +18,20 @@ Source<PointT>::Source(const std::string &model_database_path, bool has_categori
     view_prefix_("cloud_"),
     pose_prefix_ ("pose_"),
     indices_prefix_ ("object_indices_"),
-    entropy_prefix_ ("entropy_")
+    entropy_prefix_ ("entropy_"),
+    view_cache_ (view_cache)
 {
+    if( !view_cache_ )
+        view_cache_.reset( new PointCloudCache<PointT> );
+
     std::vector<std::string> categories;
     if(has_categories)
         categories = io::getFoldersInDirectory(model_database_path);
     else
         categories.push_back("");
 
+    // collect all (category, instance) pairs first so that the models can be loaded in parallel
+    std::vector<std::pair<std::string, std::string> > model_ids;
     for( const std::string &cat : categories)
     {
         bf::path class_path = model_database_path;
@@ -31,8 +39,26 @@ Source<PointT>::Source(const std::string &model_database_path, bool has_categori
         std::vector<std::string> instance_names = io::getFoldersInDirectory( class_path.string() );
 
         LOG(INFO) << "Loading " << instance_names.size() << " object models from folder " << class_path.string() << ". ";
-        for(const std::string instance_name : instance_names)
+        for(const std::string &instance_name : instance_names)
+            model_ids.push_back( std::make_pair(cat, instance_name) );
+    }
+
+    std::vector<typename Model<PointT>::Ptr> models ( model_ids.size() );
+
+    // exceptions must not leave the parallel region, so the first one is rethrown after the loop
+    std::exception_ptr load_exception;
+
+#pragma omp parallel for schedule(dynamic)
+    for(size_t m_id=0; m_id<model_ids.size(); m_id++)
+    {
+        try
         {
+            const std::string &cat = model_ids[m_id].first;
+            const std::string &instance_name = model_ids[m_id].second;
+
+            bf::path class_path = model_database_path;
+            class_path /= cat;
+
             typename Model<PointT>::Ptr obj (new Model<PointT>);
             obj->id_ = instance_name;
             obj->class_ = cat;
@@ -51,6 +77,7 @@ Source<PointT>::Source(const std::string &model_database_path, bool has_categori
                 bf::path view_filename = object_dir;
                 view_filename /= training_view_filenames[v_id];
                 v->filename_ = view_filename.string();
+                v->cache_ = view_cache_;
 
                 v->pose_filename_ = v->filename_;
                 boost::replace_last (v->pose_filename_, view_prefix_, pose_prefix_);
@@ -70,9 +97,24 @@ Source<PointT>::Source(const std::string &model_database_path, bool has_categori
                 model3D_path /= "3D_model.pcd";
                 obj->initialize( model3D_path.string() );
             }
-            addModel( obj );
+            models[m_id] = obj;
+        }
+        catch(...)
+        {
+#pragma omp critical
+            {
+                if( !load_exception )
+                    load_exception = std::current_exception();
+            }
         }
     }
+
+    if( load_exception )
+        std::rethrow_exception( load_exception );
+
+    // add models in the order of the database folders independent of the thread scheduling
+    for(const typename Model<PointT>::Ptr &obj : models)
+        addModel( obj );
 }
 
 template class V4R_EXPORTS Source<pcl::PointXYZ>;
@@ -103,11 +103,21 @@ private:
 
     //this here is to create points as part of a sphere
     //The next two i stole from thomas mörwald
-    int search_midpoint(int &index_start, int &index_end, size_t &n_vertices, int &edge_walk,
+    static int search_midpoint(int &index_start, int &index_end, size_t &n_vertices, int &edge_walk,
                        std::vector<int> &midpoint, std::vector<int> &start, std::vector<int> &end, std::vector<float> &vertices);
-    void subdivide(size_t &n_vertices, size_t &n_edges, size_t &n_faces, std::vector<float> &vertices,
+    static void subdivide(size_t &n_vertices, size_t &n_edges, size_t &n_faces, std::vector<float> &vertices,
                    std::vector<int> &faces);
 
+    /**
+     * @brief render renders the current model as seen from the given camera pose
+     * @param camPose camera pose
+     * @param visibleSurfaceArea estimate of how much of the models surface area is visible
+     * @param color color image (only downloaded if readColor is true)
+     * @param readColor if false, skips downloading the color texture
+     * @return a depthmap
+     */
+    cv::Mat render(const Eigen::Matrix4f &camPose, float &visibleSurfaceArea, cv::Mat &color, bool readColor) const;
+
 public:
     /**
      * @brief DepthmapRenderer
@@ -125,7 +135,7 @@ public:
      * @param subdivisions there are 12 points by subdividing you add a lot more to them
      * @return vector of poses around a sphere
      */
-    std::vector<Eigen::Vector3f> createSphere(float r, size_t subdivisions);
+    static std::vector<Eigen::Vector3f> createSphere(float r, size_t subdivisions);
 
     /**
      * @brief setIntrinsics
@@ -196,6 +206,27 @@ public:
      * @return
      */
     pcl::PointCloud<pcl::PointXYZRGB> renderPointcloudColor(float &visibleSurfaceArea) const;
+
+    /**
+     * @brief depthmapToPointcloud back-projects a rendered depthmap into an organized point cloud
+     * @param depthmap depthmap (0 for pixels without geometry)
+     * @param fxycxy camera intrinsics (fx, fy, cx, cy)
+     * @param pose camera pose used for rendering (stored as sensor origin and orientation)
+     * @param cloud (output) point cloud
+     */
+    static void depthmapToPointcloud(const cv::Mat &depthmap, const Eigen::Vector4f &fxycxy, const Eigen::Matrix4f &pose,
+                                     pcl::PointCloud<pcl::PointXYZ> &cloud);
+
+    /**
+     * @brief depthmapToPointcloudColor back-projects a rendered depthmap and color image into an organized point cloud
+     * @param depthmap depthmap (0 for pixels without geometry)
+     * @param color color image as returned by renderDepthmap
+     * @param fxycxy camera intrinsics (fx, fy, cx, cy)
+     * @param pose camera pose used for rendering (stored as sensor origin and orientation)
+     * @param cloud (output) point cloud
+     */
+    static void depthmapToPointcloudColor(const cv::Mat &depthmap, const cv::Mat &color, const Eigen::Vector4f &fxycxy,
+                                          const Eigen::Matrix4f &pose, pcl::PointCloud<pcl::PointXYZRGB> &cloud);
 };
 }
 
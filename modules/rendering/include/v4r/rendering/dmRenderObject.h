@@ -41,6 +41,8 @@
 
 #include <pcl/PolygonMesh.h>
 
+#include <vector>
+
 
 
 namespace v4r{
@@ -140,6 +142,15 @@ public:
      */
     Eigen::Vector3f getOffset();
 
+    /**
+     * @brief getGeometry
+     *        copies the (shifted and scaled) geometry for rendering without OpenGL
+     * @param positions vertex positions
+     * @param colors vertex colors packed as RGBA bytes (in this order in memory)
+     * @param indices vertex indices (three per triangle)
+     */
+    void getGeometry(std::vector<Eigen::Vector3f> &positions, std::vector<uint32_t> &colors, std::vector<uint32_t> &indices) const;
+
 };
 
 }
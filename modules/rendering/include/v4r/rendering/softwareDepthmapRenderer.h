@@ -0,0 +1,184 @@
+/******************************************************************************
+ * Copyright (c) 2017, Vision4Robotics group, TU Vienna
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ ******************************************************************************/
+
+/**
+*
+*      @brief CPU (software rasterizer) backend of the depth map renderer
+*/
+
+#ifndef __V4R_SOFTWARE_DEPTHMAP_RENDERER__
+#define __V4R_SOFTWARE_DEPTHMAP_RENDERER__
+
+#include <opencv2/opencv.hpp>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <eigen3/Eigen/Eigen>
+#include <v4r/core/macros.h>
+#include "dmRenderObject.h"
+
+#include <vector>
+
+namespace v4r{
+
+/**
+ * @brief The SoftwareDepthmapRenderer class
+ * renders a depth map from a model just like DepthmapRenderer but without OpenGL, i.e. it does not
+ * need a display or GPU (e.g. on headless servers). The image is split into tiles which are rasterized
+ * in parallel into a z-buffer (same projection, clipping planes and pixel conventions as DepthmapRenderer).
+ * The render functions do not modify the renderer and can be called from several threads at once.
+ * Note: the visible surface area is computed from the projected (perspective divided) pixel area of each
+ * triangle, whereas DepthmapRenderer uses clip-space coordinates, so the estimates of both backends differ.
+ */
+class V4R_EXPORTS SoftwareDepthmapRenderer{
+private:
+
+    //hide the default constructor
+    SoftwareDepthmapRenderer();
+
+    //geometry of the current model
+    std::vector<Eigen::Vector3f> positions;
+    std::vector<uint32_t> colors;
+    std::vector<uint32_t> indices;
+
+    //camera intrinsics:
+    Eigen::Vector4f fxycxy;
+    Eigen::Vector2i res;
+
+    //Stores the camera pose:
+    Eigen::Matrix4f pose;
+
+    //edge length of the square image tiles which are rasterized in parallel
+    int tileSize;
+
+    /**
+     * @brief render rasterizes the model as seen from the given camera pose
+     * @param camPose camera pose
+     * @param visibleSurfaceArea estimate of how much of the models surface area is visible (0 for a model without area)
+     * @param color color image (same channel layout as DepthmapRenderer)
+     * @param parallel if true, rasterizes the image tiles in parallel
+     * @return a depthmap
+     */
+    cv::Mat render(const Eigen::Matrix4f &camPose, float &visibleSurfaceArea, cv::Mat &color, bool parallel) const;
+
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    /**
+     * @brief SoftwareDepthmapRenderer
+     * @param resx the resolution has to be fixed at the beginning of the program
+     * @param resy
+     */
+    SoftwareDepthmapRenderer(int resx,int resy);
+
+    /**
+     * @brief createSphere (see DepthmapRenderer::createSphere)
+     * @param r radius
+     * @param subdivisions there are 12 points by subdividing you add a lot more to them
+     * @return vector of poses around a sphere
+     */
+    static std::vector<Eigen::Vector3f> createSphere(float r, size_t subdivisions);
+
+    /**
+     * @brief setIntrinsics
+     * @param fx focal length
+     * @param fy
+     * @param cx center of projection
+     * @param cy
+     */
+    void setIntrinsics(float fx,float fy,float cx,float cy);
+
+    /**
+     * @brief setModel copies the geometry of the model (i.e. the model does not need to outlive this call)
+     * @param model
+     */
+    void setModel(const DepthmapRendererModel* _model);
+
+    /**
+     * @brief getPoseLookingToCenterFrom (see DepthmapRenderer::getPoseLookingToCenterFrom)
+     * @param position
+     * @return
+     */
+    static Eigen::Matrix4f getPoseLookingToCenterFrom(Eigen::Vector3f position);
+
+    /**
+     * @brief setCamPose
+     * @param pose
+     * A 4x4 Matrix giving the pose
+     */
+    void setCamPose(Eigen::Matrix4f _pose);
+
+    /**
+     * @brief setTileSize
+     * @param size edge length in pixel of the image tiles which are rasterized in parallel
+     */
+    void setTileSize(int size);
+
+    /**
+     * @brief renderDepthmap
+     * @param visibleSurfaceArea: Returns an estimate of how much of the models surface area
+     *        is visible. (Value between 0 and 1)
+     * @param color: if the geometry contains color information this cv::Mat will contain
+     *        a color image (same channel layout as DepthmapRenderer) after calling this method. (otherwise it will be plain black)
+     * @return a depthmap
+     */
+    cv::Mat renderDepthmap(float &visibleSurfaceArea, cv::Mat &color) const;
+
+    /**
+     * @brief renderPointcloud
+     * @param visibleSurfaceArea: Returns an estimate of how much of the models surface area
+     *        is visible.
+     * @return
+     */
+    pcl::PointCloud<pcl::PointXYZ> renderPointcloud(float &visibleSurfaceArea) const;
+
+    /**
+     * @brief renderPointcloudColor
+     * @param visibleSurfaceArea: Returns an estimate of how much of the models surface area
+     *        is visible.
+     * @return
+     */
+    pcl::PointCloud<pcl::PointXYZRGB> renderPointcloudColor(float &visibleSurfaceArea) const;
+
+    /**
+     * @brief renderPointclouds renders the model from several camera poses in one call (in parallel)
+     * @param poses camera poses
+     * @param visibleSurfaceAreas (output) estimate of how much of the models surface area is visible for each pose
+     * @return organized point cloud for each pose
+     */
+    std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> renderPointclouds(const std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > &poses,
+                                                                        std::vector<float> &visibleSurfaceAreas) const;
+
+    /**
+     * @brief renderPointcloudsColor renders the colored model from several camera poses in one call (in parallel)
+     * @param poses camera poses
+     * @param visibleSurfaceAreas (output) estimate of how much of the models surface area is visible for each pose
+     * @return organized colored point cloud for each pose
+     */
+    std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> renderPointcloudsColor(const std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > &poses,
+                                                                               std::vector<float> &visibleSurfaceAreas) const;
+};
+}
+
+
+#endif /* defined(__V4R_SOFTWARE_DEPTHMAP_RENDERER__) */
@@ -568,7 +568,7 @@ void DepthmapRenderer::setCamPose(Eigen::Matrix4f _pose)
 
 
 
-cv::Mat DepthmapRenderer::renderDepthmap(float &visible,cv::Mat &color) const
+cv::Mat DepthmapRenderer::render(const Eigen::Matrix4f &camPose, float &visible, cv::Mat &color, bool readColor) const
 {
     //load shader:
     glUseProgram(shaderProgram);
@@ -603,7 +603,7 @@ cv::Mat DepthmapRenderer::renderDepthmap(float &visible,cv::Mat &color) const
     proj=proj2*proj1;
     Matrix4f _proj=proj.inverse();
     //set the uniforms
-    glUniformMatrix4fv(poseUniform,1,GL_FALSE,(float*)&pose);//TODO: set this to GL_TRUE (BECAUSE TRANSPOSE !!!! THATS WHY)
+    glUniformMatrix4fv(poseUniform,1,GL_FALSE,camPose.data());//TODO: set this to GL_TRUE (BECAUSE TRANSPOSE !!!! THATS WHY)
     glUniformMatrix4fv(projectionUniform,1,GL_FALSE,(float*)&proj);
     glUniformMatrix4fv(_projectionUniform,1,GL_FALSE,(float*)&_proj);
     //glUniform4f(projectionUniform,fxycxy[0]/(float)res[0],fxycxy[1]/(float)res[1],fxycxy[2]/(float)res[0],fxycxy[3]/(float)res[1]);
@@ -678,11 +678,13 @@ cv::Mat DepthmapRenderer::renderDepthmap(float &visible,cv::Mat &color) const
     glGetBufferSubData(GL_ARRAY_BUFFER,0,sizeof(glm::vec2)*faceCount,faceSurfaceArea);
 
     //GET COLOR TEXTURE
-    cv::Mat colorMat(res[1],res[0],CV_8UC4);
-    glBindTexture(GL_TEXTURE_2D,colorTex);
-    glGetTexImage(GL_TEXTURE_2D,0,GL_RGBA,GL_UNSIGNED_BYTE,colorMat.data);
-    //imshow("colorMat",colorMat);
-    color=colorMat;
+    if(readColor){
+        cv::Mat colorMat(res[1],res[0],CV_8UC4);
+        glBindTexture(GL_TEXTURE_2D,colorTex);
+        glGetTexImage(GL_TEXTURE_2D,0,GL_RGBA,GL_UNSIGNED_BYTE,colorMat.data);
+        //imshow("colorMat",colorMat);
+        color=colorMat;
+    }
 
     //get pixel count for every triangle
     int* facePixelCount=new int[faceCount]();//hopefully initzialized with zero
@@ -719,12 +721,35 @@ cv::Mat DepthmapRenderer::renderDepthmap(float &visible,cv::Mat &color) const
     return depthmap;
 }
 
+cv::Mat DepthmapRenderer::renderDepthmap(float &visible,cv::Mat &color) const
+{
+    return render(pose,visible,color,true);
+}
+
 pcl::PointCloud<pcl::PointXYZ> DepthmapRenderer::renderPointcloud(float &visibleSurfaceArea) const
 {
-    const float bad_point = std::numeric_limits<float>::quiet_NaN();
+    cv::Mat color;
+    cv::Mat depth=render(pose,visibleSurfaceArea,color,false);
     pcl::PointCloud<pcl::PointXYZ> cloud;
-    cloud.width    = res[0];
-    cloud.height   = res[1];
+    depthmapToPointcloud(depth,fxycxy,pose,cloud);
+    return cloud;
+}
+
+pcl::PointCloud<pcl::PointXYZRGB> DepthmapRenderer::renderPointcloudColor(float &visibleSurfaceArea) const
+{
+    cv::Mat color;
+    cv::Mat depth=render(pose,visibleSurfaceArea,color,true);
+    pcl::PointCloud<pcl::PointXYZRGB> cloud;
+    depthmapToPointcloudColor(depth,color,fxycxy,pose,cloud);
+    return cloud;
+}
+
+void DepthmapRenderer::depthmapToPointcloud(const cv::Mat &depthmap, const Eigen::Vector4f &fxycxy, const Eigen::Matrix4f &pose,
+                                            pcl::PointCloud<pcl::PointXYZ> &cloud)
+{
+    const float bad_point = std::numeric_limits<float>::quiet_NaN();
+    cloud.width    = depthmap.cols;
+    cloud.height   = depthmap.rows;
     cloud.is_dense = false;
     cloud.points.resize (cloud.width * cloud.height);
 
@@ -733,11 +758,9 @@ pcl::PointCloud<pcl::PointXYZ> DepthmapRenderer::renderPointcloud(float &visible
     Eigen::Vector3f trans = Eigen::Matrix3f(pose.block(0,0,3,3)).transpose()*Eigen::Vector3f(pose(0,3),pose(1,3),pose(2,3));
     cloud.sensor_origin_ = Eigen::Vector4f(-trans(0),-trans(1),-trans(2),1.0f);
 
-    cv::Mat color;
-    cv::Mat depth=renderDepthmap(visibleSurfaceArea,color);
     for(size_t k=0;k<cloud.height;k++){
         for(size_t j=0;j<cloud.width;j++){
-            float d=depth.at<float>(k,j);
+            float d=depthmap.at<float>(k,j);
             if(d==0){
                 cloud.at(j,k)=pcl::PointXYZ(bad_point,bad_point,bad_point);
             }
@@ -751,17 +774,14 @@ pcl::PointCloud<pcl::PointXYZ> DepthmapRenderer::renderPointcloud(float &visible
             }
         }
     }
-
-
-    return cloud;
 }
 
-pcl::PointCloud<pcl::PointXYZRGB> DepthmapRenderer::renderPointcloudColor(float &visibleSurfaceArea) const
+void DepthmapRenderer::depthmapToPointcloudColor(const cv::Mat &depthmap, const cv::Mat &color, const Eigen::Vector4f &fxycxy,
+                                                 const Eigen::Matrix4f &pose, pcl::PointCloud<pcl::PointXYZRGB> &cloud)
 {
     const float bad_point = std::numeric_limits<float>::quiet_NaN();
-    pcl::PointCloud<pcl::PointXYZRGB> cloud;
-    cloud.width    = res[0];
-    cloud.height   = res[1];
+    cloud.width    = depthmap.cols;
+    cloud.height   = depthmap.rows;
     cloud.is_dense = false;
     cloud.points.resize (cloud.width * cloud.height);
 
@@ -770,8 +790,6 @@ pcl::PointCloud<pcl::PointXYZRGB> DepthmapRenderer::renderPointcloudColor(float
     Eigen::Vector3f trans = Eigen::Matrix3f(pose.block(0,0,3,3)).transpose()*Eigen::Vector3f(pose(0,3),pose(1,3),pose(2,3));
     cloud.sensor_origin_ = Eigen::Vector4f(-trans(0),-trans(1),-trans(2),1.0f);
 
-    cv::Mat color;
-    const cv::Mat depth = renderDepthmap(visibleSurfaceArea,color);
     std::vector<cv::Mat> color_channels(3);
     cv::split(color, color_channels);
     cv::Mat b, g, r;
@@ -781,7 +799,7 @@ pcl::PointCloud<pcl::PointXYZRGB> DepthmapRenderer::renderPointcloudColor(float
 
     for(size_t k=0;k<cloud.height;k++){
         for(size_t j=0;j<cloud.width;j++){
-            float d=depth.at<float>(k,j);
+            float d=depthmap.at<float>(k,j);
             if(d==0){
                 cloud.at(j,k).x=bad_point;
                 cloud.at(j,k).y=bad_point;
@@ -800,8 +818,6 @@ pcl::PointCloud<pcl::PointXYZRGB> DepthmapRenderer::renderPointcloudColor(float
 
         }
     }
-
-    return cloud;
 }
 
 }
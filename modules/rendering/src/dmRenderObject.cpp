@@ -284,4 +284,15 @@ Eigen::Vector3f DepthmapRendererModel::getOffset(){
     return offset;
 }
 
+void DepthmapRendererModel::getGeometry(std::vector<Eigen::Vector3f> &positions, std::vector<uint32_t> &colors, std::vector<uint32_t> &indices) const
+{
+    positions.resize(vertexCount);
+    colors.resize(vertexCount);
+    for(uint32_t i=0;i<vertexCount;i++){
+        positions[i]=Eigen::Vector3f(vertices[i].pos.x,vertices[i].pos.y,vertices[i].pos.z);
+        memcpy(&colors[i],&vertices[i].rgba,sizeof(uint32_t));
+    }
+    indices.assign(this->indices,this->indices+indexCount);
+}
+
 }
@@ -0,0 +1,384 @@
+#include <v4r/rendering/softwareDepthmapRenderer.h>
+#include <v4r/rendering/depthmapRenderer.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace v4r
+{
+
+namespace
+{
+//same clipping planes as DepthmapRenderer
+const float zNear=0.1f;
+const float zFar=30.0f;
+
+//vertices are snapped to 1/256 pixel and the edge functions are evaluated exactly in fixed point
+const int subPixelBits=8;
+const float subPixelScale=float(1<<subPixelBits);
+const int64_t subPixelStep=1<<subPixelBits;
+
+//triangles reaching further out of the image are dropped (keeps the fixed point edge functions within 64 bit)
+const float guardBand=float(1<<21);
+
+struct ClipVertex{
+    Eigen::Vector3f p;//position in camera coordinates
+    float c[4];//color
+};
+
+struct ScreenTriangle{
+    int64_t x[3],y[3];//fixed point pixel coordinates
+    float invZ[3];//inverse depth of each vertex
+    float cOverZ[3][4];//color divided by depth of each vertex
+    int64_t area2;//twice the fixed point area (always positive)
+    int minX,maxX,minY,maxY;//covered pixels (clipped to the image)
+    uint32_t index;//index of the original triangle + 1
+};
+
+/**
+ * @brief clips a triangle against the near plane
+ * @return number of vertices of the resulting convex polygon (0, 3 or 4)
+ */
+int clipNear(const ClipVertex in[3], ClipVertex out[4])
+{
+    int n=0;
+    for(int i=0;i<3;i++){
+        const ClipVertex &a=in[i];
+        const ClipVertex &b=in[(i+1)%3];
+        bool aIn=a.p[2]>=zNear;
+        bool bIn=b.p[2]>=zNear;
+        if(aIn){
+            out[n++]=a;
+        }
+        if(aIn!=bIn){
+            float t=(zNear-a.p[2])/(b.p[2]-a.p[2]);
+            ClipVertex &v=out[n++];
+            v.p=a.p+t*(b.p-a.p);
+            v.p[2]=zNear;
+            for(int c=0;c<4;c++){
+                v.c[c]=a.c[c]+t*(b.c[c]-a.c[c]);
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief projects a (near clipped) triangle into the image
+ * @return false if the triangle does not cover any pixel center
+ */
+bool setupTriangle(const ClipVertex &v0, const ClipVertex &v1, const ClipVertex &v2,
+                   const Eigen::Vector4f &fxycxy, const Eigen::Vector2i &res, ScreenTriangle &tri)
+{
+    const ClipVertex *v[3]={&v0,&v1,&v2};
+    float fx[3],fy[3];
+    for(int i=0;i<3;i++){
+        const Eigen::Vector3f &p=v[i]->p;
+        fx[i]=fxycxy[0]*p[0]/p[2]+fxycxy[2];
+        fy[i]=fxycxy[1]*p[1]/p[2]+fxycxy[3];
+        if(!(std::abs(fx[i])<guardBand && std::abs(fy[i])<guardBand)){
+            return false;
+        }
+        tri.x[i]=(int64_t)std::floor(fx[i]*subPixelScale+0.5f);
+        tri.y[i]=(int64_t)std::floor(fy[i]*subPixelScale+0.5f);
+    }
+
+    tri.area2=(tri.x[1]-tri.x[0])*(tri.y[2]-tri.y[0])-(tri.y[1]-tri.y[0])*(tri.x[2]-tri.x[0]);
+    if(tri.area2==0){
+        return false;
+    }
+
+    int order[3]={0,1,2};
+    if(tri.area2<0){
+        //bring all triangles into the same winding order (there is no backface culling)
+        std::swap(order[1],order[2]);
+        std::swap(tri.x[1],tri.x[2]);
+        std::swap(tri.y[1],tri.y[2]);
+        std::swap(fx[1],fx[2]);
+        std::swap(fy[1],fy[2]);
+        tri.area2=-tri.area2;
+    }
+
+    for(int i=0;i<3;i++){
+        const ClipVertex &vi=*v[order[i]];
+        tri.invZ[i]=1.0f/vi.p[2];
+        for(int c=0;c<4;c++){
+            tri.cOverZ[i][c]=vi.c[c]*tri.invZ[i];
+        }
+    }
+
+    //pixel centers are at integer coordinates
+    tri.minX=std::max(0,(int)std::ceil(std::min(fx[0],std::min(fx[1],fx[2]))));
+    tri.maxX=std::min(res[0]-1,(int)std::floor(std::max(fx[0],std::max(fx[1],fx[2]))));
+    tri.minY=std::max(0,(int)std::ceil(std::min(fy[0],std::min(fy[1],fy[2]))));
+    tri.maxY=std::min(res[1]-1,(int)std::floor(std::max(fy[0],std::max(fy[1],fy[2]))));
+    return tri.minX<=tri.maxX && tri.minY<=tri.maxY;
+}
+
+/**
+ * @brief rasterizes a triangle within the given pixel range (z-buffered)
+ */
+void rasterize(const ScreenTriangle &tri, int x0, int x1, int y0, int y1,
+               cv::Mat &depth, cv::Mat &color, cv::Mat &index)
+{
+    x0=std::max(x0,tri.minX);
+    x1=std::min(x1,tri.maxX);
+    y0=std::max(y0,tri.minY);
+    y1=std::min(y1,tri.maxY);
+    if(x0>x1 || y0>y1){
+        return;
+    }
+
+    //edge i is opposite to vertex i, its edge function is the (unnormalized) barycentric weight of vertex i
+    int64_t dx[3],dy[3],bias[3],rowE[3];
+    const int64_t px=(int64_t)x0*subPixelStep;
+    const int64_t py=(int64_t)y0*subPixelStep;
+    for(int i=0;i<3;i++){
+        const int a=(i+1)%3;
+        const int b=(i+2)%3;
+        dx[i]=tri.x[b]-tri.x[a];
+        dy[i]=tri.y[b]-tri.y[a];
+        rowE[i]=dx[i]*(py-tri.y[a])-dy[i]*(px-tri.x[a]);
+        //pixels exactly on an edge shared by two triangles are assigned to only one of them
+        bias[i]=(dy[i]<0 || (dy[i]==0 && dx[i]>0)) ? 0 : -1;
+    }
+
+    const double invArea2=1.0/(double)tri.area2;
+    for(int k=y0;k<=y1;k++){
+        float *depthRow=depth.ptr<float>(k);
+        cv::Vec4b *colorRow=color.ptr<cv::Vec4b>(k);
+        int *indexRow=index.ptr<int>(k);
+
+        int64_t e[3]={rowE[0],rowE[1],rowE[2]};
+        for(int j=x0;j<=x1;j++){
+            if(e[0]+bias[0]>=0 && e[1]+bias[1]>=0 && e[2]+bias[2]>=0){
+                const float l0=(float)(e[0]*invArea2);
+                const float l1=(float)(e[1]*invArea2);
+                const float l2=(float)(e[2]*invArea2);
+                const float invZ=l0*tri.invZ[0]+l1*tri.invZ[1]+l2*tri.invZ[2];
+                const float z=1.0f/invZ;
+                if(z<=zFar && (depthRow[j]==0 || z<depthRow[j])){
+                    depthRow[j]=z;
+                    indexRow[j]=(int)tri.index;
+                    for(int c=0;c<4;c++){
+                        float val=(l0*tri.cOverZ[0][c]+l1*tri.cOverZ[1][c]+l2*tri.cOverZ[2][c])*z;
+                        colorRow[j][c]=(unsigned char)std::min(255.0f,std::max(0.0f,val+0.5f));
+                    }
+                }
+            }
+            for(int i=0;i<3;i++){
+                e[i]-=dy[i]*subPixelStep;
+            }
+        }
+        for(int i=0;i<3;i++){
+            rowE[i]+=dx[i]*subPixelStep;
+        }
+    }
+}
+}
+
+
+SoftwareDepthmapRenderer::SoftwareDepthmapRenderer(int resx, int resy)
+    : fxycxy(Eigen::Vector4f::Zero()),
+      res(resx,resy),
+      pose(Eigen::Matrix4f::Identity()),
+      tileSize(64)
+{
+}
+
+std::vector<Eigen::Vector3f> SoftwareDepthmapRenderer::createSphere(float r, size_t subdivisions)
+{
+    return DepthmapRenderer::createSphere(r,subdivisions);
+}
+
+void SoftwareDepthmapRenderer::setIntrinsics(float fx, float fy, float cx, float cy)
+{
+    fxycxy=Eigen::Vector4f(fx,fy,cx,cy);
+}
+
+void SoftwareDepthmapRenderer::setModel(const DepthmapRendererModel *_model)
+{
+    _model->getGeometry(positions,colors,indices);
+}
+
+Eigen::Matrix4f SoftwareDepthmapRenderer::getPoseLookingToCenterFrom(Eigen::Vector3f position)
+{
+    return DepthmapRenderer::getPoseLookingToCenterFrom(position);
+}
+
+void SoftwareDepthmapRenderer::setCamPose(Eigen::Matrix4f _pose)
+{
+    this->pose=_pose;
+}
+
+void SoftwareDepthmapRenderer::setTileSize(int size)
+{
+    tileSize=std::max(1,size);
+}
+
+cv::Mat SoftwareDepthmapRenderer::render(const Eigen::Matrix4f &camPose, float &visibleSurfaceArea, cv::Mat &color, bool parallel) const
+{
+    const int faceCount=(int)(indices.size()/3);
+
+    //transform vertices into the camera frame
+    std::vector<Eigen::Vector3f> transformed(positions.size());
+    const Eigen::Matrix3f R=camPose.block<3,3>(0,0);
+    const Eigen::Vector3f t=camPose.block<3,1>(0,3);
+    #pragma omp parallel for schedule(static) if(parallel)
+    for(int i=0;i<(int)positions.size();i++){
+        transformed[i]=R*positions[i]+t;
+    }
+
+    //clip and project triangles. The faces are processed in contiguous chunks so that concatenating
+    //the chunks keeps the drawing order (the first of two triangles with equal depth wins, as in OpenGL)
+    const int numChunks=std::min(faceCount,64);
+    std::vector<std::vector<ScreenTriangle> > chunks(numChunks);
+    std::vector<float> faceArea(faceCount,0.0f);//surface area of each triangle
+    std::vector<float> facePixelArea(faceCount,0.0f);//number of pixels each triangle would have if it weren't occluded
+    #pragma omp parallel for schedule(dynamic) if(parallel)
+    for(int chunk=0;chunk<numChunks;chunk++){
+        const int fBegin=(int)((int64_t)faceCount*chunk/numChunks);
+        const int fEnd=(int)((int64_t)faceCount*(chunk+1)/numChunks);
+        for(int f=fBegin;f<fEnd;f++){
+            ClipVertex in[3];
+            for(int i=0;i<3;i++){
+                const uint32_t vi=indices[3*f+i];
+                in[i].p=transformed[vi];
+                const unsigned char *rgba=reinterpret_cast<const unsigned char*>(&colors[vi]);
+                for(int c=0;c<4;c++){
+                    in[i].c[c]=rgba[c];
+                }
+            }
+            faceArea[f]=((in[0].p-in[2].p).cross(in[1].p-in[2].p)).norm()*0.5f;
+
+            ClipVertex out[4];
+            const int n=clipNear(in,out);
+            for(int i=1;i+1<n;i++){
+                ScreenTriangle tri;
+                if(setupTriangle(out[0],out[i],out[i+1],fxycxy,res,tri)){
+                    tri.index=f+1;
+                    facePixelArea[f]+=(float)tri.area2/(2.0f*subPixelScale*subPixelScale);
+                    chunks[chunk].push_back(tri);
+                }
+            }
+        }
+    }
+
+    std::vector<ScreenTriangle> triangles;
+    for(const std::vector<ScreenTriangle> &chunk : chunks){
+        triangles.insert(triangles.end(),chunk.begin(),chunk.end());
+    }
+
+    //sort the triangles into image tiles (keeping the drawing order)
+    const int tilesX=(res[0]+tileSize-1)/tileSize;
+    const int tilesY=(res[1]+tileSize-1)/tileSize;
+    std::vector<std::vector<int> > tiles(tilesX*tilesY);
+    for(int triId=0;triId<(int)triangles.size();triId++){
+        const ScreenTriangle &tri=triangles[triId];
+        for(int ty=tri.minY/tileSize;ty<=tri.maxY/tileSize;ty++){
+            for(int tx=tri.minX/tileSize;tx<=tri.maxX/tileSize;tx++){
+                tiles[ty*tilesX+tx].push_back(triId);
+            }
+        }
+    }
+
+    cv::Mat depthmap=cv::Mat::zeros(res[1],res[0],CV_32FC1);
+    cv::Mat indexMap=cv::Mat::zeros(res[1],res[0],CV_32SC1);
+    cv::Mat colorMat(res[1],res[0],CV_8UC4,cv::Scalar(0,0,0,255));
+
+    #pragma omp parallel for schedule(dynamic) if(parallel)
+    for(int tile=0;tile<(int)tiles.size();tile++){
+        const int x0=(tile%tilesX)*tileSize;
+        const int y0=(tile/tilesX)*tileSize;
+        const int x1=std::min(x0+tileSize,res[0])-1;
+        const int y1=std::min(y0+tileSize,res[1])-1;
+        for(int triId : tiles[tile]){
+            rasterize(triangles[triId],x0,x1,y0,y1,depthmap,colorMat,indexMap);
+        }
+    }
+    color=colorMat;
+
+    //get pixel count for every triangle
+    std::vector<int> facePixelCount(faceCount,0);
+    for(int u=0;u<indexMap.rows;u++){
+        const int *indexRow=indexMap.ptr<int>(u);
+        for(int v=0;v<indexMap.cols;v++){
+            if(indexRow[v]!=0){
+                facePixelCount[indexRow[v]-1]++;
+            }
+        }
+    }
+
+    //Sum up the full surface area and the visible surface area
+    float visibleArea=0;
+    float fullArea=0;
+    for(int f=0;f<faceCount;f++){
+        fullArea+=faceArea[f];
+        if(facePixelArea[f]!=0){
+            visibleArea+=faceArea[f]*float(facePixelCount[f])/facePixelArea[f];
+        }
+    }
+    visibleSurfaceArea=fullArea>0 ? visibleArea/fullArea : 0.0f;
+
+    return depthmap;
+}
+
+cv::Mat SoftwareDepthmapRenderer::renderDepthmap(float &visibleSurfaceArea, cv::Mat &color) const
+{
+    return render(pose,visibleSurfaceArea,color,true);
+}
+
+pcl::PointCloud<pcl::PointXYZ> SoftwareDepthmapRenderer::renderPointcloud(float &visibleSurfaceArea) const
+{
+    cv::Mat color;
+    const cv::Mat depth = render(pose,visibleSurfaceArea,color,true);
+    pcl::PointCloud<pcl::PointXYZ> cloud;
+    DepthmapRenderer::depthmapToPointcloud(depth,fxycxy,pose,cloud);
+    return cloud;
+}
+
+pcl::PointCloud<pcl::PointXYZRGB> SoftwareDepthmapRenderer::renderPointcloudColor(float &visibleSurfaceArea) const
+{
+    cv::Mat color;
+    const cv::Mat depth = render(pose,visibleSurfaceArea,color,true);
+    pcl::PointCloud<pcl::PointXYZRGB> cloud;
+    DepthmapRenderer::depthmapToPointcloudColor(depth,color,fxycxy,pose,cloud);
+    return cloud;
+}
+
+std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> SoftwareDepthmapRenderer::renderPointclouds(const std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > &poses,
+                                                                                              std::vector<float> &visibleSurfaceAreas) const
+{
+    std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> clouds(poses.size());
+    visibleSurfaceAreas.resize(poses.size());
+
+    //views are rendered in parallel, a single view is split into tiles instead
+    const bool parallelViews=poses.size()>1;
+    #pragma omp parallel for schedule(dynamic) if(parallelViews)
+    for(int i=0;i<(int)poses.size();i++){
+        cv::Mat color;
+        const cv::Mat depth=render(poses[i],visibleSurfaceAreas[i],color,!parallelViews);
+        clouds[i].reset(new pcl::PointCloud<pcl::PointXYZ>);
+        DepthmapRenderer::depthmapToPointcloud(depth,fxycxy,poses[i],*clouds[i]);
+    }
+    return clouds;
+}
+
+std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> SoftwareDepthmapRenderer::renderPointcloudsColor(const std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > &poses,
+                                                                                                     std::vector<float> &visibleSurfaceAreas) const
+{
+    std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> clouds(poses.size());
+    visibleSurfaceAreas.resize(poses.size());
+
+    const bool parallelViews=poses.size()>1;
+    #pragma omp parallel for schedule(dynamic) if(parallelViews)
+    for(int i=0;i<(int)poses.size();i++){
+        cv::Mat color;
+        const cv::Mat depth=render(poses[i],visibleSurfaceAreas[i],color,!parallelViews);
+        clouds[i].reset(new pcl::PointCloud<pcl::PointXYZRGB>);
+        DepthmapRenderer::depthmapToPointcloudColor(depth,color,fxycxy,poses[i],*clouds[i]);
+    }
+    return clouds;
+}
+
+}
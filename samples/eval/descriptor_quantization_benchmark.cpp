@@ -0,0 +1,220 @@
+#include <v4r/common/quantized_descriptors.h>
+#include <v4r/io/filesystem.h>
+
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/program_options.hpp>
+#include <boost/serialization/vector.hpp>
+#include <flann/flann.hpp>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+namespace po = boost::program_options;
+namespace bf = boost::filesystem;
+
+namespace
+{
+typedef std::chrono::steady_clock Clock;
+
+double
+elapsedMs(const Clock::time_point &start)
+{
+    return std::chrono::duration<double, std::milli>( Clock::now() - start ).count();
+}
+
+/**
+ * @brief runs the knn search of all queries and returns the time in ms
+ */
+template<typename Distance>
+double
+search(flann::Index<Distance> &index, const flann::Matrix<typename Distance::ElementType> &queries, size_t knn, int checks, std::vector<int> &nn)
+{
+    flann::Matrix<int> indices (new int[queries.rows * knn], queries.rows, knn);
+    flann::Matrix<float> distances (new float[queries.rows * knn], queries.rows, knn);
+
+    const Clock::time_point start = Clock::now();
+    index.knnSearch( queries, indices, distances, knn, flann::SearchParams(checks) );
+    const double ms = elapsedMs(start);
+
+    nn.resize( queries.rows );
+    for(size_t i=0; i<queries.rows; i++)
+        nn[i] = indices[i][0];
+
+    delete[] indices.ptr();
+    delete[] distances.ptr();
+    return ms;
+}
+
+double
+recall(const std::vector<int> &nn, const std::vector<int> &ground_truth)
+{
+    size_t correct = 0;
+    for(size_t i=0; i<nn.size(); i++)
+        correct += nn[i] == ground_truth[i];
+    return nn.empty() ? 0. : static_cast<double>(correct) / nn.size();
+}
+
+template<typename FloatDistance, typename QuantizedDistance>
+void
+benchmark(const std::vector<float> &database, const std::vector<float> &queries, size_t cols, size_t knn, int trees, int checks)
+{
+    const size_t rows = database.size() / cols;
+    const size_t num_queries = queries.size() / cols;
+
+    flann::Matrix<float> data ( const_cast<float*>( database.data() ), rows, cols );
+    flann::Matrix<float> query ( const_cast<float*>( queries.data() ), num_queries, cols );
+
+    v4r::DescriptorQuantizer quantizer;
+    quantizer.compute( database.data(), rows, cols );
+    std::vector<unsigned char> database_quantized ( database.size() ), queries_quantized ( queries.size() );
+    quantizer.quantize( database.data(), rows, database_quantized.data() );
+    quantizer.quantize( queries.data(), num_queries, queries_quantized.data() );
+    flann::Matrix<unsigned char> data_quantized ( database_quantized.data(), rows, cols );
+    flann::Matrix<unsigned char> query_quantized ( queries_quantized.data(), num_queries, cols );
+
+    std::vector<int> ground_truth, nn;
+
+    flann::Index<FloatDistance> linear ( data, flann::LinearIndexParams() );
+    linear.buildIndex();
+    double ms = search( linear, query, knn, checks, ground_truth );
+    std::cout << "float linear:       " << ms << " ms (ground truth)" << std::endl;
+
+    flann::Index<QuantizedDistance> linear_quantized ( data_quantized, flann::LinearIndexParams(), QuantizedDistance(quantizer) );
+    linear_quantized.buildIndex();
+    ms = search( linear_quantized, query_quantized, knn, checks, nn );
+    std::cout << "quantized linear:   " << ms << " ms, recall@1 " << recall(nn, ground_truth) << std::endl;
+
+    Clock::time_point start = Clock::now();
+    flann::Index<FloatDistance> kdtree ( data, flann::KDTreeIndexParams(trees) );
+    kdtree.buildIndex();
+    const double build_ms = elapsedMs(start);
+    ms = search( kdtree, query, knn, checks, nn );
+    std::cout << "float kdtree:       " << ms << " ms, recall@1 " << recall(nn, ground_truth) << " (build " << build_ms << " ms, data " << rows * cols * sizeof(float) / 1048576. << " MB)" << std::endl;
+
+    start = Clock::now();
+    flann::Index<QuantizedDistance> kdtree_quantized ( data_quantized, flann::KDTreeIndexParams(trees), QuantizedDistance(quantizer) );
+    kdtree_quantized.buildIndex();
+    const double build_quantized_ms = elapsedMs(start);
+    ms = search( kdtree_quantized, query_quantized, knn, checks, nn );
+    std::cout << "quantized kdtree:   " << ms << " ms, recall@1 " << recall(nn, ground_truth) << " (build " << build_quantized_ms << " ms, data " << rows * cols / 1048576. << " MB)" << std::endl;
+}
+}
+
+int
+main (int argc, char ** argv)
+{
+    std::string trained_dir;
+    std::string descriptor_name;
+    size_t num_queries = 1000;
+    size_t synthetic_rows = 100000;
+    size_t synthetic_cols = 128;
+    size_t knn = 1;
+    int distance_metric = 2;
+    int trees = 4;
+    int checks = 512;
+
+    po::options_description desc("Compares recall and speed of the nearest neighbor search on quantized (8 bit) and float descriptors\n======================================\n**Allowed options");
+    desc.add_options()
+            ("help,h", "produce help message")
+            ("trained_dir,t", po::value<std::string>(&trained_dir), "training directory of the local recognizer (all signatures.dat files in it are used). If not set, synthetic descriptors are used.")
+            ("descriptor,d", po::value<std::string>(&descriptor_name), "only use signature files of this descriptor (e.g. sift, shot)")
+            ("num_queries,q", po::value<size_t>(&num_queries)->default_value(num_queries), "number of descriptors taken out of the database and used as queries")
+            ("synthetic_rows", po::value<size_t>(&synthetic_rows)->default_value(synthetic_rows), "number of synthetic descriptors")
+            ("synthetic_cols", po::value<size_t>(&synthetic_cols)->default_value(synthetic_cols), "dimensionality of synthetic descriptors")
+            ("knn,k", po::value<size_t>(&knn)->default_value(knn), "number of nearest neighbors to search")
+            ("distance_metric", po::value<int>(&distance_metric)->default_value(distance_metric), "1... L1 norm, 2... L2 norm")
+            ("kdtree_num_trees", po::value<int>(&trees)->default_value(trees), "number of randomized kd-trees")
+            ("kdtree_splits", po::value<int>(&checks)->default_value(checks), "number of leafs checked during search")
+    ;
+    po::variables_map vm;
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help"))
+    {
+        std::cout << desc << std::endl;
+        return false;
+    }
+    try { po::notify(vm); }
+    catch(std::exception& e)
+    {
+        std::cerr << "Error: " << e.what() << std::endl << std::endl << desc << std::endl;
+        return false;
+    }
+
+    std::vector<float> descriptors;
+    size_t cols = 0;
+
+    if( !trained_dir.empty() )
+    {
+        const std::vector<std::string> files = v4r::io::getFilesInDirectory( trained_dir, "signatures\\.dat", true );
+        for(const std::string &f : files)
+        {
+            if( !descriptor_name.empty() && f.find(descriptor_name) == std::string::npos )
+                continue;
+
+            std::vector<std::vector<float> > signatures;
+            std::ifstream is( (bf::path(trained_dir) / f).string().c_str(), std::ios::binary );
+            boost::archive::binary_iarchive iar(is);
+            iar >> signatures;
+
+            for(const std::vector<float> &s : signatures)
+            {
+                if( !cols )
+                    cols = s.size();
+
+                if( s.size() != cols )
+                {
+                    std::cerr << "Signatures of different dimensionality in " << f << ". Use --descriptor to select one descriptor." << std::endl;
+                    return -1;
+                }
+                descriptors.insert( descriptors.end(), s.begin(), s.end() );
+            }
+        }
+    }
+    else
+    {
+        // clustered, non-negative descriptors (similar to SIFT)
+        std::mt19937 rng(0);
+        std::uniform_real_distribution<float> uniform(0.f, 0.2f);
+        std::normal_distribution<float> noise(0.f, 0.02f);
+        std::vector<float> centers( 1000 * synthetic_cols );
+        for(float &v : centers)
+            v = uniform(rng);
+
+        cols = synthetic_cols;
+        descriptors.resize( synthetic_rows * cols );
+        for(size_t r=0; r<synthetic_rows; r++)
+        {
+            const float *center = &centers[ (rng() % 1000) * cols ];
+            for(size_t c=0; c<cols; c++)
+                descriptors[r * cols + c] = std::max( 0.f, center[c] + noise(rng) );
+        }
+    }
+
+    if( !cols || descriptors.size() / cols <= num_queries )
+    {
+        std::cerr << "Not enough descriptors (" << (cols ? descriptors.size() / cols : 0) << ") for " << num_queries << " queries." << std::endl;
+        return -1;
+    }
+
+    // take random descriptors out of the database as queries
+    const size_t rows = descriptors.size() / cols;
+    std::mt19937 rng(1);
+    for(size_t i=0; i<num_queries; i++)
+    {
+        const size_t r = i + rng() % (rows - i);
+        std::swap_ranges( descriptors.begin() + i * cols, descriptors.begin() + (i+1) * cols, descriptors.begin() + r * cols );
+    }
+    const std::vector<float> queries ( descriptors.begin(), descriptors.begin() + num_queries * cols );
+    descriptors.erase( descriptors.begin(), descriptors.begin() + num_queries * cols );
+
+    std::cout << descriptors.size() / cols << " descriptors (" << cols << " dimensions), " << num_queries << " queries" << std::endl;
+
+    if( distance_metric == 2 )
+        benchmark<flann::L2<float>, v4r::QuantizedL2>( descriptors, queries, cols, knn, trees, checks );
+    else
+        benchmark<flann::L1<float>, v4r::QuantizedL1>( descriptors, queries, cols, knn, trees, checks );
+
+    return 0;
+}
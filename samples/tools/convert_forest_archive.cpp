@@ -0,0 +1,41 @@
+#include <iostream>
+#include <v4r/ml/flatforest.h>
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+int main(int argc, char** argv)
+{
+    std::string input_fn, output_fn;
+
+    po::options_description desc("Converter from a random forest stored as boost archive (Forest::SaveToFile) into the binary, memory-mappable forest format (FlatForest)\n======================================\n**Allowed options");
+    desc.add_options()
+            ("help,h", "produce help message")
+            ("input,i", po::value<std::string>(&input_fn)->required(), "forest file written by Forest::SaveToFile")
+            ("output,o", po::value<std::string>(&output_fn)->required(), "output file of the binary forest")
+    ;
+
+   po::variables_map vm;
+   po::store(po::parse_command_line(argc, argv, desc), vm);
+   if (vm.count("help"))
+   {
+       std::cout << desc << std::endl;
+       return false;
+   }
+
+   try  { po::notify(vm); }
+   catch(std::exception& e)
+   {
+       std::cerr << "Error: " << e.what() << std::endl << std::endl << desc << std::endl;
+       return false;
+   }
+
+   v4r::RandomForest::FlatForest::convertArchive(input_fn, output_fn);
+
+   // check if the written file can be loaded again
+   v4r::RandomForest::FlatForest forest(output_fn);
+   std::cout << "Converted forest with " << forest.getNumTrees() << " trees and " << forest.getLabels().size() << " labels into " << output_fn << std::endl;
+
+   return 0;
+}
@@ -8,6 +8,7 @@
   * and within this instance folder there is a "/view" folder with the rendered point clouds and their poses of this particular instance.
   */
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include <string>
@@ -24,6 +25,7 @@
 #include <v4r/io/eigen.h>
 #include <v4r/io/filesystem.h>
 #include <v4r/rendering/depthmapRenderer.h>
+#include <v4r/rendering/softwareDepthmapRenderer.h>
 
 #include <pcl/io/pcd_io.h>
 #include <pcl/point_types.h>
@@ -31,6 +33,7 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
+#include <boost/shared_ptr.hpp>
 #include <boost/program_options.hpp>
 #include <glog/logging.h>
 
@@ -82,6 +85,108 @@ save(const pcl::PointCloud<PointT> &cloud, const std::string &out_dir)
     LOG(INFO) << "Saved rendered cloud to " << out_cloud_fn << ".";
 }
 
+template <typename PointT>
+void
+saveView(pcl::PointCloud<PointT> &cloud, const std::string &out_path, bool gen_organized)
+{
+    if( !gen_organized )
+        removeNaNPoints(cloud);
+
+    if( cloud.points.empty())
+    {
+        std::cerr << "Rendered cloud does not contain any point! " << std::endl;
+        return;
+    }
+
+    save ( cloud, out_path );
+}
+
+typedef std::vector<Eigen::Matrix4f, Eigen::aligned_allocator<Eigen::Matrix4f> > PoseVector;
+
+// the software renderer renders the views of a batch in parallel
+void
+renderAndSaveViews(SoftwareDepthmapRenderer &renderer, const PoseVector &poses, bool color,
+                   const std::string &out_path, bool gen_organized, std::vector<float> &visible)
+{
+    if(color)
+    {
+        std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> clouds = renderer.renderPointcloudsColor(poses, visible);
+        for(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr &cloud : clouds)
+            saveView(*cloud, out_path, gen_organized);
+    }
+    else
+    {
+        std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> clouds = renderer.renderPointclouds(poses, visible);
+        for(const pcl::PointCloud<pcl::PointXYZ>::Ptr &cloud : clouds)
+            saveView(*cloud, out_path, gen_organized);
+    }
+}
+
+// OpenGL renders one view after the other in its single context
+void
+renderAndSaveViews(DepthmapRenderer &renderer, const PoseVector &poses, bool color,
+                   const std::string &out_path, bool gen_organized, std::vector<float> &visible)
+{
+    visible.resize(poses.size());
+    for(size_t i=0; i<poses.size(); i++)
+    {
+        renderer.setCamPose(poses[i]);
+        if(color)
+        {
+            pcl::PointCloud<pcl::PointXYZRGB> cloud = renderer.renderPointcloudColor(visible[i]);
+            saveView(cloud, out_path, gen_organized);
+        }
+        else
+        {
+            pcl::PointCloud<pcl::PointXYZ> cloud = renderer.renderPointcloud(visible[i]);
+            saveView(cloud, out_path, gen_organized);
+        }
+    }
+}
+
+template <typename RendererT>
+void
+renderModel(RendererT &renderer, DepthmapRendererModel &model, const std::vector<Eigen::Vector3f> &sphere,
+            const std::string &out_path, bool gen_organized, bool visualize, size_t batch_size)
+{
+    renderer.setModel(&model);
+
+    //get camera poses looking at the center:
+    PoseVector poses;
+    for(const Eigen::Vector3f &pt : sphere )
+        poses.push_back( renderer.getPoseLookingToCenterFrom(pt) );
+
+    // render and save the views in batches, so only batch_size rendered clouds are held in memory at a time
+    if(batch_size == 0)
+        batch_size = 1;
+
+    std::vector<float> visible;
+    for(size_t start=0; start<poses.size(); start+=batch_size)
+    {
+        const PoseVector batch (poses.begin() + start, poses.begin() + std::min(start + batch_size, poses.size()));
+        std::vector<float> visible_batch;
+        renderAndSaveViews(renderer, batch, model.hasColor(), out_path, gen_organized, visible_batch);
+        visible.insert(visible.end(), visible_batch.begin(), visible_batch.end());
+    }
+
+    if(visualize)
+    {
+        for(size_t i=0; i<poses.size(); i++)
+        {
+            renderer.setCamPose(poses[i]);
+            float visible_tmp;
+            cv::Mat color;
+            cv::Mat depthmap = renderer.renderDepthmap(visible_tmp, color);
+
+            LOG(INFO) << visible[i] << "% visible.";
+            if(model.hasColor())
+                cv::imshow("color", color);
+            cv::imshow("depthmap", depthmap*0.25);
+            cv::waitKey();
+        }
+    }
+}
+
 int main(int argc, const char * argv[])
 {
     std::string input_dir, out_dir;
@@ -92,6 +197,8 @@ int main(int argc, const char * argv[])
     float radius_sphere = 3.f;
     size_t subdivisions = 0;
     bool gen_organized = false;
+    bool software_renderer = false;
+    size_t batch_size = 16;
 
     cloud_prefix_ = "cloud_";
     pose_prefix_ = "pose_";
@@ -113,6 +220,8 @@ int main(int argc, const char * argv[])
             ("cy", po::value<float>(&cy)->default_value(cy, boost::str(boost::format("%.2e") % cy)), "defines the central point of projection in y direction used for rendering")
             ("visualize,v", po::bool_switch(&visualize), "visualize the rendered depth and color map")
             ("generate_organized", po::value<bool>(&gen_organized)->default_value(gen_organized), "if false, removes NaN points from the rendered point cloud")
+            ("software_renderer", po::bool_switch(&software_renderer), "render on the CPU (in parallel) instead of with OpenGL (does not need a display or GPU)")
+            ("batch_size", po::value<size_t>(&batch_size)->default_value(batch_size), "number of views rendered (in parallel with the software renderer) and kept in memory before they are saved")
             ;
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -126,8 +235,20 @@ int main(int argc, const char * argv[])
 
     CHECK( (cx < width) && (cy < height) && (cx > 0) && (cy > 0)) << "Parameters not valid!";
 
-    DepthmapRenderer renderer ( width, height );
-    renderer.setIntrinsics ( fx, fy, cx, cy);
+    boost::shared_ptr<DepthmapRenderer> gl_renderer;
+    boost::shared_ptr<SoftwareDepthmapRenderer> sw_renderer;
+    if(software_renderer)
+    {
+        sw_renderer.reset( new SoftwareDepthmapRenderer ( width, height ) );
+        sw_renderer->setIntrinsics ( fx, fy, cx, cy);
+    }
+    else
+    {
+        gl_renderer.reset( new DepthmapRenderer ( width, height ) );
+        gl_renderer->setIntrinsics ( fx, fy, cx, cy);
+    }
+
+    const std::vector<Eigen::Vector3f> sphere = DepthmapRenderer::createSphere(radius_sphere, subdivisions);
 
     std::vector<std::string> class_names = io::getFoldersInDirectory( input_dir );
     if(class_names.empty())
@@ -147,68 +268,21 @@ int main(int argc, const char * argv[])
             const std::string filename = input_path.string();
 
             DepthmapRendererModel model( filename );
-            renderer.setModel(&model);
-            std::vector<Eigen::Vector3f> sphere = renderer.createSphere(radius_sphere, subdivisions);
 
             LOG(INFO) << "Rendering file " << filename << " ( with color? " << model.hasColor() << ").";    //test if the model has colored elements(note! no textures supported yet.... only colored polygons)z
 
-            for(const Eigen::Vector3f &pt : sphere )
-            {
-                //get a camera pose looking at the center:
-                Eigen::Matrix4f orientation = renderer.getPoseLookingToCenterFrom(pt);
-
-                renderer.setCamPose(orientation);
-                float visible;
-                cv::Mat color;
-                cv::Mat depthmap = renderer.renderDepthmap(visible, color);
-
-                bf::path out_path_bf = out_dir;
-                out_path_bf /= class_name;
-                out_path_bf /= instance_name;
-
-                std::string out_path = out_path_bf.string();
-                size_t lastindex = out_path.find_last_of(".");
-                out_path = out_path.substr(0, lastindex);
-
-                if(model.hasColor())
-                {
-                    pcl::PointCloud<pcl::PointXYZRGB> cloud = renderer.renderPointcloudColor(visible);
-                    if( !gen_organized )
-                        removeNaNPoints(cloud);
-
-                    if( cloud.points.empty())
-                    {
-                        std::cerr << "Rendered cloud does not contain any point! " << std::endl;
-                        continue;
-                    }
-
-                    save (cloud, out_path );
-
-                    if (visualize)
-                        cv::imshow("color", color);
-                }
-                else
-                {
-                    pcl::PointCloud<pcl::PointXYZ> cloud = renderer.renderPointcloud(visible);
-                    if( !gen_organized )
-                        removeNaNPoints(cloud);
-
-                    if( cloud.points.empty())
-                    {
-                        std::cerr << "Rendered cloud does not contain any point! " << std::endl;
-                        continue;
-                    }
-
-                    save ( cloud, out_path );
-                }
-
-                if(visualize)
-                {
-                    LOG(INFO) << visible << "% visible.";
-                    cv::imshow("depthmap", depthmap*0.25);
-                    cv::waitKey();
-                }
-            }
+            bf::path out_path_bf = out_dir;
+            out_path_bf /= class_name;
+            out_path_bf /= instance_name;
+
+            std::string out_path = out_path_bf.string();
+            size_t lastindex = out_path.find_last_of(".");
+            out_path = out_path.substr(0, lastindex);
+
+            if(sw_renderer)
+                renderModel(*sw_renderer, model, sphere, out_path, gen_organized, visualize, batch_size);
+            else
+                renderModel(*gl_renderer, model, sphere, out_path, gen_organized, visualize, batch_size);
         }
     }
 